@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <env.h>
+#if defined TT_SRP
+#	include <kernel_srp.h>
+#else
+#	include <kernel.h>
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/*
+ * Semi private internal but used in the header file.
+ */
+int bench_protected;
+int bench_timer_armed;
+env_time_t bench_timer;
+env_time_t bench_now;
+
+#if ! defined TT_SRP
+
+static char bench_stack[ENV_NUM_THREADS][ENV_STACKSIZE]
+	__attribute__((aligned(16)));
+static int bench_num_stacks;
+
+#if defined __x86_64__
+
+void bench_switch(void **, void *);
+
+/*
+ * Save the callee saved registers on the current stack, store the stack
+ * pointer and continue on the other stack. Everything else is saved by the
+ * caller of bench_switch() as for any function call.
+ */
+__asm__(
+		"	.pushsection .text\n"
+		"	.globl bench_switch\n"
+		"	.type bench_switch, @function\n"
+		"bench_switch:\n"
+		"	pushq %rbp\n"
+		"	pushq %rbx\n"
+		"	pushq %r12\n"
+		"	pushq %r13\n"
+		"	pushq %r14\n"
+		"	pushq %r15\n"
+		"	movq %rsp, (%rdi)\n"
+		"	movq %rsi, %rsp\n"
+		"	popq %r15\n"
+		"	popq %r14\n"
+		"	popq %r13\n"
+		"	popq %r12\n"
+		"	popq %rbx\n"
+		"	popq %rbp\n"
+		"	ret\n"
+		"	.size bench_switch, .-bench_switch\n"
+		"	.popsection\n"
+		);
+
+#endif /* __x86_64__ */
+
+#endif /* ! TT_SRP */
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench init function.
+ *
+ * The kernel starts out protected at virtual time zero.
+ */
+void bench_init(void)
+{
+	bench_protected = 1;
+	bench_timer_armed = 0;
+	bench_now = 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench panic function.
+ *
+ * \param msg The message to print before aborting.
+ */
+void bench_panic(const char * const msg)
+{
+	fprintf(stderr, "%s", msg);
+	abort();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench expire function.
+ *
+ * Moves the virtual time forward to now (never backwards) and releases the
+ * messages that are due, the kernel timer interrupt without the scheduling.
+ *
+ * \param now The virtual time of the interrupt.
+ */
+void bench_expire(env_time_t now)
+{
+	if (ENV_TIME_LT(bench_now, now)) {
+		bench_now = now;
+	}
+	bench_timer_armed = 0;
+	tt_expired(bench_now);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench advance function.
+ *
+ * Runs every message that is active, then fires the virtual timer for each
+ * expiry up to and including until and runs what it released. The virtual
+ * time does not move while the messages run.
+ *
+ * \param until The virtual time to advance to.
+ */
+void bench_advance(env_time_t until)
+{
+	for (;;) {
+		tt_schedule();
+		if (!bench_timer_armed || ENV_TIME_LT(until, bench_timer)) {
+			break;
+		}
+		bench_expire(bench_timer);
+	}
+
+	if (ENV_TIME_LT(bench_now, until)) {
+		bench_now = until;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench idle function.
+ *
+ * Runs the messages that are left in virtual time and returns once there is
+ * nothing more to do, there is nothing else that could wake the kernel.
+ */
+void bench_idle(void)
+{
+	do {
+		bench_advance(bench_timer_armed ? bench_timer : bench_now);
+	} while (bench_timer_armed);
+}
+
+#if ! defined TT_SRP
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench context init function.
+ *
+ * \param context The context to initialize.
+ * \param function The function the context starts in, must never return.
+ */
+void bench_context_init(env_context_t *context, void (*function)(void))
+{
+	char *stack;
+
+	if (bench_num_stacks >= ENV_NUM_THREADS) {
+		bench_panic("bench_context_init(): Out of stacks.\n");
+	}
+	stack = bench_stack[bench_num_stacks++];
+
+#if defined __x86_64__
+	{
+		/*
+		 * The frame bench_switch() pops: six registers and the return
+		 * address, followed by a (never used) return address for the
+		 * function so that it starts with the stack aligned as after
+		 * a call.
+		 */
+		void **sp = (void **)(
+				(uintptr_t)(stack + ENV_STACKSIZE) & ~(uintptr_t)15
+				) - 8;
+
+		memset(sp, 0, 8*sizeof(void *));
+		sp[6] = (void *)function;
+		context->sp = sp;
+	}
+#else
+	if (getcontext(&context->uc)) {
+		bench_panic("bench_context_init(): Unable to get context.\n");
+	}
+	context->uc.uc_stack.ss_sp = stack;
+	context->uc.uc_stack.ss_size = ENV_STACKSIZE;
+	context->uc.uc_link = NULL;
+	makecontext(&context->uc, function, 0);
+#endif
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench dispatch function.
+ *
+ * \param thread The thread to dispatch.
+ */
+void bench_context_dispatch(tt_thread_t *thread)
+{
+	tt_thread_t *prev = tt_current;
+
+	if (thread == prev) {
+		return;
+	}
+
+	tt_current = thread;
+#if defined __x86_64__
+	bench_switch(&prev->context.sp, thread->context.sp);
+#else
+	if (swapcontext(&prev->context.uc, &thread->context.uc)) {
+		bench_panic("bench_context_dispatch(): Unable to swap context.\n");
+	}
+#endif
+}
+
+#endif /* ! TT_SRP */
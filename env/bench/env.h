@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \brief Host benchmark environment.
+ *
+ * Runs the kernel on the host without threads, signals or timers, so that
+ * the cost of the kernel itself (queues, expiry, scheduling, cancel) can be
+ * measured with the cycle counter and without noise from the operating
+ * system. Time is virtual and only moves when the application calls
+ * bench_expire() or bench_advance(), protection is a flag and the threads of
+ * the regular kernel are switched at user level. Both the regular and the
+ * SRP kernel (SRP=yes) are supported.
+ *
+ * The startup function runs in the idle context, protected just like an
+ * interrupt handler, and drives the kernel directly:
+ *
+ *	TT_AFTER(ENV_USEC(10), &obj, meth, TT_ARGS_NONE);
+ *	t0 = ENV_CYCLES();
+ *	bench_advance(ENV_USEC(10));
+ *	t1 = ENV_CYCLES();
+ *
+ * Once it returns, ENV_IDLE() runs the remaining messages in virtual time
+ * and returns when there is nothing left to do.
+ */
+#ifndef ENV_BENCH_ENV_H_
+#define ENV_BENCH_ENV_H_
+
+/* Standard C headers. */
+#include <stdio.h>
+#include <stddef.h>
+#include <time.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+void bench_init(void);
+void bench_panic(const char * const);
+void bench_idle(void);
+void bench_expire(env_time_t);
+void bench_advance(env_time_t);
+#if ! defined TT_SRP
+void bench_context_init(env_context_t *, void (*)(void));
+void bench_context_dispatch(tt_thread_t *);
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_SRP
+/**
+ * \brief The environment runs the SRP kernel.
+ */
+#	define ENV_SRP 1
+#endif
+
+/* ************************************************************************** */
+
+#define ENV_INLINE inline
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment init macro.
+ */
+#define ENV_INIT() \
+	bench_init()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment debug macro.
+ */
+#define ENV_DEBUG(msg) \
+	fprintf(stderr, "%s", msg)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment panic macro.
+ *
+ * Will print the msg and call abort().
+ */
+#define ENV_PANIC(msg) \
+	bench_panic(msg)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment protect macro.
+ *
+ * Nothing can interrupt the kernel, only the flag is kept for the sake of
+ * ENV_ISPROTECTED().
+ */
+#define ENV_PROTECT(state) \
+	bench_protect(state)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment isprotected macro.
+ */
+#define ENV_ISPROTECTED() \
+	bench_isprotected()
+
+/* ************************************************************************** */
+
+#if ! defined TT_SRP
+
+/**
+ * \brief Environment context behaviour macro.
+ *
+ * There are no real interrupts, the kernel dispatches from tt_schedule().
+ */
+#	define ENV_CONTEXT_NOT_SAVED 1
+
+#	ifndef ENV_NUM_THREADS
+	/**
+	 * \brief The number of threads of this environment.
+	 */
+#		define ENV_NUM_THREADS 4
+#	endif
+
+#	ifndef ENV_STACKSIZE
+	/**
+	 * \brief The stack size of each thread.
+	 */
+#		define ENV_STACKSIZE 16384
+#	endif
+
+/**
+ * \brief Environment context init macro.
+ */
+#	define ENV_CONTEXT_INIT(context, stacksize, function) \
+		bench_context_init(context, function)
+
+/**
+ * \brief Environment context dispatch macro.
+ *
+ * Switches the stack at user level, no system call involved.
+ */
+#	define ENV_CONTEXT_DISPATCH(thread) \
+		bench_context_dispatch((thread))
+
+#endif /* ! TT_SRP */
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment idle macro.
+ */
+#define ENV_IDLE() \
+	bench_idle()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer start macro.
+ */
+#define ENV_TIMER_START() \
+	((void)0)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer set macro.
+ *
+ * Arms the virtual timer, it fires when the virtual time passes it.
+ */
+#define ENV_TIMER_SET(time) \
+	bench_timer_set(time)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer get macro.
+ */
+#define ENV_TIMER_GET() \
+	bench_timer_get()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timestamp macro.
+ *
+ * The virtual time stands still between interrupts, so the timestamp of
+ * the most recent one is the current time.
+ */
+#define ENV_TIMESTAMP() \
+	bench_timer_get()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment time in nanoseconds, used by the kernel trace.
+ */
+#define ENV_TRACE_NSEC(time) \
+	((unsigned long long)(time))
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment cycle counter macro.
+ *
+ * Not part of the kernel interface, used by the benchmarks to time the
+ * kernel.
+ */
+#define ENV_CYCLES() \
+	bench_cycles()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer usec macro, the virtual time is in nanoseconds.
+ */
+#define ENV_USEC(val) \
+	((env_time_t)(val)*1000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer msec macro.
+ */
+#define ENV_MSEC(val) \
+	((env_time_t)(val)*1000000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer sec macro.
+ */
+#define ENV_SEC(val) \
+	((env_time_t)(val)*1000000000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief The bench startup macro.
+ */
+#define ENV_STARTUP(function) \
+int main(void)\
+{\
+	tt_init();\
+	function();\
+	tt_run();\
+	return 0;\
+} extern char dummy /* Force semi-colon at end of macro. */
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench protect function.
+ *
+ * \param state If we should enter protected mode.
+ */
+static inline void bench_protect(int state)
+{
+	extern int bench_protected;
+	bench_protected = state;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench isprotected function.
+ *
+ * \return non-zero if protected, otherwise zero.
+ */
+static inline int bench_isprotected(void)
+{
+	extern int bench_protected;
+	return bench_protected;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench timer set function.
+ *
+ * \param time The virtual time when tt_expired() should be called.
+ */
+static inline void bench_timer_set(env_time_t time)
+{
+	extern env_time_t bench_timer;
+	extern int bench_timer_armed;
+	bench_timer = time;
+	bench_timer_armed = 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench timer get function.
+ *
+ * \return The virtual time.
+ */
+static inline env_time_t bench_timer_get(void)
+{
+	extern env_time_t bench_now;
+	return bench_now;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench cycle counter.
+ *
+ * \return The time stamp counter, or nanoseconds where there is none.
+ */
+static inline unsigned long long bench_cycles(void)
+{
+#if defined __x86_64__ || defined __i386__
+	unsigned int lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((unsigned long long)hi << 32) | lo;
+#elif defined __aarch64__
+	unsigned long long tmp;
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (tmp));
+	return tmp;
+#else
+	struct timespec tmp;
+	clock_gettime(CLOCK_MONOTONIC, &tmp);
+	return tmp.tv_sec*1000000000ULL + tmp.tv_nsec;
+#endif
+}
+
+#endif
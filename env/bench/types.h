@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_BENCH_TYPES_H_
+#define ENV_BENCH_TYPES_H_
+
+/* Standard C headers. */
+#include <stdint.h>
+
+#if ! defined __x86_64__
+#	include <ucontext.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief Typedef so that TinyTimber knows what a result is.
+ */
+typedef uintptr_t env_result_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief Bench context.
+ *
+ * The contexts are switched at user level, on x86-64 by a small assembler
+ * routine that only saves the callee saved registers and elsewhere by
+ * swapcontext().
+ */
+typedef struct env_context_t
+{
+#if defined __x86_64__
+	/**
+	 * \brief The saved stack pointer.
+	 */
+	void *sp;
+#else
+	/**
+	 * \brief The saved user context.
+	 */
+	ucontext_t uc;
+#endif
+} env_context_t;
+
+#endif
@@ -54,6 +54,10 @@
 #		include "m16c/env.h"
 #	elif defined ENV_M16C_SRP
 #		include "m16c_srp/env.h"
+#	elif defined ENV_BENCH
+#		include "bench/env.h"
+#	elif defined ENV_SIM
+#		include "sim/env.h"
 #	elif defined ENV_SKEL
 #		include "skel/env.h"
 #	else
@@ -0,0 +1,726 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX asynchronous I/O.
+ *
+ * Methods must never block, with ENV_NUM_THREADS threads there is nothing
+ * else to run while a read()/write() waits for the disk. Instead requests
+ * are handed to io_uring (or a small pool of helper threads if io_uring
+ * is not available) and the completion is delivered as a message to the
+ * requesting object. Completions are batched and posted from a single
+ * pseudo interrupt per batch, at most POSIX_AIO_BATCH at a time so that
+ * a burst of completions can not use up the message pool.
+ */
+
+/* Standard C headers. */
+#include <errno.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* POSIX/UNIX headers. */
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#if defined __linux__ && ! defined POSIX_AIO_NO_URING
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <linux/io_uring.h>
+#	define POSIX_AIO_URING 1
+#endif
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/aio.h>
+#include <posix/rt.h>
+
+/* tinyTimber headers. */
+#include <kernel.h>
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX aio number of submission queue entries.
+ */
+#ifndef POSIX_AIO_ENTRIES
+#	define POSIX_AIO_ENTRIES 64
+#endif
+
+/**
+ * \brief POSIX aio number of completions posted per interrupt.
+ *
+ * The rest is left for the next interrupt, the messages of the previous
+ * batch have had a chance to run by then.
+ */
+#ifndef POSIX_AIO_BATCH
+#	define POSIX_AIO_BATCH ((TT_NUM_MESSAGES + 1)/2)
+#endif
+
+/* ************************************************************************** */
+
+/*
+ * Internal state variables etc.
+ */
+static int aio_interrupt;
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_signal = PTHREAD_COND_INITIALIZER;
+static int done_pending;
+static posix_aio_t *done_head;
+static posix_aio_t *done_tail;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_signal = PTHREAD_COND_INITIALIZER;
+static posix_aio_t *pool_head;
+static posix_aio_t *pool_tail;
+
+#ifdef POSIX_AIO_URING
+
+/*
+ * The io_uring rings, mapped from the kernel.
+ */
+static struct
+{
+	int fd;
+	pthread_mutex_t lock;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_entries;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+} uring = {.fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER};
+
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio block signals.
+ *
+ * None of the helper threads may ever receive the interrupt or timer
+ * signals.
+ */
+static void aio_block_signals(void)
+{
+	sigset_t block;
+
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("aio_block_signals(): Unable to set sigmask.\n");
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio queue a list of completed requests.
+ *
+ * The notify thread generates the completion interrupt.
+ *
+ * \param first The first completed request.
+ * \param last The last completed request.
+ */
+static void aio_done(posix_aio_t *first, posix_aio_t *last)
+{
+	last->next = NULL;
+
+	if (pthread_mutex_lock(&done_lock)) {
+		posix_panic("aio_done(): Unable to aquire done lock.\n");
+	}
+
+	if (done_head) {
+		done_tail->next = first;
+	} else {
+		done_head = first;
+	}
+	done_tail = last;
+
+	if (pthread_cond_signal(&done_signal)) {
+		posix_panic("aio_done(): Unable to signal notify thread.\n");
+	}
+	if (pthread_mutex_unlock(&done_lock)) {
+		posix_panic("aio_done(): Unable to release done lock.\n");
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio notify thread.
+ *
+ * Generates the completion interrupt whenever there are completed requests
+ * and no interrupt is pending, also for the requests left over by a
+ * previous interrupt.
+ */
+static void *aio_notify(void *data)
+{
+	aio_block_signals();
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (pthread_mutex_lock(&done_lock)) {
+			posix_panic("aio_notify(): Unable to aquire done lock.\n");
+		}
+		while (!done_head || done_pending) {
+			if (pthread_cond_wait(&done_signal, &done_lock)) {
+				posix_panic("aio_notify(): Unable to wait for completions.\n");
+			}
+		}
+		done_pending = 1;
+		if (pthread_mutex_unlock(&done_lock)) {
+			posix_panic("aio_notify(): Unable to release done lock.\n");
+		}
+
+		posix_ext_interrupt_generate(aio_interrupt);
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio completion interrupt handler.
+ *
+ * Posts one message for each completed request, at most POSIX_AIO_BATCH.
+ */
+static void aio_interrupt_handler(int id)
+{
+	int n;
+	posix_aio_t *req, *next;
+
+	if (pthread_mutex_lock(&done_lock)) {
+		posix_panic("aio_interrupt_handler(): Unable to aquire done lock.\n");
+	}
+
+	req = done_head;
+	for (n=1;n<POSIX_AIO_BATCH && done_head;n++) {
+		done_head = done_head->next;
+	}
+	if (done_head) {
+		next = done_head->next;
+		done_head->next = NULL;
+		done_head = next;
+	}
+	if (!done_head) {
+		done_tail = NULL;
+	}
+	done_pending = 0;
+
+	if (pthread_cond_signal(&done_signal)) {
+		posix_panic("aio_interrupt_handler(): Unable to signal notify thread.\n");
+	}
+	if (pthread_mutex_unlock(&done_lock)) {
+		posix_panic("aio_interrupt_handler(): Unable to release done lock.\n");
+	}
+
+	for (;req;req = next) {
+		next = req->next;
+		TT_BEFORE(req->deadline, req->to, req->method, &req);
+	}
+
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio helper thread.
+ *
+ * Performs the requests in blocking mode, used when io_uring is not
+ * available or the submission queue is full.
+ */
+static void *aio_worker(void *data)
+{
+	posix_aio_t *req;
+
+	aio_block_signals();
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (pthread_mutex_lock(&pool_lock)) {
+			posix_panic("aio_worker(): Unable to aquire pool lock.\n");
+		}
+		while (!pool_head) {
+			if (pthread_cond_wait(&pool_signal, &pool_lock)) {
+				posix_panic("aio_worker(): Unable to wait for requests.\n");
+			}
+		}
+		req = pool_head;
+		pool_head = req->next;
+		if (pthread_mutex_unlock(&pool_lock)) {
+			posix_panic("aio_worker(): Unable to release pool lock.\n");
+		}
+
+		if (req->op == POSIX_AIO_READ) {
+			req->result = pread(req->fd, req->buf, req->size, req->offset);
+		} else {
+			req->result = pwrite(req->fd, req->buf, req->size, req->offset);
+		}
+		if (req->result < 0) {
+			req->result = -errno;
+		}
+
+		aio_done(req, req);
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio hand a request to the helper threads.
+ *
+ * Must be called in protected mode.
+ *
+ * \param req The request.
+ */
+static void aio_pool_submit(posix_aio_t *req)
+{
+	req->next = NULL;
+
+	if (pthread_mutex_lock(&pool_lock)) {
+		posix_panic("aio_pool_submit(): Unable to aquire pool lock.\n");
+	}
+
+	if (pool_head) {
+		pool_tail->next = req;
+	} else {
+		pool_head = req;
+	}
+	pool_tail = req;
+
+	if (pthread_cond_signal(&pool_signal)) {
+		posix_panic("aio_pool_submit(): Unable to signal helper thread.\n");
+	}
+	if (pthread_mutex_unlock(&pool_lock)) {
+		posix_panic("aio_pool_submit(): Unable to release pool lock.\n");
+	}
+}
+
+#ifdef POSIX_AIO_URING
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio io_uring completion thread.
+ *
+ * Waits for completions and hands them to the kernel one batch at a time.
+ */
+static void *aio_uring_thread(void *data)
+{
+	unsigned head, tail;
+	struct io_uring_cqe *cqe;
+	posix_aio_t *first, *last, *req;
+
+	aio_block_signals();
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (
+			syscall(
+				__NR_io_uring_enter,
+				uring.fd,
+				0,
+				1,
+				IORING_ENTER_GETEVENTS,
+				NULL,
+				0
+				) < 0 &&
+			errno != EINTR
+			) {
+			posix_panic("aio_uring_thread(): Unable to wait for completions.\n");
+		}
+
+		first = last = NULL;
+		head = *uring.cq_head;
+		tail = __atomic_load_n(uring.cq_tail, __ATOMIC_ACQUIRE);
+		while (head != tail) {
+			cqe = &uring.cqes[head & *uring.cq_mask];
+			req = (posix_aio_t *)(uintptr_t)cqe->user_data;
+			req->result = cqe->res;
+			if (last) {
+				last->next = req;
+			} else {
+				first = req;
+			}
+			last = req;
+			head++;
+		}
+		__atomic_store_n(uring.cq_head, head, __ATOMIC_RELEASE);
+
+		if (first) {
+			aio_done(first, last);
+		}
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio io_uring setup.
+ *
+ * \return zero upon success, non-zero if io_uring is not available.
+ */
+static int aio_uring_init(void)
+{
+	char *sq, *cq;
+	size_t sq_size, cq_size;
+	struct io_uring_params params;
+	pthread_t thread;
+
+	memset(&params, 0, sizeof(params));
+	uring.fd = syscall(__NR_io_uring_setup, POSIX_AIO_ENTRIES, &params);
+	if (uring.fd < 0) {
+		return 1;
+	}
+
+	sq_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+	cq_size = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (cq_size > sq_size) {
+			sq_size = cq_size;
+		}
+	}
+
+	sq = mmap(
+			NULL,
+			sq_size,
+			PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE,
+			uring.fd,
+			IORING_OFF_SQ_RING
+			);
+	if (sq == MAP_FAILED) {
+		goto fail;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cq = sq;
+	} else {
+		cq = mmap(
+				NULL,
+				cq_size,
+				PROT_READ|PROT_WRITE,
+				MAP_SHARED|MAP_POPULATE,
+				uring.fd,
+				IORING_OFF_CQ_RING
+				);
+		if (cq == MAP_FAILED) {
+			goto fail;
+		}
+	}
+
+	uring.sqes = mmap(
+			NULL,
+			params.sq_entries*sizeof(struct io_uring_sqe),
+			PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE,
+			uring.fd,
+			IORING_OFF_SQES
+			);
+	if (uring.sqes == MAP_FAILED) {
+		goto fail;
+	}
+
+	uring.sq_head = (unsigned *)(sq + params.sq_off.head);
+	uring.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	uring.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+	uring.sq_entries = (unsigned *)(sq + params.sq_off.ring_entries);
+	uring.sq_array = (unsigned *)(sq + params.sq_off.array);
+	uring.cq_head = (unsigned *)(cq + params.cq_off.head);
+	uring.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	uring.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+	uring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	if (pthread_create(&thread, NULL, aio_uring_thread, NULL)) {
+		posix_panic("aio_uring_init(): Unable to create completion thread.\n");
+	}
+
+	return 0;
+
+fail:
+	/* The mappings go away with the process, just forget about them. */
+	close(uring.fd);
+	uring.fd = -1;
+	return 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio io_uring submit.
+ *
+ * Must be called in protected mode.
+ *
+ * \param req The request to submit.
+ * \return zero upon success, non-zero if the submission queue was full.
+ */
+static int aio_uring_submit(posix_aio_t *req)
+{
+	long submitted;
+	unsigned head, tail, index;
+	struct io_uring_sqe *sqe;
+
+	if (pthread_mutex_lock(&uring.lock)) {
+		posix_panic("aio_uring_submit(): Unable to aquire uring lock.\n");
+	}
+
+	head = __atomic_load_n(uring.sq_head, __ATOMIC_ACQUIRE);
+	tail = *uring.sq_tail;
+	if (tail - head >= *uring.sq_entries) {
+		if (pthread_mutex_unlock(&uring.lock)) {
+			posix_panic("aio_uring_submit(): Unable to release uring lock.\n");
+		}
+		return 1;
+	}
+
+	index = tail & *uring.sq_mask;
+	sqe = &uring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	if (req->index < 0) {
+		sqe->opcode = req->op == POSIX_AIO_READ ?
+			IORING_OP_READ : IORING_OP_WRITE;
+	} else {
+		sqe->opcode = req->op == POSIX_AIO_READ ?
+			IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+		sqe->buf_index = req->index;
+	}
+	sqe->fd = req->fd;
+	sqe->addr = (uintptr_t)req->buf;
+	sqe->len = req->size;
+	sqe->off = req->offset;
+	sqe->user_data = (uintptr_t)req;
+	uring.sq_array[index] = index;
+
+	tail++;
+	__atomic_store_n(uring.sq_tail, tail, __ATOMIC_RELEASE);
+
+	/*
+	 * Submit every entry the kernel has not consumed yet, entries left
+	 * behind by an earlier EAGAIN/EBUSY go with this one.
+	 */
+	for (;;) {
+		head = __atomic_load_n(uring.sq_head, __ATOMIC_ACQUIRE);
+		if (head == tail) {
+			break;
+		}
+		submitted = syscall(
+				__NR_io_uring_enter,
+				uring.fd,
+				tail - head,
+				0,
+				0,
+				NULL,
+				0
+				);
+		if (submitted > 0 || (submitted < 0 && errno == EINTR)) {
+			continue;
+		}
+		if (submitted < 0 && errno != EAGAIN && errno != EBUSY) {
+			posix_panic("aio_uring_submit(): Unable to submit request.\n");
+		}
+		break;
+	}
+
+	if (pthread_mutex_unlock(&uring.lock)) {
+		posix_panic("aio_uring_submit(): Unable to release uring lock.\n");
+	}
+
+	return 0;
+}
+
+#endif
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio init function.
+ *
+ * Should be called from the startup function, before any requests are
+ * submitted.
+ *
+ * \note
+ *	Upon failure posix_panic() will be called.
+ *
+ * \param interrupt The interrupt id used for completions.
+ * \param threads The number of helper threads, at least one is created.
+ */
+void posix_aio_init(int interrupt, int threads)
+{
+	int i;
+	pthread_t thread;
+
+	assert(interrupt > 0);
+
+	aio_interrupt = interrupt;
+	posix_ext_interrupt_handler(interrupt, aio_interrupt_handler);
+
+	if (pthread_create(&thread, NULL, aio_notify, NULL)) {
+		posix_panic("posix_aio_init(): Unable to create notify thread.\n");
+	}
+
+#ifdef POSIX_AIO_URING
+	aio_uring_init();
+#endif
+
+	if (threads < 1) {
+		threads = 1;
+	}
+	for (i=0;i<threads;i++) {
+		if (pthread_create(&thread, NULL, aio_worker, NULL)) {
+			posix_panic("posix_aio_init(): Unable to create helper thread.\n");
+		}
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio register buffers.
+ *
+ * Registers buffers with the kernel so that requests using them avoid the
+ * per request page pinning (zero-copy). Requests refer to them through
+ * posix_aio_t::index. Without io_uring this is a no-op.
+ *
+ * \param bufs The buffers.
+ * \param sizes The size of each buffer.
+ * \param num The number of buffers.
+ * \return zero upon success, otherwise -errno.
+ */
+int posix_aio_register(void **bufs, const size_t *sizes, int num)
+{
+#ifdef POSIX_AIO_URING
+	int i, result = 0;
+	struct iovec *iov;
+
+	if (uring.fd < 0) {
+		return 0;
+	}
+
+	iov = calloc(num, sizeof(*iov));
+	if (!iov) {
+		return -ENOMEM;
+	}
+	for (i=0;i<num;i++) {
+		iov[i].iov_base = bufs[i];
+		iov[i].iov_len = sizes[i];
+	}
+
+	if (
+		syscall(
+			__NR_io_uring_register,
+			uring.fd,
+			IORING_REGISTER_BUFFERS,
+			iov,
+			num
+			) < 0
+		) {
+		result = -errno;
+	}
+
+	free(iov);
+	return result;
+#else
+	return 0;
+#endif
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio submit a request.
+ *
+ * May be called from a method or an interrupt handler, never blocks on
+ * the I/O itself. The submission locks are only held protected.
+ *
+ * \param req The request.
+ * \return zero upon success, non-zero upon failure.
+ */
+int posix_aio_submit(posix_aio_t *req)
+{
+	int protected = ENV_ISPROTECTED();
+
+	assert(req);
+	assert(req->to);
+	assert(req->method);
+
+	if (req->op != POSIX_AIO_READ && req->op != POSIX_AIO_WRITE) {
+		return 1;
+	}
+
+	/* Not to be preempted while holding the submission locks. */
+	ENV_PROTECT(1);
+
+#ifdef POSIX_AIO_URING
+	if (uring.fd >= 0 && !aio_uring_submit(req)) {
+		ENV_PROTECT(protected);
+		return 0;
+	}
+#endif
+
+	/* No io_uring or the submission queue is full. */
+	aio_pool_submit(req);
+	ENV_PROTECT(protected);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX aio io_uring check.
+ *
+ * \return non-zero if requests are submitted through io_uring.
+ */
+int posix_aio_uring(void)
+{
+#ifdef POSIX_AIO_URING
+	return uring.fd >= 0;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_AIO_H_
+#define ENV_POSIX_AIO_H_
+
+/* Standard C headers. */
+#include <stddef.h>
+
+/* POSIX/UNIX headers. */
+#include <sys/types.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX asynchronous I/O operations.
+ */
+enum
+{
+	/**
+	 * \brief Read size bytes at offset into buf.
+	 */
+	POSIX_AIO_READ,
+
+	/**
+	 * \brief Write size bytes from buf at offset.
+	 */
+	POSIX_AIO_WRITE
+};
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX asynchronous I/O request.
+ *
+ * Filled in by the user and handed to posix_aio_submit(). Once the
+ * operation is done the method is invoked upon the object with a pointer to
+ * a pointer to the request as argument (the argument buffer holds the
+ * request pointer). The request must stay valid until then.
+ */
+typedef struct posix_aio_t
+{
+	/**
+	 * \brief The operation, POSIX_AIO_READ or POSIX_AIO_WRITE.
+	 */
+	int op;
+
+	/**
+	 * \brief The file descriptor to operate on.
+	 */
+	int fd;
+
+	/**
+	 * \brief The buffer to read into or write from.
+	 */
+	void *buf;
+
+	/**
+	 * \brief The number of bytes to transfer.
+	 */
+	size_t size;
+
+	/**
+	 * \brief The file offset of the transfer.
+	 */
+	off_t offset;
+
+	/**
+	 * \brief Registered buffer index, negative if buf is not registered.
+	 *
+	 * When non-negative buf must lie within the registered buffer with
+	 * the same index (see posix_aio_register()).
+	 */
+	int index;
+
+	/**
+	 * \brief The object to deliver the completion to.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method to invoke upon completion.
+	 */
+	tt_method_t method;
+
+	/**
+	 * \brief Deadline of the completion message.
+	 *
+	 * Relative to the time of completion, same semantic as TT_BEFORE().
+	 */
+	env_time_t deadline;
+
+	/**
+	 * \brief The result, number of bytes transferred or -errno.
+	 */
+	ssize_t result;
+
+	/**
+	 * \brief Next request, used internally.
+	 */
+	struct posix_aio_t *next;
+} posix_aio_t;
+
+/* ************************************************************************** */
+
+void posix_aio_init(int, int);
+int  posix_aio_register(void **, const size_t *, int);
+int  posix_aio_submit(posix_aio_t *);
+int  posix_aio_uring(void);
+
+#endif
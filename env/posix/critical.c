@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX critical section profiler.
+ *
+ * Enabled by defining POSIX_CRITICAL (make CRITICAL=yes). The interrupt
+ * latency of the kernel is bounded by its longest protected section, from
+ * ENV_PROTECT(1) disabling the interrupts to the ENV_PROTECT(0) enabling
+ * them again. The section is not bound to a thread, the kernel may dispatch
+ * another thread that leaves it, so each section is keyed on the pair of
+ * call sites that entered and left it. The duration of each pair is kept in
+ * a histogram, in cycles of the time stamp counter where there is one and
+ * nanoseconds otherwise.
+ *
+ * Acquiring the kernel_lock to enter protected mode, or to raise an
+ * interrupt, first tries without blocking. The times it has to wait are
+ * counted as contended, with the waiting time in a histogram of its own.
+ * The lock taken back by a thread that is dispatched again is not counted.
+ *
+ * The report is written at exit to the file named by POSIX_CRITICAL_REPORT,
+ * or stderr, the pairs with the longest section first.
+ */
+
+/* Standard C headers. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX/UNIX headers. */
+#include <time.h>
+#include <pthread.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/critical.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+#include <stats.h>
+
+#if defined POSIX_CRITICAL
+
+#if (POSIX_CRITICAL_SITES & (POSIX_CRITICAL_SITES - 1))
+#	error POSIX_CRITICAL_SITES must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX critical section call site pair.
+ */
+typedef struct critical_site_t
+{
+	const char *enter_file;
+	int enter_line;
+	const char *leave_file;
+	int leave_line;
+	tt_histogram_t duration;
+} critical_site_t;
+
+/*
+ * Internal state variables etc, written with the kernel_lock held.
+ */
+static critical_site_t critical_site[POSIX_CRITICAL_SITES + 1];
+static tt_histogram_t critical_wait;
+static unsigned long critical_acquired;
+static unsigned long critical_contended;
+static const char *critical_file;
+static int critical_line;
+static unsigned long long critical_start;
+static int critical_started;
+static unsigned long long critical_first_cycles;
+static unsigned long long critical_first_nsec;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section monotonic time in nanoseconds.
+ */
+static unsigned long long critical_nsec(void)
+{
+	struct timespec tmp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tmp);
+	return tmp.tv_sec*1000000000ULL + tmp.tv_nsec;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section cycle counter.
+ *
+ * \return The time stamp counter, or nanoseconds where there is none.
+ */
+static inline unsigned long long critical_cycles(void)
+{
+#if defined __x86_64__ || defined __i386__
+	unsigned int lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((unsigned long long)hi << 32) | lo;
+#elif defined __aarch64__
+	unsigned long long tmp;
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (tmp));
+	return tmp;
+#else
+	return critical_nsec();
+#endif
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section call site pair lookup.
+ *
+ * \return The entry of the pair, the overflow entry when the table is full.
+ */
+static critical_site_t *critical_lookup(
+		const char *enter_file,
+		int enter_line,
+		const char *leave_file,
+		int leave_line
+		)
+{
+	int i, n;
+	critical_site_t *site;
+
+	i = (int)(
+			(((size_t)enter_file >> 3) ^ (size_t)enter_line * 31 ^
+			 ((size_t)leave_file >> 5) ^ (size_t)leave_line * 17) &
+			(POSIX_CRITICAL_SITES - 1)
+			);
+	for (n=0;n<POSIX_CRITICAL_SITES;n++) {
+		site = &critical_site[(i + n) & (POSIX_CRITICAL_SITES - 1)];
+		if (
+				site->enter_file == enter_file &&
+				site->enter_line == enter_line &&
+				site->leave_file == leave_file &&
+				site->leave_line == leave_line
+		   ) {
+			return site;
+		}
+		if (!site->enter_file) {
+			site->enter_file = enter_file;
+			site->enter_line = enter_line;
+			site->leave_file = leave_file;
+			site->leave_line = leave_line;
+			return site;
+		}
+	}
+
+	/* Table is full, account to the overflow entry. */
+	return &critical_site[POSIX_CRITICAL_SITES];
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section file name without the directories.
+ */
+static const char *critical_basename(const char *file)
+{
+	const char *tmp;
+
+	if (!file) {
+		return "?";
+	}
+	tmp = strrchr(file, '/');
+	return tmp ? tmp + 1 : file;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section histogram print.
+ */
+static void critical_print(
+		FILE *file,
+		const char *name,
+		tt_histogram_t *histogram
+		)
+{
+	fprintf(
+			file,
+			"%s count=%lu"
+			" min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			name,
+			histogram->total,
+			histogram->min,
+			tt_histogram_mean(histogram),
+			tt_histogram_percentile(histogram, 500),
+			tt_histogram_percentile(histogram, 900),
+			tt_histogram_percentile(histogram, 990),
+			tt_histogram_percentile(histogram, 999),
+			histogram->max
+			);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section pair order, the longest section first.
+ */
+static int critical_compare(const void *a, const void *b)
+{
+	const critical_site_t *x = *(const critical_site_t * const *)a;
+	const critical_site_t *y = *(const critical_site_t * const *)b;
+
+	if (x->duration.max != y->duration.max) {
+		return x->duration.max < y->duration.max ? 1 : -1;
+	}
+	return 0;
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section enter.
+ *
+ * Called by posix_protect() with the kernel_lock held, when the interrupts
+ * have just been disabled.
+ *
+ * \param file The file of the call site.
+ * \param line The line of the call site.
+ */
+void posix_critical_enter(const char *file, int line)
+{
+	critical_file = file;
+	critical_line = line;
+	critical_start = critical_cycles();
+
+	if (!critical_started) {
+		critical_first_cycles = critical_start;
+		critical_first_nsec = critical_nsec();
+		critical_started = 1;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section leave.
+ *
+ * Called by posix_protect() with the kernel_lock held, right before the
+ * interrupts are enabled again.
+ *
+ * \param file The file of the call site.
+ * \param line The line of the call site.
+ */
+void posix_critical_leave(const char *file, int line)
+{
+	unsigned long long duration = critical_cycles() - critical_start;
+
+	tt_histogram_add(
+			&critical_lookup(critical_file, critical_line, file, line)->duration,
+			(unsigned long)duration
+			);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section kernel_lock acquire.
+ *
+ * \param lock The kernel_lock.
+ * \return Zero on success, as pthread_mutex_lock().
+ */
+int posix_critical_lock(pthread_mutex_t *lock)
+{
+	int result;
+	unsigned long long start;
+
+	if (!pthread_mutex_trylock(lock)) {
+		critical_acquired++;
+		return 0;
+	}
+
+	start = critical_cycles();
+	result = pthread_mutex_lock(lock);
+	if (!result) {
+		critical_acquired++;
+		critical_contended++;
+		tt_histogram_add(
+				&critical_wait,
+				(unsigned long)(critical_cycles() - start)
+				);
+	}
+	return result;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX critical section report at exit.
+ *
+ * One summary line with the unit of the durations and the kernel_lock
+ * counters, one line for the waits on a contended kernel_lock and one line
+ * per call site pair.
+ */
+void posix_critical_exit(void)
+{
+	int i, n = 0;
+	char name[256];
+	unsigned long long cycles, nsec;
+	critical_site_t *order[POSIX_CRITICAL_SITES + 1];
+	FILE *file = stderr;
+
+	if (
+			getenv("POSIX_CRITICAL_REPORT") &&
+			!(file = fopen(getenv("POSIX_CRITICAL_REPORT"), "w"))
+	   ) {
+		return;
+	}
+
+	for (i=0;i<=POSIX_CRITICAL_SITES;i++) {
+		if (critical_site[i].duration.total) {
+			order[n++] = &critical_site[i];
+		}
+	}
+	qsort(order, n, sizeof(order[0]), critical_compare);
+
+	/* The rate of the counter over the run, to convert into time. */
+	cycles = critical_started ? critical_cycles() - critical_first_cycles : 0;
+	nsec = critical_started ? critical_nsec() - critical_first_nsec : 0;
+
+	fprintf(
+			file,
+			"critical sites=%d cycles_per_usec=%.1f"
+			" acquired=%lu contended=%lu\n",
+			n,
+			nsec ? cycles * 1000.0 / nsec : 0.0,
+			critical_acquired,
+			critical_contended
+			);
+	if (critical_wait.total) {
+		critical_print(file, "critical kernel_lock wait", &critical_wait);
+	}
+
+	for (i=0;i<n;i++) {
+		if (order[i] == &critical_site[POSIX_CRITICAL_SITES]) {
+			snprintf(name, sizeof(name), "critical enter=? leave=?");
+		} else {
+			snprintf(
+					name,
+					sizeof(name),
+					"critical enter=%s:%d leave=%s:%d",
+					critical_basename(order[i]->enter_file),
+					order[i]->enter_line,
+					critical_basename(order[i]->leave_file),
+					order[i]->leave_line
+					);
+		}
+		critical_print(file, name, &order[i]->duration);
+	}
+
+	if (file != stderr) {
+		fclose(file);
+	}
+}
+
+#endif /* POSIX_CRITICAL */
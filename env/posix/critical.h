@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_CRITICAL_H_
+#define ENV_POSIX_CRITICAL_H_
+
+/* POSIX/UNIX headers. */
+#include <pthread.h>
+
+/* ************************************************************************** */
+
+#if defined POSIX_CRITICAL
+
+#ifndef POSIX_CRITICAL_SITES
+	/**
+	 * \brief POSIX critical section profiler number of call site pairs,
+	 * must be a power of two.
+	 */
+#	define POSIX_CRITICAL_SITES 64
+#endif
+
+void posix_critical_enter(const char *, int);
+void posix_critical_leave(const char *, int);
+int posix_critical_lock(pthread_mutex_t *);
+void posix_critical_exit(void);
+
+#else
+
+/** \cond */
+#	define posix_critical_enter(file, line)
+#	define posix_critical_leave(file, line)
+#	define posix_critical_lock(lock) pthread_mutex_lock(lock)
+/** \endcond */
+
+#endif
+
+#endif
@@ -46,37 +46,21 @@
 #include <posix/env.h>
 #include <posix/types.h>
 #include <posix/ack.h>
+#include <posix/rt.h>
+#include <posix/stress.h>
+#include <posix/critical.h>
 
 /* tinyTimber headers. */
 #include <kernel.h>
+#include <trace.h>
+#include <stats.h>
+#include <record.h>
+#include <sporadic.h>
 
 /* ************************************************************************** */
 
 /** \cond */
 
-/**
- * \brief POSIX number interrupt vector slots.
- */
-#ifndef POSIX_NUM_INTERRUPTS
-#	define POSIX_NUM_INTERRUPTS 10
-#endif
-
-/**
- * \brief POSIX interrupt hammer.
- *
- * If defined then hammer with interrupts all the time.
- */
-#define POSIX_INTERRUPT_HAMMER 1
-#undef POSIX_INTERRUPT_HAMMER
-
-#ifdef POSIX_INTERRUPT_HAMMER
-#	if POSIX_NUM_INTERRUPTS < 3
-#		error POSIX_INTERRUPT_HAMMER defined but not enough interrupts.
-#	endif
-#endif
-
-/* ************************************************************************** */
-
 /*
  * Internal state variables etc.
  */
@@ -88,10 +72,18 @@ static pthread_mutex_t kernel_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t interrupt_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t interrupt_enabled_signal = PTHREAD_COND_INITIALIZER;
 static ack_t *interrupt_start_ack;
+static int interrupt_started;
+static int exit_dump;
 static ack_t *interrupt_ack;
 static sig_atomic_t posix_interrupt;
+#if defined POSIX_STRESS
+static env_time_t posix_interrupt_raised;
+#endif
 static volatile sig_atomic_t interrupts_enabled;
 static posix_ext_interrupt_handler_t posix_interrupt_vector[POSIX_NUM_INTERRUPTS];
+#if defined TT_SPORADIC
+static tt_sporadic_t *posix_interrupt_server[POSIX_NUM_INTERRUPTS];
+#endif
 
 /*
  * Semi private internal but used in the header file.
@@ -99,6 +91,9 @@ static posix_ext_interrupt_handler_t posix_interrupt_vector[POSIX_NUM_INTERRUPTS
 timer_t posix_timer;
 env_time_t posix_timer_timestamp;
 env_time_t posix_time_inherit = {0};
+#if defined TT_RECORD
+env_time_t posix_timer_armed;
+#endif
 
 /* ************************************************************************** */
 
@@ -109,6 +104,9 @@ static void interrupt_handler(int sig)
 {
 	sig_atomic_t interrupt;
 	tt_thread_t *context;
+#if defined POSIX_STRESS
+	env_time_t raised;
+#endif
 
 	context = pthread_getspecific(thread_context);
 
@@ -128,10 +126,26 @@ static void interrupt_handler(int sig)
 	 * it.
 	 */
 	interrupt = posix_interrupt;
+#if defined POSIX_STRESS
+	raised = posix_interrupt_raised;
+#endif
 	ack_set(interrupt_ack);
 	clock_gettime(CLOCK_REALTIME, &posix_timer_timestamp);
-
+	posix_stress_raised(interrupt, &raised, &posix_timer_timestamp);
+	TT_RECORD_EVENT(
+			interrupt ? TT_RECORD_INTERRUPT : TT_RECORD_TIMER,
+			interrupt,
+			posix_timer_timestamp,
+			interrupt ? posix_timer_timestamp : posix_timer_armed
+			);
+
+#if defined TT_SPORADIC
+	tt_sporadic_enter(posix_interrupt_server[interrupt]);
+#endif
 	posix_interrupt_vector[interrupt](interrupt);
+#if defined TT_SPORADIC
+	tt_sporadic_leave();
+#endif
 
 	posix_protect(0);
 }
@@ -151,6 +165,8 @@ static void *posix_thread_wrapper(void *data)
 
 	assert(data);
 
+	posix_rt_thread(POSIX_RT_KERNEL);
+
 	/* SIGUSR1 is used to generate interrupts. */
 	sigfillset(&block);
 	sigdelset(&block, SIGUSR1);
@@ -210,48 +226,6 @@ static void *posix_thread_wrapper(void *data)
 	return NULL;
 }
 
-#ifdef POSIX_INTERRUPT_HAMMER
-
-/* ************************************************************************** */
-
-static void *hammer_thread0(void *data)
-{
-	ack_wait(interrupt_start_ack, 1);
-	fprintf(stderr, "It's hammer time! (0)\n");
-	for (;;) {
-		/* Generate a large amount of interrupts. */
-		posix_ext_interrupt_generate(POSIX_NUM_INTERRUPTS-1);
-		usleep(1);
-	}
-}
-
-/* ************************************************************************** */
-
-static void *hammer_thread1(void *data)
-{
-	ack_wait(interrupt_start_ack, 1);
-	fprintf(stderr, "It's hammer time! (1)\n");
-	for (;;) {
-		/* Generate a large amount of interrupts. */
-		posix_ext_interrupt_generate(POSIX_NUM_INTERRUPTS-2);
-		usleep(1);
-	}
-}
-
-/* ************************************************************************** */
-
-static void *hammer_thread2(void *data)
-{
-	ack_wait(interrupt_start_ack, 1);
-	fprintf(stderr, "It's hammer time! (2)\n");
-	for (;;) {
-		/* Generate a large amount of interrupts. */
-		posix_ext_interrupt_generate(POSIX_NUM_INTERRUPTS-3);
-		usleep(1);
-	}
-}
-#endif
-
 /* ************************************************************************** */
 
 /**
@@ -283,6 +257,8 @@ static void *timer_thread(void *args)
 	sigset_t block;
 	struct sigaction signal_action;
 
+	posix_rt_thread(POSIX_RT_TIMER);
+
 	memset(&signal_action, 0, sizeof(signal_action));
 	signal_action.sa_handler = timer_interrupt_generate;
 	if (sigaction(SIGALRM, &signal_action, NULL)) {
@@ -316,6 +292,245 @@ static void timer_interrupt_handler(int id)
 	tt_schedule();
 }
 
+#if defined TT_TRACE || defined TT_STATS || defined TT_RECORD ||\
+	defined POSIX_STRESS || defined POSIX_CRITICAL
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX SIGINT thread, exit so that the exit handlers dump.
+ *
+ * SIGINT is blocked in every other thread and taken here with sigwait(),
+ * not by a signal handler on whatever kernel thread happens to run. The
+ * kernel lock is held while the exit handlers run, the kernel is stopped
+ * outside of any protected section and the dumped tables hold still.
+ */
+static void *exit_thread(void *data)
+{
+	int sig;
+	sigset_t set;
+
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	while (sigwait(&set, &sig) || sig != SIGINT);
+
+	if (posix_critical_lock(&kernel_lock)) {
+		posix_panic("exit_thread(): Unable to aquire kernel lock.\n");
+	}
+	exit(0);
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX exit dump init.
+ *
+ * Starts the SIGINT thread, once, and registers the exit handler.
+ */
+static void exit_init(void (*handler)(void))
+{
+	sigset_t block, old;
+	pthread_t thread;
+
+	if (!exit_dump) {
+		/* The SIGINT thread must not take any of the other signals. */
+		sigfillset(&block);
+		if (pthread_sigmask(SIG_BLOCK, &block, &old)) {
+			posix_panic("exit_init(): Unable to block signals.\n");
+		}
+		if (pthread_create(&thread, NULL, exit_thread, NULL)) {
+			posix_panic("exit_init(): Unable to create the SIGINT thread.\n");
+		}
+
+		/* Every thread created from here on inherits a blocked SIGINT. */
+		sigaddset(&old, SIGINT);
+		if (pthread_sigmask(SIG_SETMASK, &old, NULL)) {
+			posix_panic("exit_init(): Unable to block SIGINT.\n");
+		}
+		exit_dump = 1;
+	}
+	if (atexit(handler)) {
+		posix_panic("exit_init(): Unable to register exit handler.\n");
+	}
+}
+
+#endif /* TT_TRACE || TT_STATS || TT_RECORD || POSIX_STRESS ||
+		  POSIX_CRITICAL */
+
+#if defined TT_TRACE
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX trace file writer.
+ */
+static void trace_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX trace dump at exit.
+ */
+static void trace_exit(void)
+{
+	FILE *file = fopen(getenv("TT_TRACE"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_trace_dump(trace_write, file);
+	fclose(file);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX trace init.
+ *
+ * Tracing is enabled if the TT_TRACE environment variable names the file
+ * to dump the trace into when the application exits.
+ */
+static void trace_init(void)
+{
+	if (!getenv("TT_TRACE")) {
+		return;
+	}
+
+	exit_init(trace_exit);
+	tt_trace_enable(1);
+}
+
+#endif /* TT_TRACE */
+
+#if defined TT_RECORD
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX record file writer.
+ */
+static void record_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX record dump at exit.
+ */
+static void record_exit(void)
+{
+	FILE *file = fopen(getenv("TT_RECORD"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_record_dump(record_write, file);
+	fclose(file);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX record init.
+ *
+ * Interrupts are recorded if the TT_RECORD environment variable names the
+ * file to dump them into when the application exits. The recording starts
+ * now, at the startup timestamp.
+ */
+static void record_init(void)
+{
+	if (!getenv("TT_RECORD")) {
+		return;
+	}
+
+	exit_init(record_exit);
+	tt_record_enable(1);
+}
+
+#endif /* TT_RECORD */
+
+#if defined TT_STATS
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX statistics histogram print.
+ */
+static void stats_print(
+		FILE *file,
+		tt_stats_t *entry,
+		const char *name,
+		tt_histogram_t *histogram
+		)
+{
+	if (!histogram->total) {
+		return;
+	}
+
+	fprintf(
+			file,
+			"object=%p method=%p %s count=%lu"
+			" min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			(void *)entry->to,
+			(void *)(size_t)entry->method,
+			name,
+			histogram->total,
+			histogram->min,
+			tt_histogram_mean(histogram),
+			tt_histogram_percentile(histogram, 500),
+			tt_histogram_percentile(histogram, 900),
+			tt_histogram_percentile(histogram, 990),
+			tt_histogram_percentile(histogram, 999),
+			histogram->max
+			);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX statistics dump at exit.
+ *
+ * One line per object/method pair and histogram, all values in
+ * nanoseconds, after an anchor line with the address of tt_stats_get()
+ * for tools that relocate symbols. Written to the file named by the
+ * TT_STATS environment variable, or stderr.
+ */
+static void stats_exit(void)
+{
+	int i;
+	tt_stats_t *entry;
+	FILE *file = stderr;
+
+	if (getenv("TT_STATS") && !(file = fopen(getenv("TT_STATS"), "w"))) {
+		return;
+	}
+
+	/* The address of a known function, to relocate symbols. */
+	fprintf(file, "anchor=%p\n", (void *)(size_t)tt_stats_get);
+	for (i=0;i<tt_stats_count();i++) {
+		entry = tt_stats_get(i);
+		stats_print(file, entry, "jitter", &entry->jitter);
+		stats_print(file, entry, "slack", &entry->slack);
+		stats_print(file, entry, "lateness", &entry->lateness);
+		stats_print(file, entry, "execution", &entry->execution);
+	}
+
+	if (file != stderr) {
+		fclose(file);
+	}
+}
+
+#endif /* TT_STATS */
+
 /** \endcond */
 
 /* ************************************************************************** */
@@ -333,11 +548,6 @@ void posix_init(void)
 	struct sigevent timer_event;
 	struct sigaction signal_action;
 	pthread_t timer_interrupt;
-#ifdef POSIX_INTERRUPT_HAMMER
-	pthread_t hammer_interrupt0;
-	pthread_t hammer_interrupt1;
-	pthread_t hammer_interrupt2;
-#endif
 
 	if (pthread_key_create(&thread_mode, NULL)) {
 		posix_panic(
@@ -369,6 +579,22 @@ void posix_init(void)
 		posix_interrupt_vector[i] = posix_interrupt_noop;
 	}
 
+	/* Lock memory before any threads (and stacks) are created. */
+	posix_rt_init();
+
+#if defined TT_TRACE
+	trace_init();
+#endif
+#if defined TT_STATS
+	exit_init(stats_exit);
+#endif
+#if defined POSIX_STRESS
+	exit_init(posix_stress_exit);
+#endif
+#if defined POSIX_CRITICAL
+	exit_init(posix_critical_exit);
+#endif
+
 	posix_num_threads = 0;
 	thread_ready_ack = ack_new();
 
@@ -393,12 +619,15 @@ void posix_init(void)
 	/* 
 	 * Block any signals except SIGINT and SIGUSR1.
 	 *
-	 * SIGINT is used to kill the program and SIGUSR1 is used for
-	 * synchronization betweem the root thread and the worker threads.
+	 * SIGINT is used to kill the program, unless the SIGINT thread takes
+	 * it, and SIGUSR1 is used for synchronization betweem the root thread
+	 * and the worker threads.
 	 */
 
 	sigfillset(&block);
-	sigdelset(&block, SIGINT);
+	if (!exit_dump) {
+		sigdelset(&block, SIGINT);
+	}
 	sigdelset(&block, SIGUSR1);
 	if (pthread_sigmask(SIG_SETMASK, &block, NULL)) {
 		posix_panic("posix_init(): Unable to set sigmask for root thread.\n");
@@ -418,6 +647,9 @@ void posix_init(void)
 	 */
 
 	clock_gettime(CLOCK_REALTIME, &posix_timer_timestamp);
+#if defined TT_RECORD
+	record_init();
+#endif
 
 	/* Create the timer thread. */
 	if (pthread_create(&timer_interrupt, NULL, timer_thread, NULL)) {
@@ -426,28 +658,8 @@ void posix_init(void)
 				);
 	}
 
-#ifdef POSIX_INTERRUPT_HAMMER
-	/* Create the hammer0 thread. */
-	if (pthread_create(&hammer_interrupt0, NULL, hammer_thread0,NULL)) {
-		posix_panic(
-				"posix_init(): Unable to create hammer0 interrupt thread.\n"
-				);
-	}
-
-	/* Create the hammer1 thread. */
-	if (pthread_create(&hammer_interrupt1, NULL, hammer_thread1, NULL)) {
-		posix_panic(
-				"posix_init(): Unable to create hammer1 interrupt thread.\n"
-				);
-	}
-
-	/* Create the hammer2 thread. */
-	if (pthread_create(&hammer_interrupt2, NULL, hammer_thread2, NULL)) {
-		posix_panic(
-				"posix_init(): Unable to create hammer2 interrupt thread.\n"
-				);
-	}
-#endif
+	/* Start the interrupt sources of the stress harness. */
+	posix_stress_init();
 }
 
 /* ************************************************************************** */
@@ -515,9 +727,16 @@ void posix_context_init(posix_context_t *context, void (*function)(void))
 /**
  * \brief POSIX protect function.
  *
+ * With POSIX_CRITICAL the protected sections are profiled, see critical.c,
+ * and the call site is passed along by the posix_protect() macro.
+ *
  * \param protect If we should enter protected mode.
  */
+#if defined POSIX_CRITICAL
+void posix_protect_at(int protect, const char *file, int line)
+#else
 void posix_protect(int protect)
+#endif
 {
 	int isprotected = posix_isprotected();
 
@@ -527,7 +746,7 @@ void posix_protect(int protect)
 		 */
 
 		/* Aquire the kernel lock, stops any interrupts. */
-		if (pthread_mutex_lock(&kernel_lock)) {
+		if (posix_critical_lock(&kernel_lock)) {
 			posix_panic("posix_protect(): Unable to lock the kernel_lock.\n");
 		}
 
@@ -536,6 +755,7 @@ void posix_protect(int protect)
 			posix_panic("posix_protect(): Unable to set protected mode.\n");
 		}
 		interrupts_enabled = 0;
+		posix_critical_enter(file, line);
 	}
 	else if (!protect && isprotected) {
 		/*
@@ -543,6 +763,7 @@ void posix_protect(int protect)
 		 */
 
 		/* Enable interrupts and set the mode to unprotected. */
+		posix_critical_leave(file, line);
 		interrupts_enabled = 1;
 		if (pthread_setspecific(thread_mode, (void *)0)) {
 			posix_panic("posix_protect(): Unable to set unprotected mode.\n");
@@ -596,12 +817,14 @@ void posix_idle(void)
 		posix_panic("posix_idle(): Unable to initialize signal.\n");
 	}
 	tt_current->context.thread = pthread_self();
+	posix_rt_thread(POSIX_RT_KERNEL);
 	if (pthread_setspecific(thread_context, tt_current)) {
 		posix_panic("posix_idle(): Unable to set thread specific context.\n");
 	}
 
 	/* Leave protected mode and start all interrupt generating threads. */
 	posix_protect(0);
+	__atomic_store_n(&interrupt_started, 1, __ATOMIC_RELEASE);
 	ack_set(interrupt_start_ack);
 	for (;;) {
 		pause();
@@ -703,6 +926,31 @@ void posix_ext_interrupt_handler(int id, posix_ext_interrupt_handler_t handler)
 	posix_interrupt_vector[id] = handler;
 }
 
+#if defined TT_SPORADIC
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX interrupt sporadic server install.
+ *
+ * Messages posted by the handler of the interrupt are limited by the server,
+ * NULL removes the limit.
+ *
+ * \param id The id to install the server for.
+ * \param server The server.
+ */
+void posix_ext_interrupt_sporadic(int id, tt_sporadic_t *server)
+{
+	int protected = posix_isprotected();
+
+	assert(id < POSIX_NUM_INTERRUPTS);
+	posix_protect(1);
+	posix_interrupt_server[id] = server;
+	posix_protect(protected);
+}
+
+#endif /* TT_SPORADIC */
+
 /* ************************************************************************** */
 
 /**
@@ -710,6 +958,24 @@ void posix_ext_interrupt_handler(int id, posix_ext_interrupt_handler_t handler)
  */
 void posix_ext_interrupt_generate(int id)
 {
+#if defined POSIX_STRESS
+	env_time_t raised;
+#endif
+
+	/*
+	 * There is no thread to interrupt until the idle thread is up and
+	 * running, sources started before that (helper threads etc.) must
+	 * hold their interrupts until then. Once started the flag saves the
+	 * round trip through the ack lock.
+	 */
+	if (!__atomic_load_n(&interrupt_started, __ATOMIC_ACQUIRE)) {
+		ack_wait(interrupt_start_ack, 1);
+	}
+#if defined POSIX_STRESS
+	/* Waiting for the interrupt lock counts towards the latency. */
+	clock_gettime(CLOCK_REALTIME, &raised);
+#endif
+
 	if (pthread_mutex_lock(&interrupt_lock)) {
 		posix_panic(
 				"posix_ext_interrupt_generate(): "
@@ -718,8 +984,11 @@ void posix_ext_interrupt_generate(int id)
 	}
 
 	posix_interrupt = id;
+#if defined POSIX_STRESS
+	posix_interrupt_raised = raised;
+#endif
 
-	if (pthread_mutex_lock(&kernel_lock)) {
+	if (posix_critical_lock(&kernel_lock)) {
 		posix_panic(
 				"posix_ext_interrupt_generate(): "
 				"Unable to aquire kernel lock.\n"
@@ -49,13 +49,32 @@
 void posix_init(void);
 void posix_panic(const char * const);
 void posix_context_init(posix_context_t *, void (*)(void));
+#if defined POSIX_CRITICAL
+void posix_protect_at(int, const char *, int);
+/* Every caller, ENV_PROTECT() included, passes its call site. */
+#	define posix_protect(state) posix_protect_at((state), __FILE__, __LINE__)
+#else
 void posix_protect(int);
+#endif
 int  posix_isprotected(void);
 void posix_context_dispatch(tt_thread_t *);
 void posix_idle(void);
 
 void posix_ext_interrupt_handler(int, posix_ext_interrupt_handler_t);
 void posix_ext_interrupt_generate(int);
+#if defined TT_SPORADIC
+struct tt_sporadic_t;
+void posix_ext_interrupt_sporadic(int, struct tt_sporadic_t *);
+#endif
+
+/* ************************************************************************** */
+
+#ifndef POSIX_NUM_INTERRUPTS
+	/**
+	 * \brief POSIX number of interrupt vector slots, id 0 is the timer.
+	 */
+#	define POSIX_NUM_INTERRUPTS 10
+#endif
 
 /* ************************************************************************** */
 
@@ -162,10 +181,12 @@ void posix_ext_interrupt_generate(int);
 
 /* ************************************************************************** */
 
-/**
- * \brief The number of thears of this environment.
- */
-#define ENV_NUM_THREADS 2
+#ifndef ENV_NUM_THREADS
+	/**
+	 * \brief The number of thears of this environment.
+	 */
+#	define ENV_NUM_THREADS 2
+#endif
 
 /* ************************************************************************** */
 
@@ -193,6 +214,32 @@ void posix_ext_interrupt_generate(int);
 
 /* ************************************************************************** */
 
+/**
+ * \brief Environment processor time macro.
+ *
+ * The processor time consumed by the running context in nanoseconds, the
+ * time it is preempted by other contexts is not counted.
+ */
+#define ENV_CPU_GET() \
+	posix_cpu_get()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment time in nanoseconds, used by the kernel trace.
+ */
+#define ENV_TRACE_NSEC(time) \
+	((unsigned long long)(time).tv_sec*1000000000ULL + (time).tv_nsec)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment has USDT probes (if <sys/sdt.h> is available).
+ */
+#define ENV_USDT 1
+
+/* ************************************************************************** */
+
 /**
  * \brief Environment timer usec macro.
  */
@@ -249,6 +296,20 @@ int main(void)\
 #define ENV_EXT_INTERRUPT_GENERATE(id) \
 	posix_ext_interrupt_generate(id)
 
+#if defined TT_SPORADIC
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment extension to limit an interrupt with a sporadic server.
+ *
+ * Messages posted by the handler of the interrupt are admitted by the server.
+ */
+#define ENV_EXT_INTERRUPT_SPORADIC(id, server) \
+	posix_ext_interrupt_sporadic(id, server)
+
+#endif
+
 /* ************************************************************************** */
 
 static inline env_time_t posix_timer_get(void)
@@ -260,6 +321,20 @@ static inline env_time_t posix_timer_get(void)
 
 /* ************************************************************************** */
 
+/**
+ * \brief POSIX processor time function.
+ *
+ * \return The thread CPU time of the calling context in nanoseconds.
+ */
+static inline long posix_cpu_get(void)
+{
+	struct timespec tmp;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tmp);
+	return tmp.tv_sec*1000000000L + tmp.tv_nsec;
+}
+
+/* ************************************************************************** */
+
 /**
  * \brief POSIX set timer function.
  *
@@ -269,6 +344,10 @@ static inline void posix_timer_set(const env_time_t *next)
 {
 	extern timer_t posix_timer;
 	struct itimerspec tmp = {.it_value = *next};
+#if defined TT_RECORD
+	extern env_time_t posix_timer_armed;
+	posix_timer_armed = *next;
+#endif
 	timer_settime(posix_timer, TIMER_ABSTIME, &tmp, NULL);
 }
 
@@ -312,7 +391,7 @@ static inline env_time_t posix_msec(unsigned long mseconds)
 	env_time_t tmp;
 	if (mseconds >= 1000UL) {
 		tmp.tv_sec = mseconds / 1000UL;
-		tmp.tv_nsec = (mseconds % 1000UL) * 1000UL;
+		tmp.tv_nsec = (mseconds % 1000UL) * 1000000UL;
 	} else {
 		tmp.tv_sec = 0;
 		tmp.tv_nsec = mseconds * 1000000UL;
@@ -336,7 +415,7 @@ static inline env_time_t posix_usec(unsigned long useconds)
 		tmp.tv_nsec = (useconds % 1000000UL) * 1000UL;
 	} else {
 		tmp.tv_sec = 0;
-		tmp.tv_nsec = useconds;
+		tmp.tv_nsec = useconds * 1000UL;
 	}
 	return tmp;
 }
@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX compute offload pool.
+ *
+ * CPU heavy work (checksums, compression, transforms) run inside a method
+ * holds up every message with a tighter deadline that does not fit in the
+ * remaining threads. Such work can be handed to a pool of worker threads
+ * instead, the result is delivered as a message once the job is done.
+ * Pending jobs are picked earliest deadline first. Completions are posted
+ * at most POSIX_POOL_BATCH per interrupt so that a burst of them can not
+ * use up the message pool.
+ */
+
+/* SCHED_IDLE is a GNU extension. */
+#define _GNU_SOURCE 1
+
+/* Standard C headers. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX/UNIX headers. */
+#include <sched.h>
+#include <signal.h>
+#include <pthread.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/pool.h>
+#include <posix/rt.h>
+
+/* tinyTimber headers. */
+#include <kernel.h>
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX pool worker scheduling policy.
+ *
+ * Workers should never compete with the kernel threads for the CPU,
+ * SCHED_IDLE does not require any privileges.
+ */
+#if ! defined POSIX_POOL_POLICY && defined SCHED_IDLE
+#	define POSIX_POOL_POLICY SCHED_IDLE
+#endif
+
+/**
+ * \brief POSIX pool number of completions posted per interrupt.
+ *
+ * The rest is left for the next interrupt.
+ */
+#ifndef POSIX_POOL_BATCH
+#	define POSIX_POOL_BATCH ((TT_NUM_MESSAGES + 1)/2)
+#endif
+
+/* ************************************************************************** */
+
+/*
+ * Internal state variables etc.
+ */
+static int pool_interrupt;
+static int pool_threads;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_signal = PTHREAD_COND_INITIALIZER;
+static posix_job_t *pool_head;
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_signal = PTHREAD_COND_INITIALIZER;
+static int done_pending;
+static posix_job_t *done_head;
+static posix_job_t *done_tail;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool queue a completed job.
+ *
+ * \param job The completed job.
+ */
+static void pool_done(posix_job_t *job)
+{
+	job->next = NULL;
+
+	if (pthread_mutex_lock(&done_lock)) {
+		posix_panic("pool_done(): Unable to aquire done lock.\n");
+	}
+
+	if (done_head) {
+		done_tail->next = job;
+	} else {
+		done_head = job;
+	}
+	done_tail = job;
+
+	if (pthread_cond_signal(&done_signal)) {
+		posix_panic("pool_done(): Unable to signal notify thread.\n");
+	}
+	if (pthread_mutex_unlock(&done_lock)) {
+		posix_panic("pool_done(): Unable to release done lock.\n");
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool notify thread.
+ *
+ * Generates the completion interrupt on behalf of the workers. Workers run
+ * at the lowest priority and must not hold the interrupt lock, every other
+ * interrupt source (the timer included) would be stuck behind them. Jobs
+ * left over by a previous interrupt get another one.
+ */
+static void *pool_notify(void *data)
+{
+	sigset_t block;
+
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("pool_notify(): Unable to set sigmask.\n");
+	}
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (pthread_mutex_lock(&done_lock)) {
+			posix_panic("pool_notify(): Unable to aquire done lock.\n");
+		}
+		while (!done_head || done_pending) {
+			if (pthread_cond_wait(&done_signal, &done_lock)) {
+				posix_panic("pool_notify(): Unable to wait for jobs.\n");
+			}
+		}
+		done_pending = 1;
+		if (pthread_mutex_unlock(&done_lock)) {
+			posix_panic("pool_notify(): Unable to release done lock.\n");
+		}
+
+		posix_ext_interrupt_generate(pool_interrupt);
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool completion interrupt handler.
+ *
+ * Posts one message for each completed job, at most POSIX_POOL_BATCH.
+ */
+static void pool_interrupt_handler(int id)
+{
+	int n;
+	posix_job_t *job, *next;
+
+	if (pthread_mutex_lock(&done_lock)) {
+		posix_panic("pool_interrupt_handler(): Unable to aquire done lock.\n");
+	}
+
+	job = done_head;
+	for (n=1;n<POSIX_POOL_BATCH && done_head;n++) {
+		done_head = done_head->next;
+	}
+	if (done_head) {
+		next = done_head->next;
+		done_head->next = NULL;
+		done_head = next;
+	}
+	if (!done_head) {
+		done_tail = NULL;
+	}
+	done_pending = 0;
+
+	if (pthread_cond_signal(&done_signal)) {
+		posix_panic("pool_interrupt_handler(): Unable to signal notify thread.\n");
+	}
+	if (pthread_mutex_unlock(&done_lock)) {
+		posix_panic("pool_interrupt_handler(): Unable to release done lock.\n");
+	}
+
+	for (;job;job = next) {
+		next = job->next;
+		TT_BEFORE(job->deadline, job->to, job->method, &job);
+	}
+
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool worker thread.
+ */
+static void *pool_worker(void *data)
+{
+	sigset_t block;
+	posix_job_t *job;
+#ifdef POSIX_POOL_POLICY
+	struct sched_param param;
+#endif
+
+	/* Workers must never receive the interrupt or timer signals. */
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("pool_worker(): Unable to set sigmask.\n");
+	}
+	posix_rt_thread(POSIX_RT_NONE);
+
+#ifdef POSIX_POOL_POLICY
+	/*
+	 * Workers only get what the kernel threads leave over, best effort
+	 * since it is only a hint on some systems.
+	 */
+	memset(&param, 0, sizeof(param));
+	pthread_setschedparam(pthread_self(), POSIX_POOL_POLICY, &param);
+#endif
+
+	for (;;) {
+		if (pthread_mutex_lock(&pool_lock)) {
+			posix_panic("pool_worker(): Unable to aquire pool lock.\n");
+		}
+		while (!pool_head) {
+			if (pthread_cond_wait(&pool_signal, &pool_lock)) {
+				posix_panic("pool_worker(): Unable to wait for jobs.\n");
+			}
+		}
+		job = pool_head;
+		pool_head = job->next;
+		if (pthread_mutex_unlock(&pool_lock)) {
+			posix_panic("pool_worker(): Unable to release pool lock.\n");
+		}
+
+		job->function(job);
+
+		if (job->to) {
+			pool_done(job);
+		}
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool enqueue by deadline.
+ *
+ * Must be called with the pool lock held.
+ *
+ * \param job The job to enqueue.
+ */
+static void pool_enqueue(posix_job_t *job)
+{
+	posix_job_t *prev = NULL;
+	posix_job_t *tmp = pool_head;
+
+	/* Find where to place the job, same order as the kernel. */
+	while (tmp && !ENV_TIME_LT(job->absolute, tmp->absolute)) {
+		prev = tmp;
+		tmp = tmp->next;
+	}
+
+	job->next = tmp;
+	if (prev) {
+		prev->next = job;
+	} else {
+		pool_head = job;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX parallel for chunk function.
+ *
+ * The worker finishing the last chunk hands the completion to the kernel.
+ */
+static void parallel_chunk(posix_job_t *job)
+{
+	posix_chunk_t *chunk = (posix_chunk_t *)job;
+	posix_parallel_t *parent = job->data;
+
+	parent->function(chunk->buf, chunk->count, parent->job.data);
+
+	if (!__atomic_sub_fetch(&parent->pending, 1, __ATOMIC_ACQ_REL)) {
+		if (parent->job.to) {
+			pool_done(&parent->job);
+		}
+	}
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool init function.
+ *
+ * Should be called from the startup function, before any jobs are
+ * submitted.
+ *
+ * \note
+ *	Upon failure posix_panic() will be called.
+ *
+ * \param interrupt The interrupt id used for completions.
+ * \param threads The number of worker threads.
+ */
+void posix_pool_init(int interrupt, int threads)
+{
+	int i;
+	pthread_t thread;
+
+	assert(interrupt > 0);
+	assert(threads > 0 && threads <= POSIX_POOL_MAX_THREADS);
+
+	pool_interrupt = interrupt;
+	pool_threads = threads;
+	posix_ext_interrupt_handler(interrupt, pool_interrupt_handler);
+
+	if (pthread_create(&thread, NULL, pool_notify, NULL)) {
+		posix_panic("posix_pool_init(): Unable to create notify thread.\n");
+	}
+
+	for (i=0;i<threads;i++) {
+		if (pthread_create(&thread, NULL, pool_worker, NULL)) {
+			posix_panic("posix_pool_init(): Unable to create worker thread.\n");
+		}
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool submit a job.
+ *
+ * May be called from a method or an interrupt handler.
+ *
+ * \param job The job.
+ */
+void posix_pool_submit(posix_job_t *job)
+{
+	int protected = ENV_ISPROTECTED();
+	env_time_t now = posix_timer_get();
+
+	assert(job);
+	assert(job->function);
+	assert(!job->to || job->method);
+
+	job->absolute = ENV_TIME_ADD(now, job->deadline);
+
+	/* Not to be preempted while holding the lock. */
+	ENV_PROTECT(1);
+	if (pthread_mutex_lock(&pool_lock)) {
+		posix_panic("posix_pool_submit(): Unable to aquire pool lock.\n");
+	}
+
+	pool_enqueue(job);
+
+	if (pthread_cond_signal(&pool_signal)) {
+		posix_panic("posix_pool_submit(): Unable to signal worker thread.\n");
+	}
+	if (pthread_mutex_unlock(&pool_lock)) {
+		posix_panic("posix_pool_submit(): Unable to release pool lock.\n");
+	}
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX parallel for.
+ *
+ * Splits count elements of the given size, starting at buf, into one chunk
+ * per worker thread and runs function on each chunk. Once all the chunks
+ * are done the method is invoked upon the object, the argument is a
+ * pointer to a pointer to parallel->job.
+ *
+ * \param parallel The descriptor, must stay valid until completion.
+ * \param buf The first element.
+ * \param count The number of elements.
+ * \param size The size of each element.
+ * \param function The function to run on each chunk.
+ * \param data User data for the function.
+ * \param to The object to deliver the completion to.
+ * \param method The method to invoke upon completion.
+ * \param deadline Deadline of the chunks and the completion.
+ */
+void posix_parallel_for(
+		posix_parallel_t *parallel,
+		void *buf,
+		size_t count,
+		size_t size,
+		posix_parallel_function_t function,
+		void *data,
+		tt_object_t *to,
+		tt_method_t method,
+		env_time_t deadline
+		)
+{
+	int i, chunks;
+	int protected = ENV_ISPROTECTED();
+	size_t per, rest;
+	char *tmp = buf;
+	env_time_t now = posix_timer_get();
+
+	assert(parallel);
+	assert(function);
+
+	/* Never more chunks than elements, but always at least one. */
+	chunks = pool_threads;
+	if (count < (size_t)chunks) {
+		chunks = count ? count : 1;
+	}
+	per = count / chunks;
+	rest = count % chunks;
+
+	memset(&parallel->job, 0, sizeof(parallel->job));
+	parallel->job.data = data;
+	parallel->job.to = to;
+	parallel->job.method = method;
+	parallel->job.deadline = deadline;
+	parallel->function = function;
+	parallel->pending = chunks;
+
+	/* Not to be preempted while holding the lock. */
+	ENV_PROTECT(1);
+	if (pthread_mutex_lock(&pool_lock)) {
+		posix_panic("posix_parallel_for(): Unable to aquire pool lock.\n");
+	}
+
+	for (i=0;i<chunks;i++) {
+		posix_chunk_t *chunk = &parallel->chunk[i];
+
+		chunk->buf = tmp;
+		chunk->count = per + ((size_t)i < rest);
+		tmp += chunk->count*size;
+
+		memset(&chunk->job, 0, sizeof(chunk->job));
+		chunk->job.function = parallel_chunk;
+		chunk->job.data = parallel;
+		chunk->job.absolute = ENV_TIME_ADD(now, deadline);
+		pool_enqueue(&chunk->job);
+	}
+
+	if (pthread_cond_broadcast(&pool_signal)) {
+		posix_panic("posix_parallel_for(): Unable to signal worker threads.\n");
+	}
+	if (pthread_mutex_unlock(&pool_lock)) {
+		posix_panic("posix_parallel_for(): Unable to release pool lock.\n");
+	}
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX pool number of worker threads.
+ *
+ * \return The number of worker threads.
+ */
+int posix_pool_threads(void)
+{
+	return pool_threads;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_POOL_H_
+#define ENV_POSIX_POOL_H_
+
+/* Standard C headers. */
+#include <stddef.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX maximum number of worker threads.
+ */
+#ifndef POSIX_POOL_MAX_THREADS
+#	define POSIX_POOL_MAX_THREADS 16
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX compute job.
+ *
+ * Filled in by the user and handed to posix_pool_submit(). The function is
+ * run on a worker thread, never in a kernel thread, and once it returns
+ * the method is invoked upon the object with a pointer to a pointer to the
+ * job as argument. The job must stay valid until then.
+ */
+typedef struct posix_job_t
+{
+	/**
+	 * \brief The function to run on a worker thread.
+	 */
+	void (*function)(struct posix_job_t *);
+
+	/**
+	 * \brief User data for the function.
+	 */
+	void *data;
+
+	/**
+	 * \brief The object to deliver the completion to, NULL for none.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method to invoke upon completion.
+	 */
+	tt_method_t method;
+
+	/**
+	 * \brief Deadline of the job.
+	 *
+	 * Relative to the time of submission for the job itself (workers pick
+	 * the earliest deadline first) and relative to the time of completion
+	 * for the completion message.
+	 */
+	env_time_t deadline;
+
+	/**
+	 * \brief Absolute deadline, used internally.
+	 */
+	env_time_t absolute;
+
+	/**
+	 * \brief Next job, used internally.
+	 */
+	struct posix_job_t *next;
+} posix_job_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX parallel for function.
+ *
+ * Called once per chunk with a pointer to the first element, the number
+ * of elements in the chunk and the user data.
+ */
+typedef void (*posix_parallel_function_t)(void *, size_t, void *);
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX parallel for chunk.
+ *
+ * One slice of a posix_parallel_for(), job::data points to the
+ * posix_parallel_t it belongs to.
+ */
+typedef struct posix_chunk_t
+{
+	/**
+	 * \brief The job running the chunk, must be the first member.
+	 */
+	posix_job_t job;
+
+	/**
+	 * \brief The first element of the chunk.
+	 */
+	void *buf;
+
+	/**
+	 * \brief The number of elements in the chunk.
+	 */
+	size_t count;
+} posix_chunk_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX parallel for descriptor.
+ *
+ * Holds the state of one posix_parallel_for(), must stay valid until the
+ * completion is delivered. The completion argument is a pointer to a
+ * pointer to the posix_parallel_t::job member.
+ */
+typedef struct posix_parallel_t
+{
+	/**
+	 * \brief The job describing the completion, must be the first member.
+	 */
+	posix_job_t job;
+
+	/**
+	 * \brief The function to run on each chunk.
+	 */
+	posix_parallel_function_t function;
+
+	/**
+	 * \brief The number of chunks still running.
+	 */
+	int pending;
+
+	/**
+	 * \brief One job per chunk.
+	 */
+	posix_chunk_t chunk[POSIX_POOL_MAX_THREADS];
+} posix_parallel_t;
+
+/* ************************************************************************** */
+
+void posix_pool_init(int, int);
+void posix_pool_submit(posix_job_t *);
+void posix_parallel_for(
+		posix_parallel_t *,
+		void *,
+		size_t,
+		size_t,
+		posix_parallel_function_t,
+		void *,
+		tt_object_t *,
+		tt_method_t,
+		env_time_t
+		);
+int  posix_pool_threads(void);
+
+#endif
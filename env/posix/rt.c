@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX realtime support.
+ *
+ * Enabled by defining POSIX_REALTIME (make RT=yes). The kernel, interrupt
+ * and timer threads are pinned to POSIX_REALTIME_CPUS and run SCHED_FIFO,
+ * or SCHED_DEADLINE if POSIX_REALTIME_DEADLINE is defined, all memory is
+ * locked and the thread stacks are prefaulted. Whatever is not permitted
+ * falls back to the next best thing, down to plain SCHED_OTHER.
+ */
+
+#define _GNU_SOURCE 1
+
+/* Standard C headers. */
+#include <stdint.h>
+#include <string.h>
+#include <malloc.h>
+
+/* POSIX/UNIX headers. */
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/rt.h>
+
+#if defined POSIX_REALTIME
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX realtime CPU mask for the kernel, interrupt and timer threads.
+ */
+#ifndef POSIX_REALTIME_CPUS
+#	define POSIX_REALTIME_CPUS 0x1ul
+#endif
+
+/**
+ * \brief POSIX realtime SCHED_FIFO priority of the kernel threads.
+ *
+ * Interrupt threads run one above and the timer thread two above.
+ */
+#ifndef POSIX_REALTIME_PRIORITY
+#	define POSIX_REALTIME_PRIORITY 50
+#endif
+
+/**
+ * \brief POSIX realtime SCHED_DEADLINE runtime in nanoseconds.
+ */
+#ifndef POSIX_REALTIME_RUNTIME
+#	define POSIX_REALTIME_RUNTIME 500000
+#endif
+
+/**
+ * \brief POSIX realtime SCHED_DEADLINE period in nanoseconds.
+ */
+#ifndef POSIX_REALTIME_PERIOD
+#	define POSIX_REALTIME_PERIOD 1000000
+#endif
+
+/**
+ * \brief POSIX realtime bytes of stack to prefault in each thread.
+ */
+#ifndef POSIX_REALTIME_STACK
+#	define POSIX_REALTIME_STACK (64*1024)
+#endif
+
+#ifndef SCHED_DEADLINE
+#	define SCHED_DEADLINE 6
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief Linux sched_setattr() attributes, not in any libc header yet.
+ */
+struct rt_sched_attr
+{
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+};
+
+/*
+ * Internal state variables etc.
+ */
+static int rt_policy = SCHED_OTHER;
+static int rt_locked;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime touch the stack so that it is mapped in.
+ */
+static void __attribute__((noinline)) rt_prefault(void)
+{
+	size_t i;
+	volatile char stack[POSIX_REALTIME_STACK];
+
+	for (i=0;i<sizeof(stack);i+=64) {
+		stack[i] = 0;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime try SCHED_DEADLINE for the calling thread.
+ */
+static int rt_deadline(void)
+{
+#if defined POSIX_REALTIME_DEADLINE && defined SYS_sched_setattr
+	struct rt_sched_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = SCHED_DEADLINE;
+	attr.sched_runtime = POSIX_REALTIME_RUNTIME;
+	attr.sched_deadline = POSIX_REALTIME_PERIOD;
+	attr.sched_period = POSIX_REALTIME_PERIOD;
+
+	return syscall(SYS_sched_setattr, 0, &attr, 0) == 0;
+#else
+	return 0;
+#endif
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime init function.
+ *
+ * Locks all current and future memory and keeps the heap from being
+ * trimmed or served by mmap, called by posix_init().
+ */
+void posix_rt_init(void)
+{
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	if (!mlockall(MCL_CURRENT|MCL_FUTURE)) {
+		rt_locked = 1;
+	} else if (!mlockall(MCL_CURRENT)) {
+		/* Probably RLIMIT_MEMLOCK, at least what we have now. */
+		rt_locked = 1;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime setup the calling thread.
+ *
+ * \param class One of the POSIX_RT_* thread classes.
+ */
+void posix_rt_thread(int class)
+{
+	int i, policy = SCHED_FIFO;
+	cpu_set_t set;
+	struct sched_param param;
+
+	CPU_ZERO(&set);
+	if (class == POSIX_RT_NONE) {
+		/* Undo whatever was inherited from the creating thread. */
+		for (i=0;i<CPU_SETSIZE;i++) {
+			CPU_SET(i, &set);
+		}
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		param.sched_priority = 0;
+		pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+		return;
+	}
+
+	rt_prefault();
+
+	/*
+	 * SCHED_DEADLINE threads may not be pinned to less than their root
+	 * domain, do one or the other.
+	 */
+	if (rt_deadline()) {
+		policy = SCHED_DEADLINE;
+	} else {
+		for (i=0;i<CPU_SETSIZE && i<8*sizeof(unsigned long);i++) {
+			if (POSIX_REALTIME_CPUS & (1ul << i)) {
+				CPU_SET(i, &set);
+			}
+		}
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = POSIX_REALTIME_PRIORITY + class - POSIX_RT_KERNEL;
+		if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+			policy = SCHED_OTHER;
+		}
+	}
+
+	if (class == POSIX_RT_KERNEL) {
+		rt_policy = policy;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime policy of the kernel threads.
+ *
+ * \return SCHED_DEADLINE, SCHED_FIFO or SCHED_OTHER if not permitted.
+ */
+int posix_rt_policy(void)
+{
+	return rt_policy;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime memory locked.
+ *
+ * \return Non-zero if the memory of the process is locked.
+ */
+int posix_rt_locked(void)
+{
+	return rt_locked;
+}
+
+#endif
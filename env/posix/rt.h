@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_RT_H_
+#define ENV_POSIX_RT_H_
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX realtime thread classes.
+ *
+ * Only one kernel thread runs at any time (the others wait for the kernel
+ * lock) so the kernel already enforces the EDF order among them. The OS
+ * priorities only have to order the kernel against the threads that
+ * generate its interrupts and against the rest of the system.
+ */
+enum
+{
+	/**
+	 * \brief Helper thread, not pinned and not realtime.
+	 */
+	POSIX_RT_NONE,
+
+	/**
+	 * \brief Kernel thread (including the idle thread).
+	 */
+	POSIX_RT_KERNEL,
+
+	/**
+	 * \brief Thread that generates interrupts.
+	 */
+	POSIX_RT_INTERRUPT,
+
+	/**
+	 * \brief The timer thread.
+	 */
+	POSIX_RT_TIMER
+};
+
+/* ************************************************************************** */
+
+#if defined POSIX_REALTIME
+
+void posix_rt_init(void);
+void posix_rt_thread(int);
+int  posix_rt_policy(void);
+int  posix_rt_locked(void);
+
+#else
+
+/** \cond */
+#	define posix_rt_init()
+#	define posix_rt_thread(class)
+#	define posix_rt_policy() (-1)
+#	define posix_rt_locked() (0)
+/** \endcond */
+
+#endif
+
+#endif
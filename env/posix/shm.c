@@ -0,0 +1,661 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX shared memory message channel.
+ *
+ * Links TinyTimber processes on the same host without a copy through the
+ * kernel and a system call per message. Each process owns an inbox, a
+ * ring of message records in shared memory that any number of processes
+ * may post to (MPSC). The owner drains the ring from a single pseudo
+ * interrupt and posts the records as regular messages to the exported
+ * objects. Senders only wake the owner (futex) when it is asleep, so
+ * there is at most one wake-up per drain.
+ *
+ * Baselines and deadlines are absolute CLOCK_REALTIME times, which all
+ * processes on the host share, and are preserved as is.
+ */
+
+/* Standard C headers. */
+#include <errno.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* POSIX/UNIX headers. */
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/shm.h>
+#include <posix/rt.h>
+
+/* tinyTimber headers. */
+#include <kernel.h>
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX shared memory maximum number of inboxes per process.
+ */
+#ifndef POSIX_SHM_INBOXES
+#	define POSIX_SHM_INBOXES 4
+#endif
+
+/**
+ * \brief POSIX shared memory maximum number of records posted per drain.
+ *
+ * The next batch is not drained until the previous one has run, the kernel
+ * needs at least this many free messages.
+ */
+#ifndef POSIX_SHM_BATCH
+#	define POSIX_SHM_BATCH 8
+#endif
+
+/**
+ * \brief POSIX shared memory ring magic.
+ */
+#define SHM_MAGIC 0x74547368u
+
+/* ************************************************************************** */
+
+/**
+ * \brief A message record in the ring.
+ */
+typedef struct shm_record_t
+{
+	uint64_t seq;
+	int32_t id;
+	env_time_t baseline;
+	env_time_t deadline;
+	union
+	{
+		char buf[TT_ARGS_SIZE];
+		void *___ptr;
+		long ___long;
+	} arg;
+} shm_record_t;
+
+/**
+ * \brief The shared part of the channel.
+ *
+ * Producer and consumer indices live on separate cache lines.
+ */
+typedef struct shm_ring_t
+{
+	uint32_t magic;
+	uint32_t mask;
+	uint32_t sleeping;
+	uint32_t wake;
+	char pad0[64 - 4*sizeof(uint32_t)];
+	uint64_t tail;
+	char pad1[64 - sizeof(uint64_t)];
+	uint64_t head;
+	char pad2[64 - sizeof(uint64_t)];
+	shm_record_t record[];
+} shm_ring_t;
+
+/**
+ * \brief The process local part of the channel.
+ */
+struct posix_shm_t
+{
+	tt_object_t obj;
+	shm_ring_t *ring;
+	int interrupt;
+	int pending;
+	pthread_mutex_t lock;
+	pthread_cond_t signal;
+	struct
+	{
+		tt_object_t *to;
+		tt_method_t method;
+	} exports[POSIX_SHM_EXPORTS];
+};
+
+/* ************************************************************************** */
+
+/*
+ * Internal state variables etc.
+ */
+static posix_shm_t *shm_inboxes[POSIX_SHM_INBOXES];
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory futex helper.
+ */
+static long shm_futex(uint32_t *addr, int op, uint32_t val)
+{
+	return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory map a ring.
+ *
+ * \param name The shared memory object name.
+ * \param slots The number of slots when creating, zero to attach.
+ * \return The mapped ring or NULL.
+ */
+static shm_ring_t *shm_map(const char *name, uint32_t slots)
+{
+	int fd;
+	size_t size;
+	struct stat st;
+	shm_ring_t *ring;
+
+	if (slots) {
+		fd = shm_open(name, O_RDWR|O_CREAT|O_TRUNC, 0600);
+		size = sizeof(shm_ring_t) + slots*sizeof(shm_record_t);
+		if (fd < 0 || ftruncate(fd, size)) {
+			goto fail;
+		}
+	} else {
+		fd = shm_open(name, O_RDWR, 0600);
+		if (fd < 0 || fstat(fd, &st)) {
+			goto fail;
+		}
+		size = st.st_size;
+		if (size < sizeof(shm_ring_t)) {
+			goto fail;
+		}
+	}
+
+	ring = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ring == MAP_FAILED) {
+		return NULL;
+	}
+	return ring;
+
+fail:
+	if (fd >= 0) {
+		close(fd);
+	}
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory check if a ring is empty.
+ *
+ * Only valid on the consumer side.
+ */
+static int shm_empty(shm_ring_t *ring)
+{
+	uint64_t head = ring->head;
+	shm_record_t *record = &ring->record[head & ring->mask];
+
+	return __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != head + 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory time difference.
+ *
+ * \return v0 - v1, or zero if v1 is later than v0.
+ */
+static env_time_t shm_time_sub(env_time_t v0, env_time_t v1)
+{
+	env_time_t tmp = {0};
+
+	if (!ENV_TIME_LT(v1, v0)) {
+		return tmp;
+	}
+	tmp.tv_sec = v0.tv_sec - v1.tv_sec;
+	tmp.tv_nsec = v0.tv_nsec - v1.tv_nsec;
+	if (tmp.tv_nsec < 0) {
+		tmp.tv_nsec += 1000000000L;
+		tmp.tv_sec--;
+	}
+	return tmp;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory batch done method.
+ *
+ * Posted after each batch with the latest baseline and deadline of the
+ * batch, lets the receiver drain the next one.
+ */
+static env_result_t shm_drained(posix_shm_t *self, void *arg)
+{
+	if (pthread_mutex_lock(&self->lock)) {
+		posix_panic("shm_drained(): Unable to aquire lock.\n");
+	}
+	self->pending = 0;
+	if (pthread_cond_signal(&self->signal)) {
+		posix_panic("shm_drained(): Unable to signal receiver.\n");
+	}
+	if (pthread_mutex_unlock(&self->lock)) {
+		posix_panic("shm_drained(): Unable to release lock.\n");
+	}
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory drain interrupt handler.
+ *
+ * Posts up to POSIX_SHM_BATCH records from the ring, they keep their
+ * absolute baseline and deadline.
+ */
+static void shm_interrupt_handler(int id)
+{
+	int i;
+	uint64_t head;
+	env_time_t bl, dl, end, base, last_bl = {0}, last_dl = {0};
+	shm_record_t *record;
+	shm_ring_t *ring;
+	posix_shm_t *shm = NULL;
+
+	for (i=0;i<POSIX_SHM_INBOXES;i++) {
+		if (shm_inboxes[i] && shm_inboxes[i]->interrupt == id) {
+			shm = shm_inboxes[i];
+			break;
+		}
+	}
+	assert(shm);
+
+	ring = shm->ring;
+	for (i=0;i<POSIX_SHM_BATCH && !shm_empty(ring);i++) {
+		head = ring->head;
+		record = &ring->record[head & ring->mask];
+
+		/*
+		 * The kernel computes baseline and deadline relative to the
+		 * time of the interrupt, zero means the interrupt time itself.
+		 */
+		base = ENV_TIMESTAMP();
+		bl = shm_time_sub(record->baseline, base);
+		if (ENV_TIME_LT(base, record->baseline)) {
+			base = record->baseline;
+		}
+		dl = shm_time_sub(record->deadline, base);
+		if (ENV_TIME_LT(last_bl, bl)) {
+			last_bl = bl;
+		}
+		end = shm_time_sub(record->deadline, ENV_TIMESTAMP());
+		if (ENV_TIME_LT(last_dl, end)) {
+			last_dl = end;
+		}
+
+		if (
+			record->id >= 0 &&
+			record->id < POSIX_SHM_EXPORTS &&
+			shm->exports[record->id].to
+			) {
+			tt_action(
+					bl,
+					dl,
+					shm->exports[record->id].to,
+					shm->exports[record->id].method,
+					record->arg.buf,
+					TT_ARGS_SIZE,
+					NULL
+					);
+		}
+
+		__atomic_store_n(&record->seq, head + ring->mask + 1, __ATOMIC_RELEASE);
+		ring->head = head + 1;
+	}
+
+	/*
+	 * Deadlines are ordered FIFO when equal, the batch will have run (or
+	 * at least been released) when this one runs.
+	 */
+	if (ENV_TIME_LT(last_dl, last_bl)) {
+		last_dl = last_bl;
+	}
+	tt_action(
+			last_bl,
+			shm_time_sub(last_dl, last_bl),
+			&shm->obj,
+			(tt_method_t)shm_drained,
+			TT_ARGS_NONE,
+			sizeof(*TT_ARGS_NONE),
+			NULL
+			);
+
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory receiver thread.
+ *
+ * Sleeps until there are records in the ring, then generates one interrupt
+ * and waits for it to drain the ring.
+ */
+static void *shm_receiver(void *data)
+{
+	sigset_t block;
+	uint32_t wake;
+	posix_shm_t *shm = data;
+	shm_ring_t *ring = shm->ring;
+
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("shm_receiver(): Unable to set sigmask.\n");
+	}
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (pthread_mutex_lock(&shm->lock)) {
+			posix_panic("shm_receiver(): Unable to aquire lock.\n");
+		}
+		while (shm->pending) {
+			if (pthread_cond_wait(&shm->signal, &shm->lock)) {
+				posix_panic("shm_receiver(): Unable to wait for drain.\n");
+			}
+		}
+		if (pthread_mutex_unlock(&shm->lock)) {
+			posix_panic("shm_receiver(): Unable to release lock.\n");
+		}
+
+		if (shm_empty(ring)) {
+			/*
+			 * Announce that we are going to sleep before the final
+			 * check, a sender that misses the flag must have posted
+			 * before the check.
+			 */
+			wake = __atomic_load_n(&ring->wake, __ATOMIC_SEQ_CST);
+			__atomic_store_n(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+			if (shm_empty(ring)) {
+				shm_futex(&ring->wake, FUTEX_WAIT, wake);
+			}
+			__atomic_store_n(&ring->sleeping, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+
+		shm->pending = 1;
+		posix_ext_interrupt_generate(shm->interrupt);
+	}
+
+	return NULL;
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory create an inbox.
+ *
+ * Should be called from the startup function. Any stale inbox with the
+ * same name is replaced.
+ *
+ * \note
+ *	Upon failure posix_panic() will be called.
+ *
+ * \param name The shared memory object name, such as "/app".
+ * \param slots The number of records, rounded up to a power of two.
+ * \param interrupt The interrupt id used for draining the inbox.
+ * \return The inbox.
+ */
+posix_shm_t *posix_shm_inbox(const char *name, int slots, int interrupt)
+{
+	int i;
+	uint32_t size = 1;
+	pthread_t thread;
+	posix_shm_t *shm;
+
+	assert(name);
+	assert(interrupt > 0);
+
+	while (size < (uint32_t)slots) {
+		size <<= 1;
+	}
+
+	shm = calloc(1, sizeof(*shm));
+	if (!shm) {
+		posix_panic("posix_shm_inbox(): Unable to allocate inbox.\n");
+	}
+
+	shm->ring = shm_map(name, size);
+	if (!shm->ring) {
+		posix_panic("posix_shm_inbox(): Unable to create shared memory.\n");
+	}
+	shm->ring->mask = size - 1;
+	for (i=0;i<size;i++) {
+		shm->ring->record[i].seq = i;
+	}
+	__atomic_store_n(&shm->ring->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	shm->interrupt = interrupt;
+	if (pthread_mutex_init(&shm->lock, NULL)) {
+		posix_panic("posix_shm_inbox(): Unable to initialize lock.\n");
+	}
+	if (pthread_cond_init(&shm->signal, NULL)) {
+		posix_panic("posix_shm_inbox(): Unable to initialize signal.\n");
+	}
+
+	for (i=0;i<POSIX_SHM_INBOXES;i++) {
+		if (!shm_inboxes[i]) {
+			shm_inboxes[i] = shm;
+			break;
+		}
+	}
+	if (i == POSIX_SHM_INBOXES) {
+		posix_panic("posix_shm_inbox(): Out of inboxes.\n");
+	}
+	posix_ext_interrupt_handler(interrupt, shm_interrupt_handler);
+
+	if (pthread_create(&thread, NULL, shm_receiver, shm)) {
+		posix_panic("posix_shm_inbox(): Unable to create receiver thread.\n");
+	}
+
+	return shm;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory connect to an inbox.
+ *
+ * \param name The name of the inbox.
+ * \return The sending end of the channel, NULL if the inbox does not
+ * exist (yet).
+ */
+posix_shm_t *posix_shm_connect(const char *name)
+{
+	posix_shm_t *shm;
+	shm_ring_t *ring;
+
+	assert(name);
+
+	ring = shm_map(name, 0);
+	if (!ring) {
+		return NULL;
+	}
+	if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC) {
+		munmap(ring, sizeof(*ring));
+		return NULL;
+	}
+
+	shm = calloc(1, sizeof(*shm));
+	if (!shm) {
+		posix_panic("posix_shm_connect(): Unable to allocate channel.\n");
+	}
+	shm->ring = ring;
+	shm->interrupt = -1;
+	return shm;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory unlink an inbox.
+ *
+ * Removes the name of an inbox created by this process, call it before
+ * exiting. The inbox keeps working for those already connected, no one
+ * else can connect to it.
+ *
+ * \param name The name of the inbox.
+ * \return zero upon success, otherwise -errno.
+ */
+int posix_shm_unlink(const char *name)
+{
+	assert(name);
+
+	if (shm_unlink(name)) {
+		return -errno;
+	}
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory export an object.
+ *
+ * \param shm The inbox.
+ * \param id The id remote proxies use.
+ * \param to The object.
+ * \param method The method invoked for every record with this id.
+ */
+void posix_shm_export(
+		posix_shm_t *shm,
+		int id,
+		tt_object_t *to,
+		tt_method_t method
+		)
+{
+	assert(shm);
+	assert(id >= 0 && id < POSIX_SHM_EXPORTS);
+
+	shm->exports[id].to = to;
+	shm->exports[id].method = method;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory send.
+ *
+ * Posts a record to the remote object of the proxy with the baseline and
+ * deadline of the running message (or the interrupt time).
+ *
+ * \param proxy The proxy.
+ * \param arg The argument.
+ * \param size The size of the argument, at most TT_ARGS_SIZE.
+ * \return zero upon success, non-zero if the ring was full.
+ */
+int posix_shm_send(posix_shm_proxy_t *proxy, const void *arg, size_t size)
+{
+	long dif;
+	uint64_t pos;
+	shm_record_t *record;
+	shm_ring_t *ring;
+
+	assert(proxy);
+	assert(proxy->shm);
+	assert(size <= TT_ARGS_SIZE);
+
+	ring = proxy->shm->ring;
+	pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	for (;;) {
+		record = &ring->record[pos & ring->mask];
+		dif = (long)(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - pos);
+		if (dif == 0) {
+			if (
+				__atomic_compare_exchange_n(
+					&ring->tail,
+					&pos,
+					pos + 1,
+					1,
+					__ATOMIC_RELAXED,
+					__ATOMIC_RELAXED
+					)
+				) {
+				break;
+			}
+		} else if (dif < 0) {
+			return 1;
+		} else {
+			pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	record->id = proxy->id;
+	record->baseline = tt_baseline();
+	record->deadline = tt_deadline();
+	if (arg != &tt_args_none) {
+		memcpy(record->arg.buf, arg, size);
+	}
+	__atomic_store_n(&record->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&ring->sleeping, __ATOMIC_SEQ_CST)) {
+		__atomic_add_fetch(&ring->wake, 1, __ATOMIC_SEQ_CST);
+		shm_futex(&ring->wake, FUTEX_WAKE, 1);
+	}
+
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory forward method.
+ *
+ * Post messages to a proxy with this method to forward them, for example
+ * TT_BEFORE(ENV_MSEC(5), &proxy, posix_shm_forward, &value). Waits for
+ * room if the remote ring is full.
+ *
+ * \param self The proxy.
+ * \param arg The argument buffer.
+ * \return Always zero.
+ */
+env_result_t posix_shm_forward(posix_shm_proxy_t *self, void *arg)
+{
+	while (posix_shm_send(self, arg, TT_ARGS_SIZE)) {
+		sched_yield();
+	}
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_SHM_H_
+#define ENV_POSIX_SHM_H_
+
+/* Standard C headers. */
+#include <stddef.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory number of exports per inbox.
+ */
+#ifndef POSIX_SHM_EXPORTS
+#	define POSIX_SHM_EXPORTS 32
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory channel typedef.
+ *
+ * Either the receiving end (inbox) or a sending end of a channel.
+ */
+typedef struct posix_shm_t posix_shm_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory proxy object.
+ *
+ * Stands in for an object exported by another process. Messages posted
+ * to the proxy with posix_shm_forward() as method are forwarded to the
+ * remote object with the baseline and deadline they had locally.
+ */
+typedef struct posix_shm_proxy_t
+{
+	/**
+	 * \brief The object, must be the first member.
+	 */
+	tt_object_t obj;
+
+	/**
+	 * \brief The sending end of the channel.
+	 */
+	posix_shm_t *shm;
+
+	/**
+	 * \brief The export id on the remote side.
+	 */
+	int id;
+} posix_shm_proxy_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX shared memory proxy "constructor".
+ */
+#define posix_shm_proxy(id) {tt_object(), NULL, id}
+
+/* ************************************************************************** */
+
+posix_shm_t *posix_shm_inbox(const char *, int, int);
+posix_shm_t *posix_shm_connect(const char *);
+int  posix_shm_unlink(const char *);
+void posix_shm_export(posix_shm_t *, int, tt_object_t *, tt_method_t);
+int  posix_shm_send(posix_shm_proxy_t *, const void *, size_t);
+env_result_t posix_shm_forward(posix_shm_proxy_t *, void *);
+
+#endif
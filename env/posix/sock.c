@@ -0,0 +1,807 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX socket message channel.
+ *
+ * Distributes objects across processes over a stream transport, tested
+ * with UNIX domain sockets. A listener exports objects by id, a remote
+ * process connects to it and posts messages to proxy objects. Every message
+ * is serialized as a fixed size frame holding the export id, the argument
+ * buffer and the time remaining until its baseline and deadline, the
+ * slack. The receiver adds the slack to the time of arrival, clocks of
+ * different hosts never have to agree.
+ *
+ * Frames are corked in a send buffer and written by a writer thread in
+ * one system call per batch, whatever accumulated while the previous write
+ * was in progress goes out with the next one. The listener reads as much
+ * as it can in one go and posts the frames from a pseudo interrupt.
+ *
+ * \note
+ *	Frames are in host byte order.
+ */
+
+/* Standard C headers. */
+#include <errno.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* POSIX/UNIX headers. */
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/sock.h>
+#include <posix/rt.h>
+
+/* tinyTimber headers. */
+#include <kernel.h>
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX socket maximum number of frames posted per drain.
+ *
+ * The next batch is not posted until the previous one has run, the kernel
+ * needs at least this many free messages.
+ */
+#ifndef POSIX_SOCK_BATCH
+#	define POSIX_SOCK_BATCH 8
+#endif
+
+/**
+ * \brief POSIX socket size of the send and receive buffers in frames.
+ */
+#ifndef POSIX_SOCK_FRAMES
+#	define POSIX_SOCK_FRAMES 256
+#endif
+
+/**
+ * \brief POSIX socket maximum number of listeners per process.
+ */
+#ifndef POSIX_SOCK_LISTENERS
+#	define POSIX_SOCK_LISTENERS 4
+#endif
+
+/**
+ * \brief POSIX socket maximum number of connections per listener.
+ */
+#ifndef POSIX_SOCK_CONNECTIONS
+#	define POSIX_SOCK_CONNECTIONS 8
+#endif
+
+/**
+ * \brief POSIX socket cork time in microseconds.
+ *
+ * How long the writer waits for more frames before writing a batch that
+ * did not fill the buffer, zero only batches what arrives while writing.
+ */
+#ifndef POSIX_SOCK_CORK
+#	define POSIX_SOCK_CORK 0
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief A serialized message.
+ *
+ * Baseline and deadline are absolute nanoseconds while in the send buffer
+ * and converted to slack right before they are written.
+ */
+typedef struct sock_frame_t
+{
+	int32_t id;
+	int32_t reserved;
+	int64_t baseline;
+	int64_t deadline;
+	union
+	{
+		char buf[TT_ARGS_SIZE];
+		void *___ptr;
+		long ___long;
+	} arg;
+} sock_frame_t;
+
+/**
+ * \brief A connection accepted by a listener.
+ */
+typedef struct sock_conn_t
+{
+	int fd;
+	size_t start;
+	size_t len;
+	char buf[POSIX_SOCK_FRAMES*sizeof(sock_frame_t)];
+} sock_conn_t;
+
+/**
+ * \brief A listener or a connection.
+ */
+struct posix_sock_t
+{
+	tt_object_t obj;
+	int fd;
+	pthread_mutex_t lock;
+	pthread_cond_t signal;
+
+	/* Listener. */
+	int interrupt;
+	int pending;
+	int next;
+	int count;
+	sock_frame_t inbox[POSIX_SOCK_BATCH];
+	sock_conn_t *conns[POSIX_SOCK_CONNECTIONS];
+	struct
+	{
+		tt_object_t *to;
+		tt_method_t method;
+	} exports[POSIX_SOCK_EXPORTS];
+
+	/* Connection. */
+	pthread_cond_t space;
+	int queued;
+	sock_frame_t *out;
+	sock_frame_t *spare;
+};
+
+/* ************************************************************************** */
+
+/*
+ * Internal state variables etc.
+ */
+static posix_sock_t *sock_listeners[POSIX_SOCK_LISTENERS];
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket time to nanoseconds.
+ */
+static int64_t sock_ns(env_time_t time)
+{
+	return time.tv_sec*1000000000LL + time.tv_nsec;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket nanoseconds to time, negative values become zero.
+ */
+static env_time_t sock_time(int64_t ns)
+{
+	env_time_t tmp = {0};
+
+	if (ns > 0) {
+		tmp.tv_sec = ns/1000000000LL;
+		tmp.tv_nsec = ns%1000000000LL;
+	}
+	return tmp;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket block all signals in a helper thread.
+ */
+static void sock_sigmask(void)
+{
+	sigset_t block;
+
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("sock_sigmask(): Unable to set sigmask.\n");
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket common initialization.
+ */
+static posix_sock_t *sock_alloc(int fd)
+{
+	posix_sock_t *sock = calloc(1, sizeof(*sock));
+
+	if (!sock) {
+		posix_panic("sock_alloc(): Unable to allocate socket.\n");
+	}
+	sock->fd = fd;
+	if (pthread_mutex_init(&sock->lock, NULL)) {
+		posix_panic("sock_alloc(): Unable to initialize lock.\n");
+	}
+	if (
+		pthread_cond_init(&sock->signal, NULL) ||
+		pthread_cond_init(&sock->space, NULL)
+		) {
+		posix_panic("sock_alloc(): Unable to initialize signal.\n");
+	}
+	return sock;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket batch done method.
+ *
+ * Posted after each batch with the latest baseline and deadline of the
+ * batch, lets the receiver post the next one.
+ */
+static env_result_t sock_drained(posix_sock_t *self, void *arg)
+{
+	if (pthread_mutex_lock(&self->lock)) {
+		posix_panic("sock_drained(): Unable to aquire lock.\n");
+	}
+	self->pending = 0;
+	if (pthread_cond_signal(&self->signal)) {
+		posix_panic("sock_drained(): Unable to signal receiver.\n");
+	}
+	if (pthread_mutex_unlock(&self->lock)) {
+		posix_panic("sock_drained(): Unable to release lock.\n");
+	}
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket drain interrupt handler.
+ *
+ * Posts the frames collected by the receiver, relative to the time of the
+ * interrupt.
+ */
+static void sock_interrupt_handler(int id)
+{
+	int i;
+	int64_t bl_ns, dl_ns, last_bl = 0, last_dl = 0;
+	sock_frame_t *frame;
+	posix_sock_t *sock = NULL;
+
+	for (i=0;i<POSIX_SOCK_LISTENERS;i++) {
+		if (sock_listeners[i] && sock_listeners[i]->interrupt == id) {
+			sock = sock_listeners[i];
+			break;
+		}
+	}
+	assert(sock);
+
+	for (i=0;i<sock->count;i++) {
+		frame = &sock->inbox[i];
+
+		bl_ns = frame->baseline > 0 ? frame->baseline : 0;
+		dl_ns = frame->deadline - bl_ns;
+		if (bl_ns > last_bl) {
+			last_bl = bl_ns;
+		}
+		if (frame->deadline > last_dl) {
+			last_dl = frame->deadline;
+		}
+
+		if (
+			frame->id >= 0 &&
+			frame->id < POSIX_SOCK_EXPORTS &&
+			sock->exports[frame->id].to
+			) {
+			tt_action(
+					sock_time(bl_ns),
+					sock_time(dl_ns),
+					sock->exports[frame->id].to,
+					sock->exports[frame->id].method,
+					frame->arg.buf,
+					TT_ARGS_SIZE,
+					NULL
+					);
+		}
+	}
+	sock->count = 0;
+
+	/*
+	 * Deadlines are ordered FIFO when equal, the batch will have run (or
+	 * at least been released) when this one runs.
+	 */
+	tt_action(
+			sock_time(last_bl),
+			sock_time(last_dl - last_bl),
+			&sock->obj,
+			(tt_method_t)sock_drained,
+			TT_ARGS_NONE,
+			sizeof(*TT_ARGS_NONE),
+			NULL
+			);
+
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket move complete frames into the inbox.
+ *
+ * Takes turns between the connections so that none of them can starve the
+ * others.
+ */
+static void sock_collect(posix_sock_t *sock)
+{
+	int i, n;
+	sock_conn_t *conn;
+
+	for (n=0;n<POSIX_SOCK_CONNECTIONS;n++) {
+		i = (sock->next + n)%POSIX_SOCK_CONNECTIONS;
+		conn = sock->conns[i];
+		if (!conn) {
+			continue;
+		}
+
+		while (
+			sock->count < POSIX_SOCK_BATCH &&
+			conn->len - conn->start >= sizeof(sock_frame_t)
+			) {
+			memcpy(
+					&sock->inbox[sock->count++],
+					&conn->buf[conn->start],
+					sizeof(sock_frame_t)
+					);
+			conn->start += sizeof(sock_frame_t);
+		}
+
+		if (sock->count == POSIX_SOCK_BATCH) {
+			break;
+		}
+	}
+	sock->next = (sock->next + 1)%POSIX_SOCK_CONNECTIONS;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket read from a connection.
+ *
+ * \return zero upon success, non-zero if the connection was closed.
+ */
+static int sock_read(sock_conn_t *conn)
+{
+	ssize_t ret;
+
+	if (conn->start) {
+		memmove(conn->buf, &conn->buf[conn->start], conn->len - conn->start);
+		conn->len -= conn->start;
+		conn->start = 0;
+	}
+
+	do {
+		ret = read(conn->fd, &conn->buf[conn->len], sizeof(conn->buf) - conn->len);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret <= 0) {
+		return 1;
+	}
+	conn->len += ret;
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket listener receiver thread.
+ *
+ * Accepts connections, reads frames and generates one interrupt per batch,
+ * then waits until the batch has run.
+ */
+static void *sock_receiver(void *data)
+{
+	int i, fd, nfds;
+	posix_sock_t *sock = data;
+	struct pollfd fds[POSIX_SOCK_CONNECTIONS + 1];
+	int index[POSIX_SOCK_CONNECTIONS + 1];
+
+	sock_sigmask();
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		if (pthread_mutex_lock(&sock->lock)) {
+			posix_panic("sock_receiver(): Unable to aquire lock.\n");
+		}
+		while (sock->pending) {
+			if (pthread_cond_wait(&sock->signal, &sock->lock)) {
+				posix_panic("sock_receiver(): Unable to wait for drain.\n");
+			}
+		}
+		sock_collect(sock);
+		if (sock->count) {
+			sock->pending = 1;
+		}
+		if (pthread_mutex_unlock(&sock->lock)) {
+			posix_panic("sock_receiver(): Unable to release lock.\n");
+		}
+
+		if (sock->pending) {
+			posix_ext_interrupt_generate(sock->interrupt);
+			continue;
+		}
+
+		/* Nothing buffered, wait for more. */
+		nfds = 0;
+		fds[nfds].fd = sock->fd;
+		fds[nfds].events = POLLIN;
+		index[nfds++] = -1;
+		for (i=0;i<POSIX_SOCK_CONNECTIONS;i++) {
+			if (sock->conns[i]) {
+				fds[nfds].fd = sock->conns[i]->fd;
+				fds[nfds].events = POLLIN;
+				index[nfds++] = i;
+			}
+		}
+
+		if (poll(fds, nfds, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			posix_panic("sock_receiver(): Unable to poll.\n");
+		}
+
+		for (i=1;i<nfds;i++) {
+			if (!fds[i].revents) {
+				continue;
+			}
+			if (sock_read(sock->conns[index[i]])) {
+				close(sock->conns[index[i]]->fd);
+				free(sock->conns[index[i]]);
+				sock->conns[index[i]] = NULL;
+			}
+		}
+
+		if (fds[0].revents & POLLIN) {
+			fd = accept(sock->fd, NULL, NULL);
+			if (fd < 0) {
+				continue;
+			}
+			for (i=0;i<POSIX_SOCK_CONNECTIONS;i++) {
+				if (!sock->conns[i]) {
+					break;
+				}
+			}
+			if (i == POSIX_SOCK_CONNECTIONS) {
+				close(fd);
+				continue;
+			}
+			sock->conns[i] = calloc(1, sizeof(sock_conn_t));
+			if (!sock->conns[i]) {
+				posix_panic("sock_receiver(): Unable to allocate connection.\n");
+			}
+			sock->conns[i]->fd = fd;
+		}
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket connection writer thread.
+ *
+ * Writes everything that was queued since the last write in one go.
+ */
+static void *sock_writer(void *data)
+{
+	int i, n;
+	ssize_t ret;
+	size_t done, size;
+	int64_t now;
+	sock_frame_t *frames;
+	posix_sock_t *sock = data;
+
+	sock_sigmask();
+	posix_rt_thread(POSIX_RT_NONE);
+
+	for (;;) {
+		if (pthread_mutex_lock(&sock->lock)) {
+			posix_panic("sock_writer(): Unable to aquire lock.\n");
+		}
+		while (!sock->queued) {
+			if (pthread_cond_wait(&sock->signal, &sock->lock)) {
+				posix_panic("sock_writer(): Unable to wait for frames.\n");
+			}
+		}
+
+#if POSIX_SOCK_CORK > 0
+		if (sock->queued < POSIX_SOCK_FRAMES) {
+			pthread_mutex_unlock(&sock->lock);
+			usleep(POSIX_SOCK_CORK);
+			pthread_mutex_lock(&sock->lock);
+		}
+#endif
+
+		frames = sock->out;
+		n = sock->queued;
+		sock->out = sock->spare;
+		sock->spare = frames;
+		sock->queued = 0;
+
+		if (pthread_cond_broadcast(&sock->space)) {
+			posix_panic("sock_writer(): Unable to signal senders.\n");
+		}
+		if (pthread_mutex_unlock(&sock->lock)) {
+			posix_panic("sock_writer(): Unable to release lock.\n");
+		}
+
+		/* Time spent in the buffer is time lost, account for it. */
+		now = sock_ns(posix_timer_get());
+		for (i=0;i<n;i++) {
+			frames[i].baseline -= now;
+			frames[i].deadline -= now;
+		}
+
+		size = n*sizeof(sock_frame_t);
+		for (done=0;done<size;done+=ret) {
+			ret = write(sock->fd, (char *)frames + done, size - done);
+			if (ret < 0) {
+				if (errno == EINTR) {
+					ret = 0;
+					continue;
+				}
+				posix_panic("sock_writer(): Unable to write.\n");
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket create a listener.
+ *
+ * Should be called from the startup function. Any stale socket file at
+ * path is removed.
+ *
+ * \note
+ *	Upon failure posix_panic() will be called.
+ *
+ * \param path The path of the UNIX domain socket.
+ * \param interrupt The interrupt id used for posting received messages.
+ * \return The listener.
+ */
+posix_sock_t *posix_sock_listen(const char *path, int interrupt)
+{
+	int i, fd;
+	pthread_t thread;
+	posix_sock_t *sock;
+	struct sockaddr_un addr;
+
+	assert(path);
+	assert(interrupt > 0);
+	assert(strlen(path) < sizeof(addr.sun_path));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		posix_panic("posix_sock_listen(): Unable to create socket.\n");
+	}
+	unlink(path);
+	if (
+		bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+		listen(fd, POSIX_SOCK_CONNECTIONS)
+		) {
+		posix_panic("posix_sock_listen(): Unable to listen.\n");
+	}
+
+	sock = sock_alloc(fd);
+	sock->interrupt = interrupt;
+
+	for (i=0;i<POSIX_SOCK_LISTENERS;i++) {
+		if (!sock_listeners[i]) {
+			sock_listeners[i] = sock;
+			break;
+		}
+	}
+	if (i == POSIX_SOCK_LISTENERS) {
+		posix_panic("posix_sock_listen(): Out of listeners.\n");
+	}
+	posix_ext_interrupt_handler(interrupt, sock_interrupt_handler);
+
+	if (pthread_create(&thread, NULL, sock_receiver, sock)) {
+		posix_panic("posix_sock_listen(): Unable to create receiver thread.\n");
+	}
+
+	return sock;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket connect to a listener.
+ *
+ * \param path The path of the UNIX domain socket.
+ * \return The connection, NULL if nobody is listening (yet).
+ */
+posix_sock_t *posix_sock_connect(const char *path)
+{
+	int fd;
+	pthread_t thread;
+	posix_sock_t *sock;
+	struct sockaddr_un addr;
+
+	assert(path);
+	assert(strlen(path) < sizeof(addr.sun_path));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		posix_panic("posix_sock_connect(): Unable to create socket.\n");
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(fd);
+		return NULL;
+	}
+
+	sock = sock_alloc(fd);
+	sock->out = calloc(POSIX_SOCK_FRAMES, sizeof(sock_frame_t));
+	sock->spare = calloc(POSIX_SOCK_FRAMES, sizeof(sock_frame_t));
+	if (!sock->out || !sock->spare) {
+		posix_panic("posix_sock_connect(): Unable to allocate buffers.\n");
+	}
+
+	if (pthread_create(&thread, NULL, sock_writer, sock)) {
+		posix_panic("posix_sock_connect(): Unable to create writer thread.\n");
+	}
+
+	return sock;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket export an object.
+ *
+ * \param sock The listener.
+ * \param id The id remote proxies use.
+ * \param to The object.
+ * \param method The method invoked for every frame with this id.
+ */
+void posix_sock_export(
+		posix_sock_t *sock,
+		int id,
+		tt_object_t *to,
+		tt_method_t method
+		)
+{
+	assert(sock);
+	assert(id >= 0 && id < POSIX_SOCK_EXPORTS);
+
+	sock->exports[id].to = to;
+	sock->exports[id].method = method;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket send.
+ *
+ * Queues a frame for the remote object of the proxy with the baseline and
+ * deadline of the running message (or the interrupt time).
+ *
+ * \param proxy The proxy.
+ * \param arg The argument.
+ * \param size The size of the argument, at most TT_ARGS_SIZE.
+ * \return zero upon success, non-zero if the send buffer was full.
+ */
+int posix_sock_send(posix_sock_proxy_t *proxy, const void *arg, size_t size)
+{
+	int ret = 1;
+	int protected = ENV_ISPROTECTED();
+	env_time_t baseline = tt_baseline();
+	env_time_t deadline = tt_deadline();
+	posix_sock_t *sock;
+	sock_frame_t *frame;
+
+	assert(proxy);
+	assert(proxy->sock);
+	assert(size <= TT_ARGS_SIZE);
+
+	sock = proxy->sock;
+
+	/* Not to be preempted while holding the lock. */
+	ENV_PROTECT(1);
+	if (pthread_mutex_lock(&sock->lock)) {
+		posix_panic("posix_sock_send(): Unable to aquire lock.\n");
+	}
+
+	if (sock->queued < POSIX_SOCK_FRAMES) {
+		frame = &sock->out[sock->queued++];
+		frame->id = proxy->id;
+		frame->baseline = sock_ns(baseline);
+		frame->deadline = sock_ns(deadline);
+		if (arg != &tt_args_none) {
+			memcpy(frame->arg.buf, arg, size);
+		}
+
+		if (sock->queued == 1 && pthread_cond_signal(&sock->signal)) {
+			posix_panic("posix_sock_send(): Unable to signal writer.\n");
+		}
+		ret = 0;
+	}
+
+	if (pthread_mutex_unlock(&sock->lock)) {
+		posix_panic("posix_sock_send(): Unable to release lock.\n");
+	}
+	ENV_PROTECT(protected);
+
+	return ret;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket forward method.
+ *
+ * Post messages to a proxy with this method to forward them, for example
+ * TT_BEFORE(ENV_MSEC(5), &proxy, posix_sock_forward, &value). Waits for
+ * the writer if the send buffer is full.
+ *
+ * \param self The proxy.
+ * \param arg The argument buffer.
+ * \return Always zero.
+ */
+env_result_t posix_sock_forward(posix_sock_proxy_t *self, void *arg)
+{
+	posix_sock_t *sock = self->sock;
+
+	while (posix_sock_send(self, arg, TT_ARGS_SIZE)) {
+		if (pthread_mutex_lock(&sock->lock)) {
+			posix_panic("posix_sock_forward(): Unable to aquire lock.\n");
+		}
+		while (sock->queued == POSIX_SOCK_FRAMES) {
+			if (pthread_cond_wait(&sock->space, &sock->lock)) {
+				posix_panic("posix_sock_forward(): Unable to wait for space.\n");
+			}
+		}
+		if (pthread_mutex_unlock(&sock->lock)) {
+			posix_panic("posix_sock_forward(): Unable to release lock.\n");
+		}
+	}
+	return 0;
+}
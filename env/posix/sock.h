@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_SOCK_H_
+#define ENV_POSIX_SOCK_H_
+
+/* Standard C headers. */
+#include <stddef.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket number of exports per listener.
+ */
+#ifndef POSIX_SOCK_EXPORTS
+#	define POSIX_SOCK_EXPORTS 32
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket channel typedef.
+ *
+ * Either a listener, the receiving end, or a connection to one.
+ */
+typedef struct posix_sock_t posix_sock_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket proxy object.
+ *
+ * Stands in for an object exported by a listener in another process.
+ * Messages posted to the proxy with posix_sock_forward() as method are
+ * invoked upon the remote object, the remaining time until the baseline
+ * and the deadline are carried as relative slack.
+ */
+typedef struct posix_sock_proxy_t
+{
+	/**
+	 * \brief The object, must be the first member.
+	 */
+	tt_object_t obj;
+
+	/**
+	 * \brief The connection.
+	 */
+	posix_sock_t *sock;
+
+	/**
+	 * \brief The export id on the remote side.
+	 */
+	int id;
+} posix_sock_proxy_t;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX socket proxy "constructor".
+ */
+#define posix_sock_proxy(id) {tt_object(), NULL, id}
+
+/* ************************************************************************** */
+
+posix_sock_t *posix_sock_listen(const char *, int);
+posix_sock_t *posix_sock_connect(const char *);
+void posix_sock_export(posix_sock_t *, int, tt_object_t *, tt_method_t);
+int  posix_sock_send(posix_sock_proxy_t *, const void *, size_t);
+env_result_t posix_sock_forward(posix_sock_proxy_t *, void *);
+
+#endif
@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief POSIX interrupt stress harness.
+ *
+ * Enabled by defining POSIX_STRESS (make STRESS=yes). Source threads raise
+ * interrupts on their lines at a given rate, in bursts of back to back
+ * interrupts. The sources are configured by the POSIX_STRESS environment
+ * variable, a comma separated list of
+ *
+ *	line[:rate[:burst[:pattern]]]
+ *
+ * where rate is the number of arrivals per second (0, the default, raises
+ * them back to back), burst the number of interrupts per arrival (1) and
+ * pattern p for periodic arrivals (the default) or x for exponentially
+ * distributed interarrival times. Without the variable the three highest
+ * lines are raised back to back.
+ *
+ * The source lines that have no handler of their own post one message per
+ * interrupt, at most POSIX_STRESS_OUTSTANDING at a time per line. For all
+ * lines the harness records the latency from raising the interrupt to its
+ * handler, and for the messages to their dispatch, in nanoseconds. The
+ * report is written at exit to the file named by POSIX_STRESS_REPORT, or
+ * stderr.
+ */
+
+/* Standard C headers. */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* POSIX/UNIX headers. */
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+
+/* Environment headers. */
+#include <posix/env.h>
+#include <posix/stress.h>
+#include <posix/rt.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+#include <stats.h>
+
+#if defined POSIX_STRESS
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief POSIX stress interrupt source.
+ */
+typedef struct stress_source_t
+{
+	int line;
+	unsigned long rate;
+	int burst;
+	int poisson;
+	unsigned long long seed;
+	unsigned long raised;
+	pthread_t thread;
+} stress_source_t;
+
+/**
+ * \brief POSIX stress interrupt line.
+ */
+typedef struct stress_line_t
+{
+	tt_object_t obj;
+	env_time_t raised;
+	int outstanding;
+	unsigned long handled;
+	unsigned long dispatched;
+	unsigned long dropped;
+	tt_histogram_t handler;
+	tt_histogram_t dispatch;
+} stress_line_t;
+
+/*
+ * Internal state variables etc.
+ */
+static stress_source_t stress_source[POSIX_STRESS_MAX_SOURCES];
+static int stress_sources;
+static stress_line_t stress_line[POSIX_NUM_INTERRUPTS];
+static env_time_t stress_start;
+static int stress_started;
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress message, the interrupt reached the kernel.
+ */
+static env_result_t stress_dispatch(stress_line_t *self, long *raised)
+{
+	env_time_t now = ENV_TIMER_GET();
+	long latency = now.tv_sec*1000000000L + now.tv_nsec - *raised;
+
+	ENV_PROTECT(1);
+	self->outstanding--;
+	self->dispatched++;
+	tt_histogram_add(&self->dispatch, latency < 0 ? 0 : (unsigned long)latency);
+	ENV_PROTECT(0);
+
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress default interrupt handler.
+ */
+static void stress_interrupt(int id)
+{
+	stress_line_t *line = &stress_line[id];
+	long raised;
+
+	if (line->outstanding >= POSIX_STRESS_OUTSTANDING) {
+		line->dropped++;
+		return;
+	}
+
+	/* The raise time in nanoseconds, a timespec does not fit TT_ARGS_SIZE. */
+	raised = line->raised.tv_sec*1000000000L + line->raised.tv_nsec;
+
+	line->outstanding++;
+	TT_BEFORE(
+			ENV_USEC(POSIX_STRESS_DEADLINE),
+			line,
+			stress_dispatch,
+			&raised
+			);
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress natural logarithm.
+ *
+ * The applications link the environment without libm, u is scaled into
+ * [0.5, 1] and the atanh series converges in a few terms.
+ *
+ * \param u The value, in (0, 1].
+ * \return ln(u).
+ */
+static double stress_log(double u)
+{
+	int i, k = 0;
+	double z, z2, term, sum = 0.0;
+
+	while (u < 0.5) {
+		u *= 2.0;
+		k++;
+	}
+
+	z = (u - 1.0) / (u + 1.0);
+	z2 = z*z;
+	term = z;
+	for (i=1;i<24;i+=2) {
+		sum += term / i;
+		term *= z2;
+	}
+
+	return 2.0*sum - k*0.69314718055994530942;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress time until the next arrival of a source.
+ *
+ * \param source The source.
+ * \return The interarrival time in nanoseconds.
+ */
+static long stress_interarrival(stress_source_t *source)
+{
+	double u;
+
+	if (!source->poisson) {
+		return 1000000000L / (long)source->rate;
+	}
+
+	/* xorshift64*, uniform in (0, 1]. */
+	source->seed ^= source->seed >> 12;
+	source->seed ^= source->seed << 25;
+	source->seed ^= source->seed >> 27;
+	u = ((source->seed * 2685821657736338717ULL) >> 11) + 1.0;
+	u /= 9007199254740992.0;
+
+	return (long)(-stress_log(u) * 1e9 / (double)source->rate);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress source thread.
+ */
+static void *stress_thread(void *data)
+{
+	int i;
+	long interval;
+	sigset_t block;
+	struct timespec next = {0, 0};
+	stress_source_t *source = data;
+
+	/* Sources must never receive the interrupt or timer signals. */
+	sigfillset(&block);
+	if (pthread_sigmask(SIG_BLOCK, &block, NULL)) {
+		posix_panic("stress_thread(): Unable to set sigmask.\n");
+	}
+	posix_rt_thread(POSIX_RT_INTERRUPT);
+
+	for (;;) {
+		for (i=0;i<source->burst;i++) {
+			posix_ext_interrupt_generate(source->line);
+			source->raised++;
+		}
+
+		if (!source->rate) {
+			continue;
+		}
+
+		/* The first arrival is whenever the kernel is up and running. */
+		if (!next.tv_sec && !next.tv_nsec) {
+			clock_gettime(CLOCK_MONOTONIC, &next);
+		}
+
+		interval = stress_interarrival(source);
+		next.tv_sec += interval / 1000000000L;
+		next.tv_nsec += interval % 1000000000L;
+		if (next.tv_nsec >= 1000000000L) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+
+		while (
+				clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) ==
+				EINTR
+			  );
+	}
+
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress source parser.
+ *
+ * \param spec The source, line[:rate[:burst[:pattern]]].
+ * \param source The source to fill in.
+ * \return A pointer past the source.
+ */
+static const char *stress_parse(const char *spec, stress_source_t *source)
+{
+	char *end;
+
+	source->line = (int)strtol(spec, &end, 10);
+	source->rate = 0;
+	source->burst = 1;
+	source->poisson = 0;
+
+	if (end == spec || source->line < 1 || source->line >= POSIX_NUM_INTERRUPTS) {
+		posix_panic("posix_stress_init(): Invalid interrupt line.\n");
+	}
+	if (*end == ':') {
+		source->rate = strtoul(end + 1, &end, 10);
+	}
+	if (*end == ':') {
+		source->burst = (int)strtol(end + 1, &end, 10);
+		if (source->burst < 1) {
+			posix_panic("posix_stress_init(): Invalid burst.\n");
+		}
+	}
+	if (*end == ':') {
+		end++;
+		if (*end == 'x') {
+			source->poisson = 1;
+		} else if (*end != 'p') {
+			posix_panic("posix_stress_init(): Invalid pattern.\n");
+		}
+		end++;
+	}
+	if (*end && *end != ',') {
+		posix_panic("posix_stress_init(): Invalid source.\n");
+	}
+
+	return *end ? end + 1 : end;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress histogram print.
+ */
+static void stress_print(
+		FILE *file,
+		int line,
+		const char *name,
+		tt_histogram_t *histogram
+		)
+{
+	if (!histogram->total) {
+		return;
+	}
+
+	fprintf(
+			file,
+			"stress line=%d %s count=%lu"
+			" min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			line,
+			name,
+			histogram->total,
+			histogram->min,
+			tt_histogram_mean(histogram),
+			tt_histogram_percentile(histogram, 500),
+			tt_histogram_percentile(histogram, 900),
+			tt_histogram_percentile(histogram, 990),
+			tt_histogram_percentile(histogram, 999),
+			histogram->max
+			);
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress init function.
+ *
+ * Parses the sources, installs the default handler on their lines and
+ * starts them. The sources hold their first interrupt until the kernel is
+ * up and running, handlers installed by the application replace the
+ * default one.
+ */
+void posix_stress_init(void)
+{
+	int i;
+	const char *spec = getenv("POSIX_STRESS");
+	stress_source_t *source;
+
+	if (!spec) {
+		for (i=0;i<3 && i<POSIX_NUM_INTERRUPTS-1;i++) {
+			stress_source[i].line = POSIX_NUM_INTERRUPTS - 1 - i;
+			stress_source[i].burst = 1;
+		}
+		stress_sources = i;
+	} else {
+		while (*spec) {
+			if (stress_sources == POSIX_STRESS_MAX_SOURCES) {
+				posix_panic("posix_stress_init(): Too many sources.\n");
+			}
+			spec = stress_parse(spec, &stress_source[stress_sources++]);
+		}
+	}
+
+	for (i=0;i<stress_sources;i++) {
+		source = &stress_source[i];
+		source->seed = 0x9e3779b97f4a7c15ULL * (unsigned long long)(i + 1);
+		posix_ext_interrupt_handler(source->line, stress_interrupt);
+		if (pthread_create(&source->thread, NULL, stress_thread, source)) {
+			posix_panic("posix_stress_init(): Unable to create source thread.\n");
+		}
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress interrupt entry.
+ *
+ * Called by the interrupt handler in protected mode for every interrupt.
+ *
+ * \param id The interrupt id.
+ * \param raised The time the interrupt was raised.
+ * \param now The time the handler was entered.
+ */
+void posix_stress_raised(int id, const env_time_t *raised, const env_time_t *now)
+{
+	long latency = ENV_TIME_DIFF(*now, *raised);
+	stress_line_t *line = &stress_line[id];
+
+	if (!stress_started) {
+		stress_start = *now;
+		stress_started = 1;
+	}
+
+	line->raised = *raised;
+	line->handled++;
+	tt_histogram_add(&line->handler, latency < 0 ? 0 : (unsigned long)latency);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX stress report at exit.
+ *
+ * One summary line with the overall throughput per second, one line per
+ * source and per interrupt line with its counters and latency histograms.
+ */
+void posix_stress_exit(void)
+{
+	int i;
+	long duration;
+	env_time_t now = ENV_TIMER_GET();
+	unsigned long handled = 0, dispatched = 0, dropped = 0;
+	stress_source_t *source;
+	stress_line_t *line;
+	FILE *file = stderr;
+
+	if (
+			getenv("POSIX_STRESS_REPORT") &&
+			!(file = fopen(getenv("POSIX_STRESS_REPORT"), "w"))
+	   ) {
+		return;
+	}
+
+	duration = stress_started ? ENV_TIME_DIFF(now, stress_start) : 0;
+	for (i=0;i<POSIX_NUM_INTERRUPTS;i++) {
+		handled += stress_line[i].handled;
+		dispatched += stress_line[i].dispatched;
+		dropped += stress_line[i].dropped;
+	}
+
+	fprintf(
+			file,
+			"stress duration=%ld handled=%lu dispatched=%lu dropped=%lu"
+			" handled_rate=%.0f dispatch_rate=%.0f\n",
+			duration,
+			handled,
+			dispatched,
+			dropped,
+			duration > 0 ? handled * 1e9 / duration : 0.0,
+			duration > 0 ? dispatched * 1e9 / duration : 0.0
+			);
+
+	for (i=0;i<stress_sources;i++) {
+		source = &stress_source[i];
+		fprintf(
+				file,
+				"stress source=%d line=%d rate=%lu burst=%d pattern=%c"
+				" raised=%lu\n",
+				i,
+				source->line,
+				source->rate,
+				source->burst,
+				source->poisson ? 'x' : 'p',
+				source->raised
+				);
+	}
+
+	for (i=0;i<POSIX_NUM_INTERRUPTS;i++) {
+		line = &stress_line[i];
+		if (!line->handled) {
+			continue;
+		}
+		fprintf(
+				file,
+				"stress line=%d handled=%lu dispatched=%lu dropped=%lu\n",
+				i,
+				line->handled,
+				line->dispatched,
+				line->dropped
+				);
+		stress_print(file, i, "handler", &line->handler);
+		stress_print(file, i, "dispatch", &line->dispatch);
+	}
+
+	if (file != stderr) {
+		fclose(file);
+	}
+}
+
+#endif /* POSIX_STRESS */
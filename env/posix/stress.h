@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENV_POSIX_STRESS_H_
+#define ENV_POSIX_STRESS_H_
+
+/* Environment headers. */
+#include <types.h>
+
+/* ************************************************************************** */
+
+#if defined POSIX_STRESS
+
+#ifndef POSIX_STRESS_MAX_SOURCES
+	/**
+	 * \brief POSIX stress maximum number of interrupt sources.
+	 */
+#	define POSIX_STRESS_MAX_SOURCES 8
+#endif
+
+#ifndef POSIX_STRESS_DEADLINE
+	/**
+	 * \brief POSIX stress relative deadline of the messages posted by the
+	 * default handler, in microseconds.
+	 */
+#	define POSIX_STRESS_DEADLINE 1000
+#endif
+
+#ifndef POSIX_STRESS_OUTSTANDING
+	/**
+	 * \brief POSIX stress maximum number of messages a line of the default
+	 * handler keeps outstanding, further interrupts are dropped.
+	 */
+#	define POSIX_STRESS_OUTSTANDING 4
+#endif
+
+void posix_stress_init(void);
+void posix_stress_raised(int, const env_time_t *, const env_time_t *);
+void posix_stress_exit(void);
+
+#else
+
+/** \cond */
+#	define posix_stress_init()
+#	define posix_stress_raised(id, raised, now)
+/** \endcond */
+
+#endif
+
+#endif
@@ -127,8 +127,8 @@ typedef struct timespec env_time_t;
  */
 #define ENV_TIME_LE(v0, v1) \
 	(\
-	 ((v0).tv_sec <= (v1).tv_sec) &&\
-	 ((v0).tv_nsec <= (v1).tv_nsec)\
+	 ((v0).tv_sec < (v1).tv_sec) ||\
+	 (((v0).tv_sec == (v1).tv_sec) && ((v0).tv_nsec <= (v1).tv_nsec))\
 	 )
 
 /* ************************************************************************** */
@@ -141,6 +141,25 @@ typedef struct timespec env_time_t;
 
 /* ************************************************************************** */
 
+/**
+ * \brief POSIX time subtract macro, v0 - v1 with v0 >= v1.
+ */
+#define ENV_TIME_SUB(v0, v1) \
+	posix_time_sub(&v0, &v1)
+
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX time difference macro, v0 - v1 in nanoseconds.
+ */
+#define ENV_TIME_DIFF(v0, v1) \
+	(\
+	 ((long)(v0).tv_sec - (long)(v1).tv_sec)*1000000000L +\
+	 ((v0).tv_nsec - (v1).tv_nsec)\
+	 )
+
+/* ************************************************************************** */
+
 /**
  * \brief POSIX time inherit value.
  */
@@ -185,9 +204,9 @@ static inline env_time_t posix_time_add(
 		)
 {
 	env_time_t tmp;
-	if ((v0->tv_nsec + v1->tv_nsec) > 1000000000UL) {
+	if ((v0->tv_nsec + v1->tv_nsec) >= 1000000000L) {
 		tmp.tv_sec = v0->tv_sec + v1->tv_sec + 1;
-		tmp.tv_nsec = v0->tv_nsec + v1->tv_nsec - 1000000000UL;
+		tmp.tv_nsec = v0->tv_nsec + v1->tv_nsec - 1000000000L;
 	} else {
 		tmp.tv_sec = v0->tv_sec + v1->tv_sec;
 		tmp.tv_nsec = v0->tv_nsec + v1->tv_nsec;
@@ -195,4 +214,29 @@ static inline env_time_t posix_time_add(
 	return tmp;
 }
 
+/* ************************************************************************** */
+
+/**
+ * \brief POSIX time subtract function.
+ *
+ * \param v0 First value.
+ * \param v1 Second value, not larger than v0.
+ * \return v0 - v1.
+ */
+static inline env_time_t posix_time_sub(
+		env_time_t *v0,
+		env_time_t *v1
+		)
+{
+	env_time_t tmp;
+	if (v0->tv_nsec < v1->tv_nsec) {
+		tmp.tv_sec = v0->tv_sec - v1->tv_sec - 1;
+		tmp.tv_nsec = v0->tv_nsec - v1->tv_nsec + 1000000000L;
+	} else {
+		tmp.tv_sec = v0->tv_sec - v1->tv_sec;
+		tmp.tv_nsec = v0->tv_nsec - v1->tv_nsec;
+	}
+	return tmp;
+}
+
 #endif
@@ -38,6 +38,9 @@
 
 #include <env.h>
 #include <kernel_srp.h>
+#include <trace.h>
+#include <stats.h>
+#include <record.h>
 
 /* ************************************************************************** */
 
@@ -52,6 +55,9 @@ static pthread_t root;
  */
 int posix_srp_protected;
 env_time_t posix_srp_timer_timestamp;
+#if defined TT_RECORD
+env_time_t posix_srp_timer_armed;
+#endif
 timer_t posix_srp_timer;
 env_time_t posix_time_inherit = {0};
 
@@ -59,9 +65,13 @@ env_time_t posix_time_inherit = {0};
 
 static void interrupt_handler(int sig)
 {
+	env_time_t now;
+
 	switch (sig) {
 		case SIGALRM:
-			tt_expired(posix_srp_timer_get());
+			now = posix_srp_timer_get();
+			TT_RECORD_EVENT(TT_RECORD_TIMER, 0, now, posix_srp_timer_armed);
+			tt_expired(now);
 			tt_schedule();
 			break;
 	
@@ -71,6 +81,127 @@ static void interrupt_handler(int sig)
 	}
 }
 
+#if defined TT_TRACE
+
+/* ************************************************************************** */
+
+static void trace_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+static void trace_exit(void)
+{
+	FILE *file = fopen(getenv("TT_TRACE"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_trace_dump(trace_write, file);
+	fclose(file);
+}
+
+#endif /* TT_TRACE */
+
+#if defined TT_STATS
+
+/* ************************************************************************** */
+
+static void stats_print(
+		FILE *file,
+		tt_stats_t *entry,
+		const char *name,
+		tt_histogram_t *histogram
+		)
+{
+	if (!histogram->total) {
+		return;
+	}
+
+	fprintf(
+			file,
+			"object=%p method=%p %s count=%lu"
+			" min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			(void *)entry->to,
+			(void *)(size_t)entry->method,
+			name,
+			histogram->total,
+			histogram->min,
+			tt_histogram_mean(histogram),
+			tt_histogram_percentile(histogram, 500),
+			tt_histogram_percentile(histogram, 900),
+			tt_histogram_percentile(histogram, 990),
+			tt_histogram_percentile(histogram, 999),
+			histogram->max
+			);
+}
+
+/* ************************************************************************** */
+
+static void stats_exit(void)
+{
+	int i;
+	tt_stats_t *entry;
+	FILE *file = stderr;
+
+	if (getenv("TT_STATS") && !(file = fopen(getenv("TT_STATS"), "w"))) {
+		return;
+	}
+
+	/* The address of a known function, to relocate symbols. */
+	fprintf(file, "anchor=%p\n", (void *)(size_t)tt_stats_get);
+	for (i=0;i<tt_stats_count();i++) {
+		entry = tt_stats_get(i);
+		stats_print(file, entry, "jitter", &entry->jitter);
+		stats_print(file, entry, "slack", &entry->slack);
+		stats_print(file, entry, "lateness", &entry->lateness);
+		stats_print(file, entry, "execution", &entry->execution);
+	}
+
+	if (file != stderr) {
+		fclose(file);
+	}
+}
+
+#endif /* TT_STATS */
+
+#if defined TT_RECORD
+
+/* ************************************************************************** */
+
+static void record_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+static void record_exit(void)
+{
+	FILE *file = fopen(getenv("TT_RECORD"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_record_dump(record_write, file);
+	fclose(file);
+}
+
+#endif /* TT_RECORD */
+
+#if defined TT_TRACE || defined TT_STATS || defined TT_RECORD
+
+/* ************************************************************************** */
+
+static void exit_interrupt(int sig)
+{
+	exit(0);
+}
+
+#endif /* TT_TRACE || TT_STATS || TT_RECORD */
+
 /** \endcond */
 
 /* ************************************************************************** */
@@ -106,6 +237,31 @@ void posix_srp_init(void)
 	clock_gettime(CLOCK_REALTIME, &posix_srp_timer_timestamp);
 
 	root = pthread_self();
+
+#if defined TT_TRACE
+	/* Trace into the file named by TT_TRACE, dumped at exit. */
+	if (getenv("TT_TRACE")) {
+		signal_action.sa_handler = exit_interrupt;
+		sigaction(SIGINT, &signal_action, NULL);
+		atexit(trace_exit);
+		tt_trace_enable(1);
+	}
+#endif
+#if defined TT_STATS
+	/* Dump the statistics at exit, into the file named by TT_STATS. */
+	signal_action.sa_handler = exit_interrupt;
+	sigaction(SIGINT, &signal_action, NULL);
+	atexit(stats_exit);
+#endif
+#if defined TT_RECORD
+	/* Record the timer expiries into the file named by TT_RECORD. */
+	if (getenv("TT_RECORD")) {
+		signal_action.sa_handler = exit_interrupt;
+		sigaction(SIGINT, &signal_action, NULL);
+		atexit(record_exit);
+		tt_record_enable(1);
+	}
+#endif
 }
 
 /* ************************************************************************** */
@@ -94,6 +94,20 @@ void posix_srp_idle(void);
 
 /* ************************************************************************** */
 
+#define ENV_CPU_GET() \
+	posix_srp_cpu_get()
+
+/* ************************************************************************** */
+
+#define ENV_TRACE_NSEC(time) \
+	((unsigned long long)(time).tv_sec*1000000000ULL + (time).tv_nsec)
+
+/* ************************************************************************** */
+
+#define ENV_USDT 1
+
+/* ************************************************************************** */
+
 #define ENV_PROTECT(state) \
 	posix_srp_protect(state)
 
@@ -120,7 +134,7 @@ void posix_srp_idle(void);
 /* ************************************************************************** */
 
 #define ENV_USEC(useconds) \
-	posix_srp_usec(seconds)
+	posix_srp_usec(useconds)
 
 /* ************************************************************************** */
 
@@ -146,6 +160,10 @@ static inline void posix_srp_timer_set(const env_time_t *next)
 {
 	extern timer_t posix_srp_timer;
 	struct itimerspec tmp = {.it_value = *next};
+#if defined TT_RECORD
+	extern env_time_t posix_srp_timer_armed;
+	posix_srp_timer_armed = *next;
+#endif
 	timer_settime(posix_srp_timer, TIMER_ABSTIME, &tmp, NULL);
 }
 
@@ -160,6 +178,15 @@ static inline env_time_t posix_srp_timer_get()
 
 /* ************************************************************************** */
 
+static inline long posix_srp_cpu_get(void)
+{
+	struct timespec tmp;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &tmp);
+	return tmp.tv_sec*1000000000L + tmp.tv_nsec;
+}
+
+/* ************************************************************************** */
+
 static inline env_time_t posix_srp_timestamp(void)
 {
 	extern env_time_t posix_srp_timer_timestamp;
@@ -205,7 +232,7 @@ static inline env_time_t posix_srp_msec(unsigned long mseconds)
 	env_time_t tmp;
 	if (mseconds >= 1000UL) {
 		tmp.tv_sec = mseconds / 1000UL;
-		tmp.tv_nsec = (mseconds % 1000UL) * 1000UL;
+		tmp.tv_nsec = (mseconds % 1000UL) * 1000000UL;
 	} else {
 		tmp.tv_sec = 0;
 		tmp.tv_nsec = mseconds * 1000000UL;
@@ -229,7 +256,7 @@ static inline env_time_t posix_srp_usec(unsigned long useconds)
 		tmp.tv_nsec = (useconds % 1000000UL) * 1000UL;
 	} else {
 		tmp.tv_sec = 0;
-		tmp.tv_nsec = useconds;
+		tmp.tv_nsec = useconds * 1000UL;
 	}
 	return tmp;
 }
@@ -0,0 +1,751 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <env.h>
+#if defined TT_SRP
+#	include <kernel_srp.h>
+#else
+#	include <kernel.h>
+#endif
+#include <trace.h>
+#include <stats.h>
+#include <record.h>
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/*
+ * Semi private internal but used in the header file.
+ */
+int sim_protected;
+int sim_timer_armed;
+env_time_t sim_timer;
+env_time_t sim_now;
+env_time_t sim_interrupt_timestamp;
+long sim_cpu;
+
+static int sim_end_set;
+static env_time_t sim_end;
+static sim_cost_model_t sim_model;
+static env_time_t sim_cost;
+static sim_ext_interrupt_handler_t sim_interrupt_vector[SIM_NUM_INTERRUPTS];
+
+/*
+ * The replayed record, with a cursor for the timer and one for the external
+ * interrupts.
+ */
+typedef struct sim_event_t {
+	env_time_t time;
+	env_time_t armed;
+	int event;
+	int id;
+} sim_event_t;
+
+static sim_event_t *sim_replay;
+static unsigned long sim_replay_count;
+static unsigned long sim_replay_timer;
+static unsigned long sim_replay_match;
+static unsigned long sim_replay_interrupt;
+
+#if ! defined TT_SRP
+
+static char sim_stack[ENV_NUM_THREADS][ENV_STACKSIZE]
+	__attribute__((aligned(16)));
+static int sim_num_stacks;
+
+#if defined __x86_64__
+
+void sim_switch(void **, void *);
+
+/*
+ * Save the callee saved registers on the current stack, store the stack
+ * pointer and continue on the other stack.
+ */
+__asm__(
+		"	.pushsection .text\n"
+		"	.globl sim_switch\n"
+		"	.type sim_switch, @function\n"
+		"sim_switch:\n"
+		"	pushq %rbp\n"
+		"	pushq %rbx\n"
+		"	pushq %r12\n"
+		"	pushq %r13\n"
+		"	pushq %r14\n"
+		"	pushq %r15\n"
+		"	movq %rsp, (%rdi)\n"
+		"	movq %rsi, %rsp\n"
+		"	popq %r15\n"
+		"	popq %r14\n"
+		"	popq %r13\n"
+		"	popq %r12\n"
+		"	popq %rbx\n"
+		"	popq %rbp\n"
+		"	ret\n"
+		"	.size sim_switch, .-sim_switch\n"
+		"	.popsection\n"
+		);
+
+#endif /* __x86_64__ */
+
+#endif /* ! TT_SRP */
+
+/* ************************************************************************** */
+
+/*
+ * A replayed external interrupt, taken in the protection state it
+ * interrupts (the handlers call tt_schedule() like on POSIX).
+ */
+static void sim_ext_interrupt(int id)
+{
+	int protected = sim_protected;
+
+	sim_replay_interrupt++;
+	sim_protected = 1;
+	sim_interrupt_timestamp = sim_now;
+	TT_RECORD_EVENT(TT_RECORD_INTERRUPT, id, sim_now, sim_now);
+	if (id < SIM_NUM_INTERRUPTS && sim_interrupt_vector[id]) {
+		sim_interrupt_vector[id](id);
+	}
+	sim_protected = protected;
+}
+
+/* ************************************************************************** */
+
+/*
+ * The time the armed timer fires. When the recording set the timer to the
+ * same time it fires as late as it did then, otherwise on time. The timer
+ * can be set earlier than what is already pending, records up to the first
+ * one armed no earlier than the timer are kept for later.
+ */
+static env_time_t sim_timer_due(void)
+{
+	unsigned long i;
+	sim_event_t *event;
+
+	sim_replay_match = 0;
+	for (i=sim_replay_timer;i<sim_replay_count;i++) {
+		event = &sim_replay[i];
+		if (
+			event->event == TT_RECORD_TIMER &&
+			!ENV_TIME_LT(event->armed, sim_timer)
+			) {
+			if (event->armed == sim_timer) {
+				sim_replay_match = i + 1;
+				if (ENV_TIME_LT(sim_timer, event->time)) {
+					return event->time;
+				}
+			}
+			break;
+		}
+	}
+
+	return sim_timer;
+}
+
+/* ************************************************************************** */
+
+/*
+ * The timer was taken, the record it matched is used up and so are those
+ * armed before now that never matched.
+ */
+static void sim_replay_taken(void)
+{
+	sim_timer_due();
+	if (sim_replay_match) {
+		sim_replay[sim_replay_match - 1].event = TT_RECORD_EVENTS;
+	}
+	while (
+		sim_replay_timer < sim_replay_count && (
+			sim_replay[sim_replay_timer].event != TT_RECORD_TIMER ||
+			ENV_TIME_LT(sim_replay[sim_replay_timer].armed, sim_now)
+			)
+		) {
+		sim_replay_timer++;
+	}
+}
+
+/* ************************************************************************** */
+
+/*
+ * The next interrupt, the timer (id -1) or a replayed external one.
+ * Returns zero if there is none.
+ */
+static int sim_next(env_time_t *when, int *id)
+{
+	int pending = 0;
+	sim_event_t *event;
+
+	if (sim_timer_armed) {
+		*when = sim_timer_due();
+		*id = -1;
+		pending = 1;
+	}
+
+	while (
+		sim_replay_interrupt < sim_replay_count &&
+		sim_replay[sim_replay_interrupt].event != TT_RECORD_INTERRUPT
+		) {
+		sim_replay_interrupt++;
+	}
+	if (sim_replay_interrupt < sim_replay_count) {
+		event = &sim_replay[sim_replay_interrupt];
+		if (!pending || ENV_TIME_LT(event->time, *when)) {
+			*when = event->time;
+			*id = event->id;
+			pending = 1;
+		}
+	}
+
+	return pending;
+}
+
+/* ************************************************************************** */
+
+/*
+ * The timer interrupt, in virtual time. The regular kernel may switch to a
+ * preempting thread in tt_schedule(), we get back here once it yields.
+ */
+static void sim_interrupt(void)
+{
+	sim_protected = 1;
+	sim_timer_armed = 0;
+	sim_replay_taken();
+	sim_interrupt_timestamp = sim_now;
+	TT_RECORD_EVENT(TT_RECORD_TIMER, 0, sim_now, sim_timer);
+	tt_expired(sim_now);
+	tt_schedule();
+	sim_protected = 0;
+}
+
+/* ************************************************************************** */
+
+static void sim_charge(env_time_t amount)
+{
+	sim_now += amount;
+	sim_cpu += amount;
+#if ! defined TT_SRP
+	tt_current->context.cpu += amount;
+#endif
+}
+
+/* ************************************************************************** */
+
+static void sim_finish(void)
+{
+	fprintf(
+			stderr,
+			"sim: time=%lu busy=%lu idle=%lu load=%lu.%01lu%%\n",
+			(unsigned long)sim_now,
+			(unsigned long)sim_cpu,
+			(unsigned long)(sim_now - sim_cpu),
+			sim_now ? (unsigned long)(sim_cpu*1000.0/sim_now)/10 : 0,
+			sim_now ? (unsigned long)(sim_cpu*1000.0/sim_now)%10 : 0
+			);
+	exit(0);
+}
+
+#if defined TT_TRACE
+
+/* ************************************************************************** */
+
+static void trace_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+static void trace_exit(void)
+{
+	FILE *file = fopen(getenv("TT_TRACE"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_trace_dump(trace_write, file);
+	fclose(file);
+}
+
+#endif /* TT_TRACE */
+
+#if defined TT_STATS
+
+/* ************************************************************************** */
+
+static void stats_print(
+		FILE *file,
+		tt_stats_t *entry,
+		const char *name,
+		tt_histogram_t *histogram
+		)
+{
+	if (!histogram->total) {
+		return;
+	}
+
+	fprintf(
+			file,
+			"object=%p method=%p %s count=%lu"
+			" min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			(void *)entry->to,
+			(void *)(size_t)entry->method,
+			name,
+			histogram->total,
+			histogram->min,
+			tt_histogram_mean(histogram),
+			tt_histogram_percentile(histogram, 500),
+			tt_histogram_percentile(histogram, 900),
+			tt_histogram_percentile(histogram, 990),
+			tt_histogram_percentile(histogram, 999),
+			histogram->max
+			);
+}
+
+/* ************************************************************************** */
+
+static void stats_exit(void)
+{
+	int i;
+	tt_stats_t *entry;
+	FILE *file = stderr;
+
+	if (getenv("TT_STATS") && !(file = fopen(getenv("TT_STATS"), "w"))) {
+		return;
+	}
+
+	/* The address of a known function, to relocate symbols. */
+	fprintf(file, "anchor=%p\n", (void *)(size_t)tt_stats_get);
+	for (i=0;i<tt_stats_count();i++) {
+		entry = tt_stats_get(i);
+		stats_print(file, entry, "jitter", &entry->jitter);
+		stats_print(file, entry, "slack", &entry->slack);
+		stats_print(file, entry, "lateness", &entry->lateness);
+		stats_print(file, entry, "execution", &entry->execution);
+	}
+
+	if (file != stderr) {
+		fclose(file);
+	}
+}
+
+#endif /* TT_STATS */
+
+#if defined TT_RECORD
+
+/* ************************************************************************** */
+
+static void record_write(const void *buf, size_t size, void *data)
+{
+	fwrite(buf, 1, size, data);
+}
+
+/* ************************************************************************** */
+
+static void record_exit(void)
+{
+	FILE *file = fopen(getenv("TT_RECORD"), "wb");
+
+	if (!file) {
+		return;
+	}
+	tt_record_dump(record_write, file);
+	fclose(file);
+}
+
+#endif /* TT_RECORD */
+
+/* ************************************************************************** */
+
+/*
+ * Read a little endian value of the record format.
+ */
+static unsigned long long sim_get(const unsigned char *buf, int size)
+{
+	unsigned long long value = 0;
+
+	while (size--) {
+		value = (value << 8) | buf[size];
+	}
+	return value;
+}
+
+/* ************************************************************************** */
+
+/*
+ * Load the record to replay, see record.c for the format.
+ */
+static void sim_replay_load(const char *path)
+{
+	unsigned long i, lost;
+	unsigned char buf[24];
+	FILE *file = fopen(path, "rb");
+
+	if (
+		!file ||
+		fread(buf, 1, 16, file) != 16 ||
+		memcmp(buf, "TTRC", 4) ||
+		sim_get(buf + 4, 4) != TT_RECORD_VERSION
+		) {
+		sim_panic("sim_init(): Unable to read the replay record.\n");
+	}
+
+	sim_replay_count = (unsigned long)sim_get(buf + 8, 4);
+	lost = (unsigned long)sim_get(buf + 12, 4);
+	sim_replay = malloc(sim_replay_count*sizeof(sim_event_t) + 1);
+	if (!sim_replay) {
+		sim_panic("sim_init(): Out of memory for the replay record.\n");
+	}
+
+	for (i=0;i<sim_replay_count;i++) {
+		if (fread(buf, 1, 24, file) != 24) {
+			sim_panic("sim_init(): Truncated replay record.\n");
+		}
+		sim_replay[i].time = (env_time_t)sim_get(buf, 8);
+		sim_replay[i].armed = (env_time_t)sim_get(buf + 8, 8);
+		sim_replay[i].event = buf[16];
+		sim_replay[i].id = buf[17];
+	}
+	fclose(file);
+
+	if (lost) {
+		fprintf(stderr, "sim: the replay record is incomplete\n");
+	}
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator init function.
+ *
+ * The kernel starts out protected at virtual time zero.
+ */
+void sim_init(void)
+{
+	char *end = getenv("TT_SIM_END");
+	char *replay = getenv("TT_SIM_REPLAY");
+
+	sim_protected = 1;
+	sim_timer_armed = 0;
+	sim_now = 0;
+	sim_interrupt_timestamp = 0;
+	sim_cpu = 0;
+
+	/* The end of the simulation, in (virtual) seconds. */
+	if (end) {
+		sim_end = (env_time_t)(strtod(end, NULL)*1e9);
+		sim_end_set = 1;
+	}
+
+	/* Replay the interrupts recorded into the file named by TT_SIM_REPLAY. */
+	if (replay) {
+		sim_replay_load(replay);
+	}
+
+#if defined TT_TRACE
+	/* Trace into the file named by TT_TRACE, dumped at exit. */
+	if (getenv("TT_TRACE")) {
+		atexit(trace_exit);
+		tt_trace_enable(1);
+	}
+#endif
+#if defined TT_STATS
+	/* Dump the statistics at exit, into the file named by TT_STATS. */
+	atexit(stats_exit);
+#endif
+#if defined TT_RECORD
+	/* Record the interrupts into the file named by TT_RECORD, at exit. */
+	if (getenv("TT_RECORD")) {
+		atexit(record_exit);
+		tt_record_enable(1);
+	}
+#endif
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator panic function.
+ *
+ * \param msg The message to print before aborting.
+ */
+void sim_panic(const char * const msg)
+{
+	fprintf(stderr, "%s", msg);
+	abort();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator protect function.
+ *
+ * Leaving protected mode first charges the cost of a message that was just
+ * dispatched, then takes a timer interrupt that is due.
+ *
+ * \param state If we should enter protected mode.
+ */
+void sim_protect(int state)
+{
+	env_time_t cost = sim_cost;
+
+	if (state) {
+		sim_protected = 1;
+		return;
+	}
+
+	sim_protected = 0;
+	sim_cost = 0;
+	sim_consume(cost);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator consume function.
+ *
+ * Charges the given amount of virtual time to the running context. Timer
+ * and replayed interrupts that fall within it are taken on time (unless
+ * protected), the time spent in what they preempt with is not charged to
+ * this context.
+ *
+ * \param amount The virtual time to consume.
+ */
+void sim_consume(env_time_t amount)
+{
+	int id;
+	env_time_t step, when;
+
+	for (;;) {
+		/* Take an interrupt that is due. */
+		if (
+			!sim_protected &&
+			sim_next(&when, &id) &&
+			ENV_TIME_LE(when, sim_now)
+			) {
+			if (id < 0) {
+				sim_interrupt();
+			} else {
+				sim_ext_interrupt(id);
+			}
+			continue;
+		}
+
+		if (!amount) {
+			break;
+		}
+
+		/* Run up to the next interrupt at most. */
+		step = amount;
+		if (
+			!sim_protected &&
+			sim_next(&when, &id) &&
+			when - sim_now < step
+			) {
+			step = when - sim_now;
+		}
+
+		if (sim_end_set && sim_end - sim_now < step) {
+			sim_charge(sim_end - sim_now);
+			sim_finish();
+		}
+
+		sim_charge(step);
+		amount -= step;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator cost model function.
+ *
+ * \param model The function that gives the execution time of a message
+ * when it is dispatched, or NULL.
+ */
+void sim_cost_model(sim_cost_model_t model)
+{
+	sim_model = model;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator dispatch function.
+ *
+ * Called by the kernel (protected) when a message is dispatched, the cost
+ * is charged as the method starts to run.
+ *
+ * \param to The object of the message.
+ * \param method The method of the message.
+ */
+void sim_dispatch(tt_object_t *to, tt_method_t method)
+{
+	if (sim_model) {
+		sim_cost = sim_model(to, method);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator idle function.
+ *
+ * Runs the kernel until there is nothing left to do or the end of the
+ * simulation is reached, jumping from baseline to baseline while the
+ * processor is idle.
+ */
+void sim_idle(void)
+{
+	int id;
+	env_time_t when;
+
+	for (;;) {
+		tt_schedule();
+		if (!sim_next(&when, &id)) {
+			break;
+		}
+
+		if (sim_end_set && ENV_TIME_LT(sim_end, when)) {
+			sim_now = sim_end;
+			break;
+		}
+
+		if (ENV_TIME_LT(sim_now, when)) {
+			sim_now = when;
+		}
+		if (id >= 0) {
+			sim_ext_interrupt(id);
+			continue;
+		}
+		sim_timer_armed = 0;
+		sim_replay_taken();
+		sim_interrupt_timestamp = sim_now;
+		TT_RECORD_EVENT(TT_RECORD_TIMER, 0, sim_now, sim_timer);
+		tt_expired(sim_now);
+	}
+	sim_finish();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator external interrupt handler function.
+ *
+ * \param id The interrupt id.
+ * \param handler The handler of the interrupt.
+ */
+void sim_ext_interrupt_handler(int id, sim_ext_interrupt_handler_t handler)
+{
+	if (id < 0 || id >= SIM_NUM_INTERRUPTS) {
+		sim_panic("sim_ext_interrupt_handler(): Invalid interrupt.\n");
+	}
+	sim_interrupt_vector[id] = handler;
+}
+
+#if ! defined TT_SRP
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator context init function.
+ *
+ * \param context The context to initialize.
+ * \param function The function the context starts in, must never return.
+ */
+void sim_context_init(env_context_t *context, void (*function)(void))
+{
+	char *stack;
+
+	if (sim_num_stacks >= ENV_NUM_THREADS) {
+		sim_panic("sim_context_init(): Out of stacks.\n");
+	}
+	stack = sim_stack[sim_num_stacks++];
+	context->cpu = 0;
+
+#if defined __x86_64__
+	{
+		/*
+		 * The frame sim_switch() pops: six registers and the return
+		 * address, followed by a (never used) return address for the
+		 * function so that it starts with the stack aligned as after
+		 * a call.
+		 */
+		void **sp = (void **)(
+				(uintptr_t)(stack + ENV_STACKSIZE) & ~(uintptr_t)15
+				) - 8;
+
+		memset(sp, 0, 8*sizeof(void *));
+		sp[6] = (void *)function;
+		context->sp = sp;
+	}
+#else
+	if (getcontext(&context->uc)) {
+		sim_panic("sim_context_init(): Unable to get context.\n");
+	}
+	context->uc.uc_stack.ss_sp = stack;
+	context->uc.uc_stack.ss_size = ENV_STACKSIZE;
+	context->uc.uc_link = NULL;
+	makecontext(&context->uc, function, 0);
+#endif
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator dispatch function.
+ *
+ * \param thread The thread to dispatch.
+ */
+void sim_context_dispatch(tt_thread_t *thread)
+{
+	tt_thread_t *prev = tt_current;
+
+	if (thread == prev) {
+		return;
+	}
+
+	tt_current = thread;
+#if defined __x86_64__
+	sim_switch(&prev->context.sp, thread->context.sp);
+#else
+	if (swapcontext(&prev->context.uc, &thread->context.uc)) {
+		sim_panic("sim_context_dispatch(): Unable to swap context.\n");
+	}
+#endif
+}
+
+#endif /* ! TT_SRP */
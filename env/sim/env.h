@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \brief Simulated time environment.
+ *
+ * Runs the kernel on a discrete-event virtual clock, deterministically and
+ * as fast as the host allows. Nothing takes time unless it is charged:
+ *
+ *	- by the method itself, with sim_consume(),
+ *	- or by the cost model set with sim_cost_model(), charged when the
+ *	  kernel dispatches a message.
+ *
+ * While time is charged the virtual timer fires as an interrupt would, so
+ * messages are released and preempt each other on time. With the
+ * processor idle the clock jumps straight to the next baseline. The run
+ * ends when nothing is left to do or the virtual time reaches TT_SIM_END
+ * (seconds, environment variable), then a summary of the processor load is
+ * printed on stderr. The TT_TRACE and TT_STATS dumps work as on POSIX,
+ * in virtual time. Both the regular and the SRP kernel (SRP=yes) are
+ * supported.
+ *
+ * Interrupts recorded on POSIX (make RECORD=yes, see record.h) are replayed
+ * from the file named by TT_SIM_REPLAY: the external interrupts at the
+ * times they were taken, to the handlers installed with
+ * ENV_EXT_INTERRUPT_HANDLER(), and the timer as late as it was whenever it
+ * is set to the same time as in the recording.
+ */
+#ifndef ENV_SIM_ENV_H_
+#define ENV_SIM_ENV_H_
+
+/* Standard C headers. */
+#include <stdio.h>
+#include <stddef.h>
+
+/* Environment headers. */
+#include <types.h>
+
+/* tinyTimber headers. */
+#include <tT.h>
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator cost model, the execution time of a dispatched message.
+ */
+typedef env_time_t (*sim_cost_model_t)(tt_object_t *, tt_method_t);
+
+/**
+ * \brief Simulator external interrupt handler.
+ */
+typedef void (*sim_ext_interrupt_handler_t)(int);
+
+void sim_init(void);
+void sim_panic(const char * const);
+void sim_protect(int);
+void sim_idle(void);
+void sim_dispatch(tt_object_t *, tt_method_t);
+void sim_consume(env_time_t);
+void sim_cost_model(sim_cost_model_t);
+void sim_ext_interrupt_handler(int, sim_ext_interrupt_handler_t);
+#if ! defined TT_SRP
+void sim_context_init(env_context_t *, void (*)(void));
+void sim_context_dispatch(tt_thread_t *);
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_SRP
+/**
+ * \brief The environment runs the SRP kernel.
+ */
+#	define ENV_SRP 1
+#endif
+
+/* ************************************************************************** */
+
+#define ENV_INLINE inline
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment init macro.
+ */
+#define ENV_INIT() \
+	sim_init()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment debug macro.
+ */
+#define ENV_DEBUG(msg) \
+	fprintf(stderr, "%s", msg)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment panic macro.
+ *
+ * Will print the msg and call abort().
+ */
+#define ENV_PANIC(msg) \
+	sim_panic(msg)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment protect macro.
+ *
+ * Leaving protected mode charges the cost of a message that was just
+ * dispatched and takes a timer interrupt that became due meanwhile.
+ */
+#define ENV_PROTECT(state) \
+	sim_protect(state)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment isprotected macro.
+ */
+#define ENV_ISPROTECTED() \
+	sim_isprotected()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment probe macro, follows the dispatch of messages.
+ */
+#define ENV_PROBE(name, msg, to, method) \
+	SIM_PROBE_##name(to, method)
+
+/** \cond */
+#define SIM_PROBE_post(to, method) ((void)0)
+#define SIM_PROBE_release(to, method) ((void)0)
+#define SIM_PROBE_dispatch(to, method) sim_dispatch((to), (method))
+#define SIM_PROBE_preempt(to, method) ((void)0)
+#define SIM_PROBE_complete(to, method) ((void)0)
+/** \endcond */
+
+/* ************************************************************************** */
+
+#if ! defined TT_SRP
+
+/**
+ * \brief Environment context behaviour macro.
+ *
+ * The interrupts are simulated, the kernel dispatches from tt_schedule().
+ */
+#	define ENV_CONTEXT_NOT_SAVED 1
+
+#	ifndef ENV_NUM_THREADS
+	/**
+	 * \brief The number of threads of this environment.
+	 */
+#		define ENV_NUM_THREADS 4
+#	endif
+
+#	ifndef ENV_STACKSIZE
+	/**
+	 * \brief The stack size of each thread.
+	 */
+#		define ENV_STACKSIZE 65536
+#	endif
+
+/**
+ * \brief Environment context init macro.
+ */
+#	define ENV_CONTEXT_INIT(context, stacksize, function) \
+		sim_context_init(context, function)
+
+/**
+ * \brief Environment context dispatch macro.
+ */
+#	define ENV_CONTEXT_DISPATCH(thread) \
+		sim_context_dispatch((thread))
+
+#endif /* ! TT_SRP */
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment idle macro.
+ */
+#define ENV_IDLE() \
+	sim_idle()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer start macro.
+ */
+#define ENV_TIMER_START() \
+	((void)0)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer set macro.
+ */
+#define ENV_TIMER_SET(time) \
+	sim_timer_set(time)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer get macro.
+ */
+#define ENV_TIMER_GET() \
+	sim_timer_get()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timestamp macro.
+ */
+#define ENV_TIMESTAMP() \
+	sim_timestamp()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment processor time macro.
+ *
+ * The virtual time charged to the running context in nanoseconds.
+ */
+#define ENV_CPU_GET() \
+	sim_cpu_get()
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment time in nanoseconds, used by the kernel trace.
+ */
+#define ENV_TRACE_NSEC(time) \
+	((unsigned long long)(time))
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer usec macro, the virtual time is in nanoseconds.
+ */
+#define ENV_USEC(val) \
+	((env_time_t)(val)*1000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer msec macro.
+ */
+#define ENV_MSEC(val) \
+	((env_time_t)(val)*1000000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Environment timer sec macro.
+ */
+#define ENV_SEC(val) \
+	((env_time_t)(val)*1000000000UL)
+
+/* ************************************************************************** */
+
+/**
+ * \brief The simulator startup macro.
+ */
+#define ENV_STARTUP(function) \
+int main(void)\
+{\
+	tt_init();\
+	function();\
+	tt_run();\
+	return 0;\
+} extern char dummy /* Force semi-colon at end of macro. */
+
+/* ************************************************************************** */
+
+#ifndef SIM_NUM_INTERRUPTS
+	/**
+	 * \brief Simulator number of interrupt vector slots, as on POSIX.
+	 */
+#	define SIM_NUM_INTERRUPTS 10
+#endif
+
+/**
+ * \brief Environment extension to install interrupt handler.
+ *
+ * Replayed interrupts are delivered to the handler.
+ */
+#define ENV_EXT_INTERRUPT_HANDLER(id, handler) \
+	sim_ext_interrupt_handler(id, handler)
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator isprotected function.
+ *
+ * \return non-zero if protected, otherwise zero.
+ */
+static inline int sim_isprotected(void)
+{
+	extern int sim_protected;
+	return sim_protected;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator timer set function.
+ *
+ * \param time The virtual time when tt_expired() should be called.
+ */
+static inline void sim_timer_set(env_time_t time)
+{
+	extern env_time_t sim_timer;
+	extern int sim_timer_armed;
+	sim_timer = time;
+	sim_timer_armed = 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator timer get function.
+ *
+ * \return The virtual time.
+ */
+static inline env_time_t sim_timer_get(void)
+{
+	extern env_time_t sim_now;
+	return sim_now;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator timestamp function.
+ *
+ * \return The virtual time of the most recent interrupt.
+ */
+static inline env_time_t sim_timestamp(void)
+{
+	extern env_time_t sim_interrupt_timestamp;
+	return sim_interrupt_timestamp;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief Simulator processor time function.
+ *
+ * \return The virtual time charged to the running context, or to all of
+ * them on the single stack of the SRP kernel.
+ */
+static inline long sim_cpu_get(void)
+{
+#if defined TT_SRP
+	extern long sim_cpu;
+	return sim_cpu;
+#else
+	/* The context is the first member of the thread. */
+	extern tt_thread_t *tt_current;
+	return ((env_context_t *)tt_current)->cpu;
+#endif
+}
+
+#endif
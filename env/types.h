@@ -54,6 +54,10 @@
 #		include "m16c/types.h"
 #	elif defined ENV_M16C_SRP
 #		include "m16c_srp/types.h"
+#	elif defined ENV_BENCH
+#		include "bench/types.h"
+#	elif defined ENV_SIM
+#		include "sim/types.h"
 #	elif defined ENV_SKEL
 #		include "skel/types.h"
 #	else
@@ -139,6 +143,12 @@
 #	define ENV_TIME_ADD(v0, v1) \
 		((v0) + (v1))
 
+#	define ENV_TIME_DIFF(v0, v1) \
+		((long)((env_time_t)(v0) - (env_time_t)(v1)))
+
+#	define ENV_TIME_SUB(v0, v1) \
+		((v0) - (v1))
+
 #	define ENV_TIME_INHERIT \
 		(0)
 
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Online admission control.
+ *
+ * A manager adds ADMIT_STREAMS streams at runtime, one every 100 ms. Every
+ * stream declares a period of 10 ms, a deadline of 10 ms and a WCET of
+ * ADMIT_WCET microseconds and only starts if tt_admit() lets it. A stream
+ * job spins for ADMIT_WORK microseconds, less than its declared WCET. The
+ * admitted streams should meet every deadline, the rejected ones never run.
+ *
+ * Set the ADMIT_DEGRADE environment variable to 1 to let a stream that does
+ * not fit run with a stretched period instead.
+ */
+
+#include <tT.h>
+#include <env.h>
+#include <admit.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ************************************************************************** */
+
+#ifndef ADMIT_STREAMS
+#	define ADMIT_STREAMS 5
+#endif
+
+#ifndef ADMIT_WCET
+#	define ADMIT_WCET 3000
+#endif
+
+#ifndef ADMIT_WORK
+#	define ADMIT_WORK 2500
+#endif
+
+#ifndef ADMIT_SECONDS
+#	define ADMIT_SECONDS 2
+#endif
+
+/* ************************************************************************** */
+
+typedef struct stream_t
+{
+	tt_object_t obj;
+	tt_activity_t activity;
+	int result;
+	unsigned long done;
+	unsigned long in_time;
+} stream_t;
+
+typedef struct manager_t
+{
+	tt_object_t obj;
+	int added;
+} manager_t;
+
+static stream_t stream[ADMIT_STREAMS];
+static manager_t manager = {tt_object()};
+static tt_object_t report = tt_object();
+static int flags;
+
+/* ************************************************************************** */
+
+static long cpu_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec*1000000000L + ts.tv_nsec;
+}
+
+static void spin(long nsec)
+{
+	long begin = cpu_nsec();
+
+	while (cpu_nsec() - begin < nsec);
+}
+
+/* ************************************************************************** */
+
+static env_result_t stream_job(stream_t *self, void *arg)
+{
+	env_time_t now, deadline = tt_deadline();
+
+	spin(ADMIT_WORK*1000L);
+
+	now = ENV_TIMER_GET();
+	self->done++;
+	if (ENV_TIME_LE(now, deadline)) {
+		self->in_time++;
+	}
+
+	TT_WITHIN(
+			self->activity.period,
+			self->activity.deadline,
+			self,
+			stream_job,
+			TT_ARGS_NONE
+			);
+	return 0;
+}
+
+static env_result_t manager_add(manager_t *self, void *arg)
+{
+	stream_t *new = &stream[self->added++];
+
+	new->result = tt_admit(
+			&new->activity,
+			ENV_MSEC(10),
+			ENV_MSEC(10),
+			ENV_USEC(ADMIT_WCET),
+			flags
+			);
+	printf(
+			"admit: stream=%d result=%s stretch=%d load=%d\n",
+			self->added - 1,
+			new->result == TT_ADMIT_ACCEPTED ? "accepted" :
+			new->result == TT_ADMIT_DEGRADED ? "degraded" : "rejected",
+			new->activity.stretch,
+			tt_admit_load()
+			);
+
+	if (new->result != TT_ADMIT_REJECTED) {
+		TT_WITHIN(
+				new->activity.period,
+				new->activity.deadline,
+				new,
+				stream_job,
+				TT_ARGS_NONE
+				);
+	}
+
+	if (self->added < ADMIT_STREAMS) {
+		TT_AFTER(ENV_MSEC(100), self, manager_add, TT_ARGS_NONE);
+	}
+	return 0;
+}
+
+static env_result_t report_print(tt_object_t *self, void *arg)
+{
+	int i;
+
+	for (i=0;i<ADMIT_STREAMS;i++) {
+		printf(
+				"admit: stream=%d done=%lu in_time=%lu\n",
+				i,
+				stream[i].done,
+				stream[i].in_time
+				);
+	}
+	fflush(stdout);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+
+	if (getenv("ADMIT_DEGRADE") && atoi(getenv("ADMIT_DEGRADE"))) {
+		flags = TT_ADMIT_DEGRADE;
+	}
+
+	for (i=0;i<ADMIT_STREAMS;i++) {
+		stream[i].obj = (tt_object_t)tt_object();
+	}
+
+	TT_ASYNC(&manager, manager_add, TT_ARGS_NONE);
+
+	/* Inherits the startup deadline, earlier than anything else. */
+	TT_AFTER(ENV_SEC(ADMIT_SECONDS), &report, report_print, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
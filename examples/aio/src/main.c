@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Asynchronous I/O benchmark.
+ *
+ * Reads a scratch file sequentially and at random offsets, first with
+ * blocking pread() calls inside a method and then through posix_aio. A
+ * ticker object runs every millisecond meanwhile, the largest gap between
+ * two ticks (or the start or end of the phase) shows how long the kernel
+ * was stalled.
+ *
+ * The file is created in $AIO_FILE (default /tmp/tt_aio.bin) and the page
+ * cache is dropped before every phase so that the disk is measured, not
+ * memory.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <posix/aio.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ************************************************************************** */
+
+#ifndef AIO_FILE_SIZE
+#	define AIO_FILE_SIZE (64*1024*1024)
+#endif
+
+#ifndef AIO_BLOCK
+#	define AIO_BLOCK (64*1024)
+#endif
+
+#ifndef AIO_DEPTH
+#	define AIO_DEPTH 8
+#endif
+
+#ifndef AIO_RANDOM_READS
+#	define AIO_RANDOM_READS 2048
+#endif
+
+#define AIO_INTERRUPT 1
+
+/* ************************************************************************** */
+
+enum
+{
+	PHASE_SEQ_BLOCKING,
+	PHASE_SEQ_AIO,
+	PHASE_RAND_BLOCKING,
+	PHASE_RAND_AIO,
+	PHASE_DONE
+};
+
+static const char *phase_name[] = {
+	"seq-blocking",
+	"seq-aio",
+	"rand-blocking",
+	"rand-aio"
+};
+
+typedef struct bench_t
+{
+	tt_object_t obj;
+	int fd;
+	int phase;
+	int issued;
+	int completed;
+	unsigned int seed;
+	size_t bytes;
+	struct timespec start;
+	char *buf;
+	posix_aio_t req[AIO_DEPTH];
+} bench_t;
+
+typedef struct ticker_t
+{
+	tt_object_t obj;
+	unsigned long ticks;
+	struct timespec last;
+	long max_gap;
+} ticker_t;
+
+static bench_t bench = {tt_object(), -1};
+static ticker_t ticker = {tt_object()};
+
+static env_result_t bench_phase(bench_t *, void *);
+static env_result_t bench_done(bench_t *, posix_aio_t **);
+
+/* ************************************************************************** */
+
+static long elapsed_us(const struct timespec *from, const struct timespec *to)
+{
+	return (to->tv_sec - from->tv_sec)*1000000L +
+		(to->tv_nsec - from->tv_nsec)/1000L;
+}
+
+static env_result_t ticker_tick(ticker_t *self, void *arg)
+{
+	struct timespec now;
+	long gap;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	gap = elapsed_us(&self->last, &now);
+	if (gap > self->max_gap) {
+		self->max_gap = gap;
+	}
+	self->last = now;
+	self->ticks++;
+
+	TT_AFTER(ENV_MSEC(1), self, ticker_tick, TT_ARGS_NONE);
+	return 0;
+}
+
+/* The phase starts, the first gap is measured from now. */
+static env_result_t ticker_reset(ticker_t *self, void *arg)
+{
+	clock_gettime(CLOCK_MONOTONIC, &self->last);
+	self->ticks = 0;
+	self->max_gap = 0;
+	return 0;
+}
+
+/* The phase ends, a ticker that never ran has a gap up to now. */
+static env_result_t ticker_finish(ticker_t *self, void *arg)
+{
+	struct timespec now;
+	long gap;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	gap = elapsed_us(&self->last, &now);
+	if (gap > self->max_gap) {
+		self->max_gap = gap;
+	}
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static off_t bench_offset(bench_t *self, int n)
+{
+	if (self->phase == PHASE_SEQ_BLOCKING || self->phase == PHASE_SEQ_AIO) {
+		return (off_t)n*AIO_BLOCK;
+	}
+	return (off_t)(rand_r(&self->seed) % (AIO_FILE_SIZE/AIO_BLOCK))*AIO_BLOCK;
+}
+
+static int bench_count(bench_t *self)
+{
+	if (self->phase == PHASE_SEQ_BLOCKING || self->phase == PHASE_SEQ_AIO) {
+		return AIO_FILE_SIZE/AIO_BLOCK;
+	}
+	return AIO_RANDOM_READS;
+}
+
+static void bench_report(bench_t *self)
+{
+	struct timespec now;
+	long us;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	us = elapsed_us(&self->start, &now);
+	TT_SYNC(&ticker, ticker_finish, TT_ARGS_NONE);
+
+	/* The ticker is owned by its own thread of control, peek at it. */
+	printf(
+			"phase=%s bytes=%lu usec=%ld MBps=%.1f ticks=%lu max_tick_gap_us=%ld\n",
+			phase_name[self->phase],
+			(unsigned long)self->bytes,
+			us,
+			us ? (double)self->bytes/us : 0.0,
+			ticker.ticks,
+			ticker.max_gap
+			);
+	fflush(stdout);
+}
+
+static void bench_next(bench_t *self)
+{
+	bench_report(self);
+	self->phase++;
+	TT_ASYNC(self, bench_phase, TT_ARGS_NONE);
+}
+
+static void bench_issue(bench_t *self, posix_aio_t *req)
+{
+	req->offset = bench_offset(self, self->issued++);
+	if (posix_aio_submit(req)) {
+		ENV_PANIC("bench_issue(): Unable to submit request.\n");
+	}
+}
+
+static env_result_t bench_done(bench_t *self, posix_aio_t **arg)
+{
+	posix_aio_t *req = *arg;
+
+	if (req->result < 0) {
+		ENV_PANIC("bench_done(): Read failed.\n");
+	}
+	self->bytes += req->result;
+	self->completed++;
+
+	if (self->issued < bench_count(self)) {
+		bench_issue(self, req);
+	} else if (self->completed == bench_count(self)) {
+		bench_next(self);
+	}
+	return 0;
+}
+
+static env_result_t bench_phase(bench_t *self, void *arg)
+{
+	int i;
+
+	if (self->phase == PHASE_DONE) {
+		close(self->fd);
+		unlink(getenv("AIO_FILE") ? getenv("AIO_FILE") : "/tmp/tt_aio.bin");
+		exit(0);
+	}
+
+	/* Make sure we hit the disk and not the page cache. */
+	posix_fadvise(self->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+	self->issued = 0;
+	self->completed = 0;
+	self->bytes = 0;
+	self->seed = 42;
+	TT_SYNC(&ticker, ticker_reset, TT_ARGS_NONE);
+	clock_gettime(CLOCK_MONOTONIC, &self->start);
+
+	if (self->phase == PHASE_SEQ_BLOCKING || self->phase == PHASE_RAND_BLOCKING) {
+		/* The blocking approach, nothing else runs meanwhile. */
+		for (i=0;i<bench_count(self);i++) {
+			ssize_t n = pread(
+					self->fd,
+					self->buf,
+					AIO_BLOCK,
+					bench_offset(self, i)
+					);
+			if (n < 0) {
+				ENV_PANIC("bench_phase(): Read failed.\n");
+			}
+			self->bytes += n;
+		}
+		bench_next(self);
+		return 0;
+	}
+
+	for (i=0;i<AIO_DEPTH && self->issued < bench_count(self);i++) {
+		bench_issue(self, &self->req[i]);
+	}
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+	void *bufs[AIO_DEPTH];
+	size_t sizes[AIO_DEPTH];
+	const char *name = getenv("AIO_FILE") ? getenv("AIO_FILE") : "/tmp/tt_aio.bin";
+
+	posix_aio_init(AIO_INTERRUPT, AIO_DEPTH);
+
+	bench.fd = open(name, O_RDWR|O_CREAT|O_TRUNC, 0600);
+	if (bench.fd < 0) {
+		ENV_PANIC("init(): Unable to create scratch file.\n");
+	}
+
+	if (posix_memalign((void **)&bench.buf, 4096, AIO_DEPTH*AIO_BLOCK)) {
+		ENV_PANIC("init(): Unable to allocate buffers.\n");
+	}
+	memset(bench.buf, 0x5a, AIO_DEPTH*AIO_BLOCK);
+	for (i=0;i<AIO_FILE_SIZE/AIO_BLOCK;i++) {
+		if (write(bench.fd, bench.buf, AIO_BLOCK) != AIO_BLOCK) {
+			ENV_PANIC("init(): Unable to fill scratch file.\n");
+		}
+	}
+	fsync(bench.fd);
+
+	/* One registered buffer per request slot. */
+	for (i=0;i<AIO_DEPTH;i++) {
+		bufs[i] = bench.buf + i*AIO_BLOCK;
+		sizes[i] = AIO_BLOCK;
+		bench.req[i].op = POSIX_AIO_READ;
+		bench.req[i].fd = bench.fd;
+		bench.req[i].buf = bufs[i];
+		bench.req[i].size = AIO_BLOCK;
+		bench.req[i].to = &bench.obj;
+		bench.req[i].method = (tt_method_t)bench_done;
+		bench.req[i].deadline = ENV_MSEC(10);
+	}
+	if (posix_aio_register(bufs, sizes, AIO_DEPTH) == 0) {
+		for (i=0;i<AIO_DEPTH;i++) {
+			bench.req[i].index = i;
+		}
+	} else {
+		for (i=0;i<AIO_DEPTH;i++) {
+			bench.req[i].index = -1;
+		}
+	}
+
+	printf(
+			"aio: %s, file=%s size=%d block=%d depth=%d\n",
+			posix_aio_uring() ? "io_uring" : "threads",
+			name,
+			AIO_FILE_SIZE,
+			AIO_BLOCK,
+			AIO_DEPTH
+			);
+
+	TT_ASYNC(&ticker, ticker_tick, TT_ARGS_NONE);
+	TT_AFTER(ENV_MSEC(10), &bench, bench_phase, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
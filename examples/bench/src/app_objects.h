@@ -0,0 +1,19 @@
+#ifndef APP_OBJECT_H_
+#define APP_OBJECT_H_
+
+/**
+ * \brief TinyTimber object id enum.
+ *
+ * Please add any object name/id you wish to this enum. Do _NOT_ specify an
+ * id, it will be assigned automatically.
+ */
+enum app_objects_t
+{
+	DRIVER,
+	SINK,
+	SPINNER,
+	TIMED,
+	APP_OBJECT_ID_MAX /* MUST NOT BE REMOVED! */
+};
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Kernel benchmark suite.
+ *
+ * Runs on the regular kernel (ENV=posix) and the SRP kernel
+ * (ENV=posix_srp), one phase after the other:
+ *
+ *	request:	cost of a tt_request() (TT_SYNC()) on an idle object.
+ *	post:		cost of a tt_action() (TT_ASYNC()) posting a message.
+ *	throughput:	messages posted and run per second, in batches.
+ *	dispatch:	post to dispatch, the poster completes first.
+ *	cancel:		cost of a tt_cancel() among BENCH_DEPTH pending messages.
+ *	timer:		timer release to dispatch with the processor idle.
+ *	preempt:	timer release to dispatch with a message running, a
+ *			preemption (a thread switch or a nested dispatch).
+ *
+ * Every phase prints one line of key=value pairs, times in nanoseconds:
+ *
+ *	bench=post env=posix unit=ns count=.. min=.. mean=.. p50=.. p90=..
+ *	p99=.. p999=.. max=..
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined TT_SRP
+#	include "app_objects.h"
+#endif
+
+/* ************************************************************************** */
+
+#ifndef BENCH_SAMPLES
+#	define BENCH_SAMPLES 10000
+#endif
+
+#ifndef BENCH_TIMER_SAMPLES
+#	define BENCH_TIMER_SAMPLES 1000
+#endif
+
+#ifndef BENCH_BATCH
+#	define BENCH_BATCH 64
+#endif
+
+#ifndef BENCH_DEPTH
+#	define BENCH_DEPTH 64
+#endif
+
+#if defined TT_SRP
+#	define BENCH_ENV "posix_srp"
+#	define bench_object(id, req) tt_object(id, req)
+#else
+#	define BENCH_ENV "posix"
+#	define bench_object(id, req) tt_object()
+#endif
+
+/* ************************************************************************** */
+
+typedef struct driver_t
+{
+	tt_object_t obj;
+	int count;
+	unsigned long long start;
+} driver_t;
+
+typedef struct sink_t
+{
+	tt_object_t obj;
+	int count;
+} sink_t;
+
+static driver_t driver = {bench_object(DRIVER, 1 << SINK)};
+static sink_t sink = {bench_object(SINK, 0)};
+static tt_object_t spinner = bench_object(SPINNER, 0);
+static tt_object_t timed = bench_object(TIMED, 0);
+
+#if defined TT_SRP
+tt_object_t *app_objects[APP_OBJECT_ID_MAX] = {
+	(tt_object_t *)&driver,
+	(tt_object_t *)&sink,
+	&spinner,
+	&timed
+};
+#endif
+
+static unsigned long samples[BENCH_SAMPLES];
+static int num_samples;
+static unsigned long long posted;
+static tt_receipt_t receipts[BENCH_DEPTH];
+static volatile int spinning;
+
+/* ************************************************************************** */
+
+static unsigned long long now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static void sample(unsigned long long value)
+{
+	if (num_samples < BENCH_SAMPLES) {
+		samples[num_samples++] = (unsigned long)value;
+	}
+}
+
+static int compare(const void *v0, const void *v1)
+{
+	unsigned long s0 = *(const unsigned long *)v0;
+	unsigned long s1 = *(const unsigned long *)v1;
+
+	return s0 < s1 ? -1 : s0 > s1;
+}
+
+static unsigned long percentile(int permille)
+{
+	int i = (int)(((long long)num_samples*permille + 999)/1000) - 1;
+
+	return samples[i < 0 ? 0 : i];
+}
+
+static void report(const char *name)
+{
+	int i;
+	unsigned long long sum = 0;
+
+	qsort(samples, num_samples, sizeof(samples[0]), compare);
+	for (i=0;i<num_samples;i++) {
+		sum += samples[i];
+	}
+
+	printf(
+			"bench=%s env=%s unit=ns count=%d min=%lu mean=%llu"
+			" p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			name,
+			BENCH_ENV,
+			num_samples,
+			samples[0],
+			sum/num_samples,
+			percentile(500),
+			percentile(900),
+			percentile(990),
+			percentile(999),
+			samples[num_samples-1]
+			);
+	fflush(stdout);
+	num_samples = 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t sink_nop(sink_t *self, void *arg)
+{
+	return 0;
+}
+
+static env_result_t sink_count(sink_t *self, void *arg)
+{
+	self->count++;
+	return 0;
+}
+
+static env_result_t sink_stamp(sink_t *self, void *arg);
+static env_result_t spinner_spin(tt_object_t *self, void *arg);
+static env_result_t timed_stamp(tt_object_t *self, void *arg);
+
+static env_result_t bench_request(driver_t *self, void *arg);
+static env_result_t bench_post(driver_t *self, void *arg);
+static env_result_t bench_dispatch(driver_t *self, void *arg);
+static env_result_t bench_cancel(driver_t *self, void *arg);
+static env_result_t bench_timer(driver_t *self, void *arg);
+static env_result_t bench_preempt(driver_t *self, void *arg);
+
+/* ************************************************************************** */
+
+static env_result_t bench_request(driver_t *self, void *arg)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		t0 = now_nsec();
+		TT_SYNC(&sink, sink_nop, TT_ARGS_NONE);
+		sample(now_nsec() - t0);
+	}
+	report("request");
+
+	self->count = 0;
+	sink.count = 0;
+	self->start = now_nsec();
+	TT_ASYNC(self, bench_post, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t bench_post(driver_t *self, void *arg)
+{
+	int i;
+	unsigned long long t0;
+
+	/* Post a batch, continue after the sink ran it (same deadline). */
+	if (self->count < BENCH_SAMPLES) {
+		for (i=0;i<BENCH_BATCH && self->count < BENCH_SAMPLES;i++) {
+			t0 = now_nsec();
+			TT_ASYNC(&sink, sink_count, TT_ARGS_NONE);
+			sample(now_nsec() - t0);
+			self->count++;
+		}
+		TT_ASYNC(self, bench_post, TT_ARGS_NONE);
+		return 0;
+	}
+	report("post");
+
+	printf(
+			"bench=throughput env=%s unit=msg/s count=%d value=%llu\n",
+			BENCH_ENV,
+			sink.count,
+			sink.count*1000000000ULL/(now_nsec() - self->start)
+			);
+	fflush(stdout);
+
+	self->count = 0;
+	TT_ASYNC(self, bench_dispatch, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t sink_stamp(sink_t *self, void *arg)
+{
+	sample(now_nsec() - posted);
+	TT_ASYNC(&driver, bench_dispatch, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t bench_dispatch(driver_t *self, void *arg)
+{
+	if (self->count++ < BENCH_SAMPLES) {
+		posted = now_nsec();
+		TT_ASYNC(&sink, sink_stamp, TT_ARGS_NONE);
+		return 0;
+	}
+	report("dispatch");
+
+	TT_ASYNC(self, bench_cancel, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t bench_cancel(driver_t *self, void *arg)
+{
+	int i, j;
+	unsigned long long t0;
+
+	/* Pending messages, far enough in the future to never run. */
+	for (i=0;i<BENCH_DEPTH;i++) {
+		TT_AFTER_R(
+				ENV_SEC(10 + i),
+				&sink,
+				sink_nop,
+				TT_ARGS_NONE,
+				&receipts[i]
+				);
+	}
+
+	/* Cancel and repost every position of the queue in turn. */
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		j = i % BENCH_DEPTH;
+		t0 = now_nsec();
+		TT_CANCEL(&receipts[j]);
+		sample(now_nsec() - t0);
+		TT_AFTER_R(
+				ENV_SEC(10 + j),
+				&sink,
+				sink_nop,
+				TT_ARGS_NONE,
+				&receipts[j]
+				);
+	}
+	report("cancel");
+
+	for (i=0;i<BENCH_DEPTH;i++) {
+		TT_CANCEL(&receipts[i]);
+	}
+
+	self->count = 0;
+	TT_AFTER(ENV_MSEC(1), &timed, timed_stamp, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t timed_stamp(tt_object_t *self, void *arg)
+{
+	env_time_t now = ENV_TIMER_GET(), baseline = tt_baseline();
+
+	sample(ENV_TIME_DIFF(now, baseline));
+	if (++driver.count < BENCH_TIMER_SAMPLES) {
+		TT_WITHIN(ENV_MSEC(1), ENV_USEC(500), self, timed_stamp, TT_ARGS_NONE);
+	} else if (spinning) {
+		spinning = 0;
+	} else {
+		TT_ASYNC(&driver, bench_timer, TT_ARGS_NONE);
+	}
+	return 0;
+}
+
+static env_result_t spinner_spin(tt_object_t *self, void *arg)
+{
+	while (spinning);
+	TT_ASYNC(&driver, bench_preempt, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t bench_timer(driver_t *self, void *arg)
+{
+	report("timer");
+
+	/*
+	 * Keep the processor busy with a message with a late deadline, the
+	 * timed messages preempt it.
+	 */
+	self->count = 0;
+	spinning = 1;
+	TT_WITHIN(ENV_SEC(0), ENV_SEC(60), &spinner, spinner_spin, TT_ARGS_NONE);
+	TT_WITHIN(ENV_MSEC(1), ENV_USEC(500), &timed, timed_stamp, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t bench_preempt(driver_t *self, void *arg)
+{
+	report("preempt");
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	TT_ASYNC(&driver, bench_request, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
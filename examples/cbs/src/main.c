@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Constant bandwidth server isolation.
+ *
+ * A critical object runs CBS_WORK microseconds every 10 ms. A hog object
+ * misbehaves: it reposts itself forever with an inherited baseline and a
+ * 1 ms deadline, always the most urgent message in the system, spinning
+ * for 5 ms each time. Without a server the critical object starves. With
+ * the hog attached to a server of CBS_BUDGET microseconds every 10 ms the
+ * hog only gets its bandwidth ahead of the critical object (and whatever
+ * processor time is left over), the critical object meets its deadlines.
+ *
+ * Set the CBS_SERVER environment variable to 0 to run without a server.
+ */
+
+#include <tT.h>
+#include <env.h>
+#include <cbs.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ************************************************************************** */
+
+#ifndef CBS_WORK
+#	define CBS_WORK 2000
+#endif
+
+#ifndef CBS_BUDGET
+#	define CBS_BUDGET 3000
+#endif
+
+#ifndef CBS_SECONDS
+#	define CBS_SECONDS 2
+#endif
+
+/* ************************************************************************** */
+
+typedef struct critical_t
+{
+	tt_object_t obj;
+	unsigned long done;
+	unsigned long in_time;
+} critical_t;
+
+typedef struct hog_t
+{
+	tt_object_t obj;
+	long cpu;
+} hog_t;
+
+static critical_t critical = {tt_object()};
+static hog_t hog = {tt_object()};
+static tt_object_t report = tt_object();
+static tt_server_t server;
+static int served = 1;
+static env_time_t start;
+
+/* ************************************************************************** */
+
+static long cpu_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec*1000000000L + ts.tv_nsec;
+}
+
+static void spin(long nsec)
+{
+	long begin = cpu_nsec();
+
+	while (cpu_nsec() - begin < nsec);
+}
+
+/* ************************************************************************** */
+
+static env_result_t critical_job(critical_t *self, void *arg)
+{
+	env_time_t now, deadline = tt_deadline();
+
+	spin(CBS_WORK*1000L);
+
+	now = ENV_TIMER_GET();
+	self->done++;
+	if (ENV_TIME_LE(now, deadline)) {
+		self->in_time++;
+	}
+
+	TT_WITHIN(ENV_MSEC(10), ENV_MSEC(10), self, critical_job, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t hog_job(hog_t *self, void *arg)
+{
+	spin(5000000L);
+	self->cpu += 5000000L;
+
+	TT_BEFORE(ENV_MSEC(1), self, hog_job, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t report_print(tt_object_t *self, void *arg)
+{
+	env_time_t now = ENV_TIMER_GET();
+	long elapsed = ENV_TIME_DIFF(now, start);
+
+	printf(
+			"cbs: server=%d critical_done=%lu critical_in_time=%lu"
+			" expected=%d hog_share=%.3f postponed=%lu\n",
+			served,
+			critical.done,
+			critical.in_time,
+			CBS_SECONDS*100,
+			(double)hog.cpu/elapsed,
+			server.postponed
+			);
+	fflush(stdout);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	if (getenv("CBS_SERVER")) {
+		served = atoi(getenv("CBS_SERVER"));
+	}
+
+	tt_server_init(&server, ENV_USEC(CBS_BUDGET), ENV_MSEC(10));
+	if (served) {
+		tt_server_attach(&server, &hog.obj);
+	}
+	start = ENV_TIMER_GET();
+
+	TT_WITHIN(ENV_MSEC(10), ENV_MSEC(10), &critical, critical_job, TT_ARGS_NONE);
+	TT_BEFORE(ENV_MSEC(1), &hog, hog_job, TT_ARGS_NONE);
+
+	/* Inherits the startup deadline, earlier than anything else. */
+	TT_AFTER(ENV_SEC(CBS_SECONDS), &report, report_print, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Release jitter benchmark.
+ *
+ * A ticker runs every JITTER_PERIOD microseconds and records how late it
+ * was dispatched relative to its baseline. Prints percentiles and a log2
+ * histogram. Build once as is and once with "make ENV=posix RT=yes" to
+ * compare against pinned, realtime priority and locked memory, ideally
+ * with some load on the machine.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <posix/rt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+
+/* ************************************************************************** */
+
+#ifndef JITTER_PERIOD
+#	define JITTER_PERIOD 1000
+#endif
+
+#ifndef JITTER_SAMPLES
+#	define JITTER_SAMPLES 10000
+#endif
+
+#define JITTER_BUCKETS 20
+
+/* ************************************************************************** */
+
+typedef struct ticker_t
+{
+	tt_object_t obj;
+	int samples;
+	long latency[JITTER_SAMPLES];
+} ticker_t;
+
+static ticker_t ticker = {tt_object()};
+
+/* ************************************************************************** */
+
+static int compare_long(const void *v0, const void *v1)
+{
+	long l0 = *(const long *)v0, l1 = *(const long *)v1;
+	return l0 < l1 ? -1 : l0 > l1;
+}
+
+static const char *policy_name(int policy)
+{
+	switch (policy) {
+		case -1:
+			return "disabled";
+		case SCHED_FIFO:
+			return "fifo";
+		case 6:
+			return "deadline";
+		default:
+			return "other";
+	}
+}
+
+static void report(ticker_t *self)
+{
+	int i, b, n = self->samples;
+	long *l = self->latency;
+	int hist[JITTER_BUCKETS] = {0};
+
+	qsort(l, n, sizeof(*l), compare_long);
+	for (i=0;i<n;i++) {
+		for (b=0;b<JITTER_BUCKETS-1 && l[i] >= (1L << b);b++);
+		hist[b]++;
+	}
+
+	printf(
+			"jitter: policy=%s locked=%d samples=%d "
+			"p50_us=%ld p99_us=%ld p999_us=%ld max_us=%ld\n",
+			policy_name(posix_rt_policy()),
+			posix_rt_locked(),
+			n,
+			l[n/2],
+			l[n*99/100],
+			l[n*999/1000],
+			l[n-1]
+			);
+	for (b=0;b<JITTER_BUCKETS;b++) {
+		if (hist[b]) {
+			printf("hist: lt_us=%ld count=%d\n", 1L << b, hist[b]);
+		}
+	}
+	fflush(stdout);
+}
+
+static env_result_t ticker_tick(ticker_t *self, void *arg)
+{
+	env_time_t now = ENV_TIMER_GET(), baseline = tt_baseline();
+
+	self->latency[self->samples++] =
+		(now.tv_sec - baseline.tv_sec)*1000000L +
+		(now.tv_nsec - baseline.tv_nsec)/1000L;
+
+	if (self->samples == JITTER_SAMPLES) {
+		report(self);
+		exit(0);
+	}
+
+	TT_WITHIN(ENV_USEC(JITTER_PERIOD), ENV_USEC(JITTER_PERIOD), self, ticker_tick, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	TT_AFTER(ENV_MSEC(10), &ticker, ticker_tick, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Kernel micro benchmarks on the bench environment (ENV=bench, with or
+ * without SRP=yes), in cycles of the cycle counter:
+ *
+ *	overhead:	two back to back reads of the cycle counter.
+ *	post:		tt_action() of a released message, BENCH_DEPTH - 1
+ *			messages already active (sorted by deadline).
+ *	enqueue:	tt_action() of a future message, BENCH_DEPTH - 1
+ *			messages already pending (sorted by baseline).
+ *	expire:		timer expiry releasing one of BENCH_DEPTH pending
+ *			messages (tt_expired()).
+ *	schedule:	tt_schedule() of one active message, the dispatch, an
+ *			empty method and the completion.
+ *	cancel:		tt_cancel() of one of BENCH_DEPTH pending messages.
+ *	walk:		tt_action() of a future message at the tail of
+ *			BENCH_DEPTH - 1 pending messages, the full queue walk.
+ *
+ * The depth is set with make DEPTH=n (64 by default), the message pool
+ * grows with it. Deep queues show the cache footprint of the message
+ * layout, compare with make MESSAGE_SPLIT=yes MESSAGE_INDEX=yes.
+ *
+ * The overhead is not subtracted. Every benchmark prints one line:
+ *
+ *	bench=post env=bench kernel=regular depth=64 unit=cycles count=.. min=..
+ *	mean=.. p50=.. p90=.. p99=.. p999=.. max=..
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined TT_SRP
+#	include "app_objects.h"
+#endif
+
+/* ************************************************************************** */
+
+#ifndef BENCH_SAMPLES
+#	define BENCH_SAMPLES 10000
+#endif
+
+#ifndef BENCH_DEPTH
+#	define BENCH_DEPTH 64
+#endif
+
+#if defined TT_SRP
+#	define BENCH_KERNEL "srp"
+#	define bench_object(id, req) tt_object(id, req)
+#else
+#	define BENCH_KERNEL "regular"
+#	define bench_object(id, req) tt_object()
+#endif
+
+/* ************************************************************************** */
+
+static tt_object_t sink = bench_object(SINK, 0);
+
+#if defined TT_SRP
+tt_object_t *app_objects[APP_OBJECT_ID_MAX] = {
+	&sink
+};
+#endif
+
+static unsigned long samples[BENCH_SAMPLES];
+static int num_samples;
+static tt_receipt_t receipts[BENCH_DEPTH];
+static unsigned long seed = 1;
+
+/* ************************************************************************** */
+
+static unsigned long random_next(unsigned long range)
+{
+	/* Numerical Recipes LCG, plenty for shuffling queue positions. */
+	seed = seed*1664525UL + 1013904223UL;
+	return ((seed >> 8) & 0xffffffUL) % range;
+}
+
+static void sample(unsigned long long value)
+{
+	if (num_samples < BENCH_SAMPLES) {
+		samples[num_samples++] = (unsigned long)value;
+	}
+}
+
+static int compare(const void *v0, const void *v1)
+{
+	unsigned long s0 = *(const unsigned long *)v0;
+	unsigned long s1 = *(const unsigned long *)v1;
+
+	return s0 < s1 ? -1 : s0 > s1;
+}
+
+static unsigned long percentile(int permille)
+{
+	int i = (int)(((long long)num_samples*permille + 999)/1000) - 1;
+
+	return samples[i < 0 ? 0 : i];
+}
+
+static void report(const char *name)
+{
+	int i;
+	unsigned long long sum = 0;
+
+	qsort(samples, num_samples, sizeof(samples[0]), compare);
+	for (i=0;i<num_samples;i++) {
+		sum += samples[i];
+	}
+
+	printf(
+			"bench=%s env=bench kernel=%s depth=%d unit=cycles count=%d min=%lu"
+			" mean=%llu p50=%lu p90=%lu p99=%lu p999=%lu max=%lu\n",
+			name,
+			BENCH_KERNEL,
+			BENCH_DEPTH,
+			num_samples,
+			samples[0],
+			sum/num_samples,
+			percentile(500),
+			percentile(900),
+			percentile(990),
+			percentile(999),
+			samples[num_samples-1]
+			);
+	fflush(stdout);
+	num_samples = 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t sink_nop(tt_object_t *self, void *arg)
+{
+	return 0;
+}
+
+/* ************************************************************************** */
+
+/*
+ * Post BENCH_DEPTH - 1 messages at random positions of the queue, either
+ * released (deadline order) or pending (baseline order).
+ */
+static void fill(int pending)
+{
+	int i;
+
+	for (i=0;i<BENCH_DEPTH-1;i++) {
+		if (pending) {
+			TT_AFTER_R(
+					ENV_USEC(2 + random_next(BENCH_DEPTH)),
+					&sink,
+					sink_nop,
+					TT_ARGS_NONE,
+					&receipts[i]
+					);
+		} else {
+			TT_BEFORE(
+					ENV_USEC(1 + random_next(BENCH_DEPTH)),
+					&sink,
+					sink_nop,
+					TT_ARGS_NONE
+					);
+		}
+	}
+}
+
+/* Run everything, the virtual time moves past all pending messages. */
+static void drain(void)
+{
+	bench_advance(ENV_TIMER_GET() + ENV_USEC(2*BENCH_DEPTH));
+}
+
+/* ************************************************************************** */
+
+static void micro_overhead(void)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		t0 = ENV_CYCLES();
+		sample(ENV_CYCLES() - t0);
+	}
+	report("overhead");
+}
+
+static void micro_post(void)
+{
+	int i;
+	env_time_t dl;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		fill(0);
+		dl = ENV_USEC(1 + random_next(BENCH_DEPTH));
+		t0 = ENV_CYCLES();
+		TT_BEFORE(dl, &sink, sink_nop, TT_ARGS_NONE);
+		sample(ENV_CYCLES() - t0);
+		drain();
+	}
+	report("post");
+}
+
+static void micro_enqueue(void)
+{
+	int i;
+	env_time_t bl;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		fill(1);
+		bl = ENV_USEC(1 + random_next(BENCH_DEPTH));
+		t0 = ENV_CYCLES();
+		TT_AFTER(bl, &sink, sink_nop, TT_ARGS_NONE);
+		sample(ENV_CYCLES() - t0);
+		drain();
+	}
+	report("enqueue");
+}
+
+static void micro_expire(void)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		fill(1);
+		TT_AFTER(ENV_USEC(1), &sink, sink_nop, TT_ARGS_NONE);
+
+		/* Release the earliest message only, the others are later. */
+		t0 = ENV_CYCLES();
+		bench_expire(ENV_TIMER_GET() + ENV_USEC(1));
+		sample(ENV_CYCLES() - t0);
+		drain();
+	}
+	report("expire");
+}
+
+static void micro_schedule(void)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		TT_ASYNC(&sink, sink_nop, TT_ARGS_NONE);
+		t0 = ENV_CYCLES();
+		tt_schedule();
+		sample(ENV_CYCLES() - t0);
+	}
+	report("schedule");
+}
+
+static void micro_cancel(void)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		fill(1);
+		TT_AFTER_R(
+				ENV_USEC(1 + random_next(BENCH_DEPTH)),
+				&sink,
+				sink_nop,
+				TT_ARGS_NONE,
+				&receipts[BENCH_DEPTH-1]
+				);
+		t0 = ENV_CYCLES();
+		TT_CANCEL(&receipts[random_next(BENCH_DEPTH)]);
+		sample(ENV_CYCLES() - t0);
+		drain();
+	}
+	report("cancel");
+}
+
+static void micro_walk(void)
+{
+	int i;
+	unsigned long long t0;
+
+	for (i=0;i<BENCH_SAMPLES;i++) {
+		fill(1);
+		t0 = ENV_CYCLES();
+		TT_AFTER(ENV_USEC(2 + BENCH_DEPTH), &sink, sink_nop, TT_ARGS_NONE);
+		sample(ENV_CYCLES() - t0);
+		drain();
+	}
+	report("walk");
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	micro_overhead();
+	micro_post();
+	micro_enqueue();
+	micro_expire();
+	micro_schedule();
+	micro_cancel();
+	micro_walk();
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Overload benchmark.
+ *
+ * OVERLOAD_TASKS periodic tasks share the processor. A timer interrupt posts a
+ * job of every task each period, relative deadline equal to the period.
+ * A job spins for its share of OVERLOAD_LOAD percent of the processor,
+ * measured in thread CPU time so that preemption is not counted. After
+ * OVERLOAD_SECONDS the jobs that completed in time, the useful work ratio
+ * (processor time spent on jobs that met their deadline) and the misses
+ * counted by the kernel are printed.
+ *
+ * The OVERLOAD_POLICY environment variable selects the shedding policy of
+ * the tasks: none (default), stale, wcet, latest or demote.
+ */
+
+#include <tT.h>
+#include <env.h>
+#include <miss.h>
+#include <shed.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* ************************************************************************** */
+
+#ifndef OVERLOAD_TASKS
+#	define OVERLOAD_TASKS 3
+#endif
+
+#ifndef OVERLOAD_LOAD
+#	define OVERLOAD_LOAD 150
+#endif
+
+#ifndef OVERLOAD_SECONDS
+#	define OVERLOAD_SECONDS 2
+#endif
+
+#ifndef OVERLOAD_PERIOD
+#	define OVERLOAD_PERIOD 10000
+#endif
+
+#define OVERLOAD_INTERRUPT 1
+
+/* ************************************************************************** */
+
+typedef struct task_t
+{
+	tt_object_t obj;
+	long period;
+	long wcet;
+	unsigned long released;
+	unsigned long in_time;
+	unsigned long late;
+} task_t;
+
+static task_t tasks[OVERLOAD_TASKS];
+static unsigned long ticks;
+static tt_object_t report = tt_object();
+static unsigned long handler_calls[2];
+static env_time_t start;
+static const char *policy_name = "none";
+
+/* ************************************************************************** */
+
+static long cpu_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec*1000000000L + ts.tv_nsec;
+}
+
+static env_result_t task_job(task_t *self, void *arg)
+{
+	long begin = cpu_nsec();
+	env_time_t deadline = tt_deadline(), now;
+
+	while (cpu_nsec() - begin < self->wcet);
+
+	now = ENV_TIMER_GET();
+	if (ENV_TIME_LE(now, deadline)) {
+		self->in_time++;
+	} else {
+		self->late++;
+	}
+	return 0;
+}
+
+static void release_interrupt(int id)
+{
+	int i;
+
+	/* Release every task whose period divides the current tick. */
+	for (i=0;i<OVERLOAD_TASKS;i++) {
+		if (ticks % (tasks[i].period / OVERLOAD_PERIOD) == 0) {
+			tasks[i].released++;
+			TT_WITHIN(
+					ENV_SEC(0),
+					ENV_USEC(tasks[i].period),
+					&tasks[i],
+					task_job,
+					TT_ARGS_NONE
+					);
+		}
+	}
+	ticks++;
+
+	tt_schedule();
+}
+
+static void *release_thread(void *arg)
+{
+	struct timespec next;
+
+	clock_gettime(CLOCK_REALTIME, &next);
+	for (;;) {
+		next.tv_nsec += OVERLOAD_PERIOD*1000L;
+		if (next.tv_nsec >= 1000000000L) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+		clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &next, NULL);
+		ENV_EXT_INTERRUPT_GENERATE(OVERLOAD_INTERRUPT);
+	}
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+static void miss_handler(tt_object_t *to, tt_method_t method, int kind)
+{
+	handler_calls[kind]++;
+}
+
+static env_result_t report_print(tt_object_t *self, void *arg)
+{
+	int i, j;
+	long elapsed;
+	double useful = 0;
+	tt_miss_t *miss;
+	env_time_t now = ENV_TIMER_GET();
+
+	elapsed = ENV_TIME_DIFF(now, start);
+	for (i=0;i<OVERLOAD_TASKS;i++) {
+		useful += (double)tasks[i].in_time*tasks[i].wcet;
+		printf(
+				"task: id=%d period_us=%ld wcet_us=%ld released=%lu"
+				" in_time=%lu late=%lu\n",
+				i,
+				tasks[i].period,
+				tasks[i].wcet/1000,
+				tasks[i].released,
+				tasks[i].in_time,
+				tasks[i].late
+				);
+	}
+
+	for (i=0;i<tt_miss_count();i++) {
+		miss = tt_miss_get(i);
+		for (j=0;j<OVERLOAD_TASKS && miss->to != &tasks[j].obj;j++);
+		if (j < OVERLOAD_TASKS) {
+			printf(
+					"miss: id=%d late=%lu stale=%lu\n",
+					j,
+					miss->late,
+					miss->stale
+					);
+		}
+	}
+
+	printf(
+			"overload: load=%d%% policy=%s useful=%.3f dropped=%lu"
+			" demoted=%lu misses=%lu handler_late=%lu handler_stale=%lu\n",
+			OVERLOAD_LOAD,
+			policy_name,
+			useful/elapsed,
+			tt_shed_dropped(),
+			tt_shed_demoted(),
+			tt_miss_total(),
+			handler_calls[TT_MISS_LATE],
+			handler_calls[TT_MISS_STALE]
+			);
+	fflush(stdout);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static int policy_parse(const char *name)
+{
+	if (!strcmp(name, "stale")) {
+		return TT_SHED_STALE;
+	} else if (!strcmp(name, "wcet")) {
+		return TT_SHED_STALE | TT_SHED_WCET;
+	} else if (!strcmp(name, "latest")) {
+		return TT_SHED_LATEST;
+	} else if (!strcmp(name, "demote")) {
+		return TT_SHED_STALE | TT_SHED_WCET | TT_SHED_DEMOTE;
+	}
+	return 0;
+}
+
+static void init(void)
+{
+	int i, policy = 0;
+	pthread_t thread;
+
+	if (getenv("OVERLOAD_POLICY")) {
+		policy_name = getenv("OVERLOAD_POLICY");
+		policy = policy_parse(policy_name);
+	}
+
+	for (i=0;i<OVERLOAD_TASKS;i++) {
+		tasks[i].obj = (tt_object_t)tt_object();
+		tasks[i].period = OVERLOAD_PERIOD << i;
+		tasks[i].wcet = tasks[i].period*10L*OVERLOAD_LOAD/OVERLOAD_TASKS;
+		tt_shed_policy(
+				&tasks[i].obj,
+				policy,
+				ENV_USEC(tasks[i].wcet/1000)
+				);
+	}
+
+	tt_miss_handler(miss_handler);
+	start = ENV_TIMER_GET();
+
+	ENV_EXT_INTERRUPT_HANDLER(OVERLOAD_INTERRUPT, release_interrupt);
+	if (pthread_create(&thread, NULL, release_thread, NULL)) {
+		ENV_PANIC("init(): Unable to create the release thread.\n");
+	}
+	TT_WITHIN(
+			ENV_SEC(OVERLOAD_SECONDS),
+			ENV_MSEC(1),
+			&report,
+			report_print,
+			TT_ARGS_NONE
+			);
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compute offload benchmark.
+ *
+ * A ticker object with a tight deadline runs every millisecond and records
+ * the jitter of its dispatch, the time from its baseline to the start of
+ * the method. Meanwhile a bulk object checksums a large
+ * buffer over and over, first nothing at all, then inline in its method
+ * and last offloaded to the worker pool with posix_parallel_for(). Each
+ * phase prints the ticker jitter percentiles and the bulk throughput.
+ *
+ * The bulk object reposts itself with a (tiny) baseline offset so that
+ * every pass gets a fresh deadline, an inherited baseline would make its
+ * deadline expire and EDF would then rightfully prefer it over the ticker.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <posix/pool.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+#ifndef POOL_WORDS
+#	define POOL_WORDS (4*1024*1024)
+#endif
+
+#ifndef POOL_THREADS
+#	define POOL_THREADS 4
+#endif
+
+#ifndef POOL_SAMPLES
+#	define POOL_SAMPLES 8192
+#endif
+
+#define POOL_INTERRUPT 2
+
+/* ************************************************************************** */
+
+enum
+{
+	PHASE_IDLE,
+	PHASE_INLINE,
+	PHASE_OFFLOAD,
+	PHASE_DONE
+};
+
+static const char *phase_name[] = {
+	"idle",
+	"inline",
+	"offload"
+};
+
+typedef struct ticker_t
+{
+	tt_object_t obj;
+	int samples;
+	long latency[POOL_SAMPLES];
+} ticker_t;
+
+typedef struct bulk_t
+{
+	tt_object_t obj;
+	int phase;
+	int busy;
+	unsigned long passes;
+	uint32_t sum;
+	uint32_t *buf;
+	posix_parallel_t parallel;
+} bulk_t;
+
+static ticker_t ticker = {tt_object()};
+static bulk_t bulk = {tt_object()};
+
+static env_result_t bulk_run(bulk_t *, void *);
+
+/* ************************************************************************** */
+
+static int compare_long(const void *v0, const void *v1)
+{
+	long l0 = *(const long *)v0, l1 = *(const long *)v1;
+	return l0 < l1 ? -1 : l0 > l1;
+}
+
+static env_result_t ticker_tick(ticker_t *self, void *arg)
+{
+	env_time_t now = ENV_TIMER_GET();
+	env_time_t baseline = tt_baseline();
+
+	if (self->samples < POOL_SAMPLES) {
+		self->latency[self->samples++] = ENV_TIME_DIFF(now, baseline)/1000L;
+	}
+
+	/* The next baseline follows this one, the period does not drift. */
+	TT_WITHIN(ENV_MSEC(1), ENV_MSEC(1), self, ticker_tick, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t ticker_report(ticker_t *self, int *phase)
+{
+	int n = self->samples;
+	long *l = self->latency;
+
+	qsort(l, n, sizeof(*l), compare_long);
+
+	printf(
+			"phase=%s samples=%d p50_us=%ld p90_us=%ld p99_us=%ld max_us=%ld "
+			"bulk_passes=%lu\n",
+			phase_name[*phase],
+			n,
+			n ? l[n/2] : 0,
+			n ? l[n*9/10] : 0,
+			n ? l[n*99/100] : 0,
+			n ? l[n-1] : 0,
+			bulk.passes
+			);
+	fflush(stdout);
+	self->samples = 0;
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void checksum(void *buf, size_t count, void *data)
+{
+	size_t i;
+	uint32_t sum = 0, *tmp = buf;
+
+	for (i=0;i<count;i++) {
+		sum += tmp[i] ^ (sum << 5);
+	}
+	__atomic_add_fetch((uint32_t *)data, sum, __ATOMIC_RELAXED);
+}
+
+static env_result_t bulk_done(bulk_t *self, posix_job_t **job)
+{
+	self->busy = 0;
+	self->passes++;
+	TT_BEFORE(ENV_SEC(1), self, bulk_run, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t bulk_run(bulk_t *self, void *arg)
+{
+	switch (self->phase) {
+		case PHASE_INLINE:
+			checksum(self->buf, POOL_WORDS, &self->sum);
+			self->passes++;
+			TT_WITHIN(ENV_USEC(1), ENV_SEC(1), self, bulk_run, TT_ARGS_NONE);
+			break;
+
+		case PHASE_OFFLOAD:
+			/* The descriptor is in use until the completion arrives. */
+			if (self->busy) {
+				break;
+			}
+			self->busy = 1;
+			posix_parallel_for(
+					&self->parallel,
+					self->buf,
+					POOL_WORDS,
+					sizeof(*self->buf),
+					checksum,
+					&self->sum,
+					&self->obj,
+					(tt_method_t)bulk_done,
+					ENV_SEC(1)
+					);
+			break;
+
+		default:
+			break;
+	}
+	return 0;
+}
+
+static env_result_t bulk_phase(bulk_t *self, int *phase)
+{
+	int old = self->phase;
+
+	TT_SYNC(&ticker, ticker_report, &old);
+	if (*phase == PHASE_DONE) {
+		exit(0);
+	}
+
+	/* The old phase drains on its own, passes are counted from here. */
+	self->phase = *phase;
+	self->passes = 0;
+	TT_BEFORE(ENV_SEC(1), self, bulk_run, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+	static int phases[] = {PHASE_INLINE, PHASE_OFFLOAD, PHASE_DONE};
+
+	posix_pool_init(POOL_INTERRUPT, POOL_THREADS);
+
+	bulk.buf = malloc(POOL_WORDS*sizeof(*bulk.buf));
+	if (!bulk.buf) {
+		ENV_PANIC("init(): Unable to allocate buffer.\n");
+	}
+	for (i=0;i<POOL_WORDS;i++) {
+		bulk.buf[i] = i*2654435761u;
+	}
+
+	printf("pool: threads=%d words=%d\n", POOL_THREADS, POOL_WORDS);
+
+	TT_ASYNC(&ticker, ticker_tick, TT_ARGS_NONE);
+	for (i=0;i<3;i++) {
+		TT_AFTER(ENV_SEC(2*(i+1)), &bulk, bulk_phase, &phases[i]);
+	}
+}
+
+ENV_STARTUP(init);
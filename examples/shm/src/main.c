@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Shared memory channel benchmark.
+ *
+ * Run two instances, "SHM_ROLE=pong ./app.elf &" and "./app.elf". The ping
+ * side first streams SHM_MESSAGES messages into the pong inbox as fast as
+ * the ring allows and reports the throughput once pong has seen them all,
+ * then measures the round trip latency of SHM_SAMPLES echoes. The echoes
+ * are forwarded with posix_shm_forward() so they keep their deadline. Both
+ * sides unlink their inbox when they quit.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <posix/shm.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+#ifndef SHM_MESSAGES
+#	define SHM_MESSAGES 1000000
+#endif
+
+#ifndef SHM_SAMPLES
+#	define SHM_SAMPLES 10000
+#endif
+
+#ifndef SHM_SLOTS
+#	define SHM_SLOTS 1024
+#endif
+
+#define SHM_INTERRUPT 2
+
+#define SHM_PING "/tt_shm_ping"
+#define SHM_PONG "/tt_shm_pong"
+
+enum
+{
+	/* Exported by ping. */
+	PING_DONE,
+	PING_ECHO,
+
+	/* Exported by pong. */
+	PONG_SINK = 0,
+	PONG_ECHO,
+	PONG_QUIT
+};
+
+/* ************************************************************************** */
+
+typedef struct ping_t
+{
+	tt_object_t obj;
+	long sent;
+	long samples;
+	uint64_t start;
+	long latency[SHM_SAMPLES];
+} ping_t;
+
+typedef struct pong_t
+{
+	tt_object_t obj;
+	long received;
+} pong_t;
+
+static ping_t ping = {tt_object()};
+static pong_t pong = {tt_object()};
+
+static posix_shm_proxy_t proxy_sink = posix_shm_proxy(PONG_SINK);
+static posix_shm_proxy_t proxy_echo = posix_shm_proxy(PONG_ECHO);
+static posix_shm_proxy_t proxy_quit = posix_shm_proxy(PONG_QUIT);
+static posix_shm_proxy_t proxy_done = posix_shm_proxy(PING_DONE);
+static posix_shm_proxy_t proxy_reply = posix_shm_proxy(PING_ECHO);
+
+/* ************************************************************************** */
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static int compare_long(const void *v0, const void *v1)
+{
+	long l0 = *(const long *)v0, l1 = *(const long *)v1;
+	return l0 < l1 ? -1 : l0 > l1;
+}
+
+/* ************************************************************************** */
+
+static env_result_t ping_stream(ping_t *self, void *arg)
+{
+	while (self->sent < SHM_MESSAGES) {
+		if (posix_shm_send(&proxy_sink, &self->sent, sizeof(self->sent))) {
+			/* Ring full, let the other side catch up. */
+			TT_WITHIN(ENV_USEC(1), ENV_MSEC(10), self, ping_stream, TT_ARGS_NONE);
+			return 0;
+		}
+		self->sent++;
+	}
+	return 0;
+}
+
+static env_result_t ping_quit(ping_t *self, void *arg)
+{
+	posix_shm_unlink(SHM_PING);
+	exit(0);
+	return 0;
+}
+
+static env_result_t ping_send(ping_t *self, void *arg)
+{
+	uint64_t stamp = now_ns();
+
+	TT_BEFORE(ENV_MSEC(1), &proxy_echo, posix_shm_forward, &stamp);
+	return 0;
+}
+
+static env_result_t ping_echo(ping_t *self, uint64_t *stamp)
+{
+	int n;
+	long *l = self->latency;
+
+	l[self->samples++] = (now_ns() - *stamp)/1000;
+	if (self->samples < SHM_SAMPLES) {
+		/* Space the samples out a bit, the timer resolution is plenty. */
+		TT_WITHIN(ENV_USEC(100), ENV_MSEC(1), self, ping_send, TT_ARGS_NONE);
+		return 0;
+	}
+
+	n = self->samples;
+	qsort(l, n, sizeof(*l), compare_long);
+	printf(
+			"latency: samples=%d p50_us=%ld p90_us=%ld p99_us=%ld max_us=%ld\n",
+			n,
+			l[n/2],
+			l[n*9/10],
+			l[n*99/100],
+			l[n-1]
+			);
+	fflush(stdout);
+
+	TT_ASYNC(&proxy_quit, posix_shm_forward, TT_ARGS_NONE);
+	TT_AFTER(ENV_MSEC(10), self, ping_quit, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t ping_done(ping_t *self, long *received)
+{
+	double seconds = (now_ns() - self->start)/1e9;
+
+	printf(
+			"throughput: messages=%ld seconds=%.3f msgs_per_sec=%.0f\n",
+			*received,
+			seconds,
+			*received/seconds
+			);
+	fflush(stdout);
+
+	TT_ASYNC(self, ping_send, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t ping_connect(ping_t *self, void *arg)
+{
+	posix_shm_t *shm = posix_shm_connect(SHM_PONG);
+
+	if (!shm) {
+		TT_AFTER(ENV_MSEC(100), self, ping_connect, TT_ARGS_NONE);
+		return 0;
+	}
+	proxy_sink.shm = proxy_echo.shm = proxy_quit.shm = shm;
+
+	printf("shm: messages=%d samples=%d slots=%d\n",
+			SHM_MESSAGES, SHM_SAMPLES, SHM_SLOTS);
+	self->start = now_ns();
+	TT_ASYNC(self, ping_stream, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static int pong_connect(void)
+{
+	if (!proxy_done.shm) {
+		proxy_done.shm = proxy_reply.shm = posix_shm_connect(SHM_PING);
+	}
+	return proxy_done.shm != NULL;
+}
+
+static env_result_t pong_sink(pong_t *self, long *seq)
+{
+	self->received++;
+	if (*seq == SHM_MESSAGES - 1 && pong_connect()) {
+		TT_ASYNC(&proxy_done, posix_shm_forward, &self->received);
+		self->received = 0;
+	}
+	return 0;
+}
+
+static env_result_t pong_echo(pong_t *self, uint64_t *stamp)
+{
+	if (pong_connect()) {
+		TT_ASYNC(&proxy_reply, posix_shm_forward, stamp);
+	}
+	return 0;
+}
+
+static env_result_t pong_quit(pong_t *self, void *arg)
+{
+	posix_shm_unlink(SHM_PONG);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	posix_shm_t *inbox;
+	const char *role = getenv("SHM_ROLE");
+
+	if (role && !strcmp(role, "pong")) {
+		inbox = posix_shm_inbox(SHM_PONG, SHM_SLOTS, SHM_INTERRUPT);
+		posix_shm_export(inbox, PONG_SINK, &pong.obj, (tt_method_t)pong_sink);
+		posix_shm_export(inbox, PONG_ECHO, &pong.obj, (tt_method_t)pong_echo);
+		posix_shm_export(inbox, PONG_QUIT, &pong.obj, (tt_method_t)pong_quit);
+		return;
+	}
+
+	inbox = posix_shm_inbox(SHM_PING, SHM_SLOTS, SHM_INTERRUPT);
+	posix_shm_export(inbox, PING_DONE, &ping.obj, (tt_method_t)ping_done);
+	posix_shm_export(inbox, PING_ECHO, &ping.obj, (tt_method_t)ping_echo);
+	TT_ASYNC(&ping, ping_connect, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
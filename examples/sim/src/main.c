@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Simulated time example (ENV=sim, with or without SRP=yes).
+ *
+ * Three periodic tasks with a utilization of 70%, two are charged by the
+ * cost model when they are dispatched, the third charges a varying
+ * execution time itself with sim_consume(). Run an hour of the schedule
+ * with:
+ *
+ *	TT_SIM_END=3600 ./sim/app.elf
+ *
+ * Prints one line per task at the end, times in nanoseconds:
+ *
+ *	task=0 period=.. cost=.. jobs=.. misses=.. max_response=..
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined TT_SRP
+#	include "app_objects.h"
+#	define sim_object(id, req) tt_object(id, req)
+#else
+#	define sim_object(id, req) tt_object()
+#endif
+
+/* ************************************************************************** */
+
+#define NUM_TASKS 3
+
+typedef struct task_t
+{
+	tt_object_t obj;
+	unsigned long period;
+	unsigned long cost;
+	int consume;
+	unsigned long jobs;
+	unsigned long misses;
+	unsigned long max_response;
+} task_t;
+
+static task_t tasks[NUM_TASKS] = {
+	{sim_object(TASK0, 0), 10, 3, 0},
+	{sim_object(TASK1, 0), 25, 5, 0},
+	{sim_object(TASK2, 0), 100, 20, 1}
+};
+
+#if defined TT_SRP
+tt_object_t *app_objects[APP_OBJECT_ID_MAX] = {
+	&tasks[0].obj,
+	&tasks[1].obj,
+	&tasks[2].obj
+};
+#endif
+
+static unsigned long seed = 1;
+
+/* ************************************************************************** */
+
+static env_result_t task_run(task_t *self, void *arg)
+{
+	env_time_t now;
+
+	/* Between half and all of the cost, deterministically. */
+	if (self->consume) {
+		seed = seed*1664525UL + 1013904223UL;
+		sim_consume(
+				ENV_MSEC(self->cost)/2 +
+				(seed >> 8) % (ENV_MSEC(self->cost)/2 + 1)
+				);
+	}
+
+	now = ENV_TIMER_GET();
+	self->jobs++;
+	if (ENV_TIME_LT(tt_deadline(), now)) {
+		self->misses++;
+	}
+	if (now - tt_baseline() > self->max_response) {
+		self->max_response = now - tt_baseline();
+	}
+
+	TT_WITHIN(
+			ENV_MSEC(self->period),
+			ENV_MSEC(self->period),
+			self,
+			task_run,
+			TT_ARGS_NONE
+			);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_time_t cost_model(tt_object_t *to, tt_method_t method)
+{
+	task_t *task = (task_t *)to;
+
+	return task->consume ? 0 : ENV_MSEC(task->cost);
+}
+
+/* ************************************************************************** */
+
+static void report(void)
+{
+	int i;
+
+	for (i=0;i<NUM_TASKS;i++) {
+		printf(
+				"task=%d period=%lu cost=%lu jobs=%lu misses=%lu"
+				" max_response=%lu\n",
+				i,
+				(unsigned long)ENV_MSEC(tasks[i].period),
+				(unsigned long)ENV_MSEC(tasks[i].cost),
+				tasks[i].jobs,
+				tasks[i].misses,
+				tasks[i].max_response
+				);
+	}
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+
+	atexit(report);
+	sim_cost_model(cost_model);
+	for (i=0;i<NUM_TASKS;i++) {
+		TT_WITHIN(
+				ENV_SEC(0),
+				ENV_MSEC(tasks[i].period),
+				&tasks[i],
+				task_run,
+				TT_ARGS_NONE
+				);
+	}
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Socket channel benchmark.
+ *
+ * Run two instances, "SOCK_ROLE=server ./app.elf &" and "./app.elf". The
+ * client streams SOCK_MESSAGES messages to the server, first with
+ * posix_sock_send() straight from a method and then by posting to the
+ * proxy with posix_sock_forward() as method, and reports the messages per
+ * second once the server has seen them all.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <posix/sock.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+#ifndef SOCK_MESSAGES
+#	define SOCK_MESSAGES 1000000
+#endif
+
+#define SOCK_INTERRUPT 2
+
+#define SOCK_SERVER "/tmp/tt_sock_server"
+#define SOCK_CLIENT "/tmp/tt_sock_client"
+
+enum
+{
+	/* Exported by the client. */
+	CLIENT_DONE,
+
+	/* Exported by the server. */
+	SERVER_SINK = 0,
+	SERVER_QUIT
+};
+
+enum
+{
+	PHASE_SEND,
+	PHASE_FORWARD,
+	PHASE_DONE
+};
+
+static const char *phase_name[] = {
+	"send",
+	"forward"
+};
+
+/* ************************************************************************** */
+
+typedef struct client_t
+{
+	tt_object_t obj;
+	int phase;
+	long sent;
+	uint64_t start;
+} client_t;
+
+typedef struct server_t
+{
+	tt_object_t obj;
+	long received;
+} server_t;
+
+static client_t client = {tt_object()};
+static server_t server = {tt_object()};
+
+static posix_sock_proxy_t proxy_sink = posix_sock_proxy(SERVER_SINK);
+static posix_sock_proxy_t proxy_quit = posix_sock_proxy(SERVER_QUIT);
+static posix_sock_proxy_t proxy_done = posix_sock_proxy(CLIENT_DONE);
+
+/* ************************************************************************** */
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+/* ************************************************************************** */
+
+static env_result_t client_stream(client_t *self, void *arg)
+{
+	int i;
+
+	switch (self->phase) {
+		case PHASE_SEND:
+			while (self->sent < SOCK_MESSAGES) {
+				if (posix_sock_send(&proxy_sink, &self->sent, sizeof(self->sent))) {
+					/* Buffer full, let the writer catch up. */
+					TT_WITHIN(ENV_USEC(1), ENV_MSEC(10), self, client_stream, TT_ARGS_NONE);
+					return 0;
+				}
+				self->sent++;
+			}
+			break;
+
+		case PHASE_FORWARD:
+			/* A few at a time, every forward holds a message. */
+			for (i=0;i<16 && self->sent < SOCK_MESSAGES;i++,self->sent++) {
+				TT_WITHIN(ENV_USEC(1), ENV_MSEC(10), &proxy_sink, posix_sock_forward, &self->sent);
+			}
+			if (self->sent < SOCK_MESSAGES) {
+				TT_WITHIN(ENV_USEC(1), ENV_MSEC(10), self, client_stream, TT_ARGS_NONE);
+			}
+			break;
+
+		default:
+			break;
+	}
+	return 0;
+}
+
+static env_result_t client_quit(client_t *self, void *arg)
+{
+	exit(0);
+	return 0;
+}
+
+static env_result_t client_done(client_t *self, long *received)
+{
+	double seconds = (now_ns() - self->start)/1e9;
+
+	printf(
+			"phase=%s messages=%ld seconds=%.3f msgs_per_sec=%.0f\n",
+			phase_name[self->phase],
+			*received,
+			seconds,
+			*received/seconds
+			);
+	fflush(stdout);
+
+	if (++self->phase == PHASE_DONE) {
+		TT_ASYNC(&proxy_quit, posix_sock_forward, TT_ARGS_NONE);
+		TT_AFTER(ENV_MSEC(10), self, client_quit, TT_ARGS_NONE);
+		return 0;
+	}
+
+	self->sent = 0;
+	self->start = now_ns();
+	TT_ASYNC(self, client_stream, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t client_connect(client_t *self, void *arg)
+{
+	posix_sock_t *sock = posix_sock_connect(SOCK_SERVER);
+
+	if (!sock) {
+		TT_AFTER(ENV_MSEC(100), self, client_connect, TT_ARGS_NONE);
+		return 0;
+	}
+	proxy_sink.sock = proxy_quit.sock = sock;
+
+	printf("sock: messages=%d\n", SOCK_MESSAGES);
+	self->start = now_ns();
+	TT_ASYNC(self, client_stream, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t server_sink(server_t *self, long *seq)
+{
+	/*
+	 * Forwarded messages may run on different kernel threads and arrive
+	 * out of order, the phase is over once all of them are in.
+	 */
+	if (++self->received != SOCK_MESSAGES) {
+		return 0;
+	}
+
+	if (!proxy_done.sock) {
+		proxy_done.sock = posix_sock_connect(SOCK_CLIENT);
+	}
+	if (proxy_done.sock) {
+		TT_ASYNC(&proxy_done, posix_sock_forward, &self->received);
+	}
+	self->received = 0;
+	return 0;
+}
+
+static env_result_t server_quit(server_t *self, void *arg)
+{
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	posix_sock_t *sock;
+	const char *role = getenv("SOCK_ROLE");
+
+	if (role && !strcmp(role, "server")) {
+		sock = posix_sock_listen(SOCK_SERVER, SOCK_INTERRUPT);
+		posix_sock_export(sock, SERVER_SINK, &server.obj, (tt_method_t)server_sink);
+		posix_sock_export(sock, SERVER_QUIT, &server.obj, (tt_method_t)server_quit);
+		return;
+	}
+
+	sock = posix_sock_listen(SOCK_CLIENT, SOCK_INTERRUPT);
+	posix_sock_export(sock, CLIENT_DONE, &client.obj, (tt_method_t)client_done);
+	TT_ASYNC(&client, client_connect, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sporadic servers on interrupt sources.
+ *
+ * The stress harness of the POSIX environment (STRESS=yes) raises
+ * interrupts 7, 8 and 9 as fast as it can. Every interrupt posts a job of
+ * SPORADIC_WORK microseconds to a device object with a 1 ms deadline,
+ * more urgent than anything else in the system. A critical object runs
+ * SPORADIC_CRITICAL microseconds every 10 ms. Without limits the device
+ * jobs take the whole processor and the critical object starves (a device
+ * keeps at most SPORADIC_RING jobs outstanding, like a full receive ring).
+ * With a server of SPORADIC_CAPACITY jobs every 10 ms per interrupt the
+ * devices get a bounded share and the critical object meets its deadlines.
+ *
+ * Set the SPORADIC_LIMIT environment variable to 0 to run without servers.
+ */
+
+#include <tT.h>
+#include <env.h>
+#include <sporadic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ************************************************************************** */
+
+#ifndef SPORADIC_WORK
+#	define SPORADIC_WORK 500
+#endif
+
+#ifndef SPORADIC_CRITICAL
+#	define SPORADIC_CRITICAL 2000
+#endif
+
+#ifndef SPORADIC_CAPACITY
+#	define SPORADIC_CAPACITY 4
+#endif
+
+#ifndef SPORADIC_BACKLOG
+#	define SPORADIC_BACKLOG 2
+#endif
+
+#ifndef SPORADIC_RING
+#	define SPORADIC_RING 64
+#endif
+
+#ifndef SPORADIC_SECONDS
+#	define SPORADIC_SECONDS 2
+#endif
+
+#define SPORADIC_DEVICES 3
+#define SPORADIC_INTERRUPT 7
+
+/* ************************************************************************** */
+
+typedef struct critical_t
+{
+	tt_object_t obj;
+	unsigned long done;
+	unsigned long in_time;
+} critical_t;
+
+typedef struct device_t
+{
+	tt_object_t obj;
+	int outstanding;
+	unsigned long raised;
+	unsigned long done;
+	unsigned long lost;
+} device_t;
+
+static critical_t critical = {tt_object()};
+static device_t device[SPORADIC_DEVICES] = {
+	{tt_object()},
+	{tt_object()},
+	{tt_object()}
+};
+static tt_object_t report = tt_object();
+static tt_sporadic_t server[SPORADIC_DEVICES];
+static int limited = 1;
+static env_time_t start;
+
+/* ************************************************************************** */
+
+static long cpu_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec*1000000000L + ts.tv_nsec;
+}
+
+static void spin(long nsec)
+{
+	long begin = cpu_nsec();
+
+	while (cpu_nsec() - begin < nsec);
+}
+
+/* ************************************************************************** */
+
+static env_result_t critical_job(critical_t *self, void *arg)
+{
+	env_time_t now, deadline = tt_deadline();
+
+	spin(SPORADIC_CRITICAL*1000L);
+
+	now = ENV_TIMER_GET();
+	self->done++;
+	if (ENV_TIME_LE(now, deadline)) {
+		self->in_time++;
+	}
+
+	TT_WITHIN(ENV_MSEC(10), ENV_MSEC(10), self, critical_job, TT_ARGS_NONE);
+	return 0;
+}
+
+static env_result_t device_job(device_t *self, void *arg)
+{
+	spin(SPORADIC_WORK*1000L);
+	self->done++;
+
+	/* The outstanding count is shared with the interrupt handler. */
+	ENV_PROTECT(1);
+	self->outstanding--;
+	ENV_PROTECT(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void device_interrupt(int id)
+{
+	device_t *self = &device[id - SPORADIC_INTERRUPT];
+
+	self->raised++;
+	if (self->outstanding >= SPORADIC_RING) {
+		self->lost++;
+	} else {
+		self->outstanding++;
+		TT_BEFORE(ENV_MSEC(1), self, device_job, TT_ARGS_NONE);
+	}
+
+	tt_schedule();
+}
+
+/* ************************************************************************** */
+
+static env_result_t report_print(tt_object_t *self, void *arg)
+{
+	int i;
+	unsigned long raised = 0, done = 0;
+	unsigned long accepted = 0, deferred = 0, dropped = 0;
+
+	ENV_PROTECT(1);
+	for (i=0;i<SPORADIC_DEVICES;i++) {
+		raised += device[i].raised;
+		done += device[i].done;
+		accepted += server[i].accepted;
+		deferred += server[i].deferred;
+		dropped += server[i].dropped;
+	}
+	ENV_PROTECT(0);
+
+	printf(
+			"sporadic: limit=%d critical_done=%lu critical_in_time=%lu"
+			" expected=%d interrupts=%lu device_done=%lu"
+			" accepted=%lu deferred=%lu dropped=%lu\n",
+			limited,
+			critical.done,
+			critical.in_time,
+			SPORADIC_SECONDS*100,
+			raised,
+			done,
+			accepted,
+			deferred,
+			dropped
+			);
+	fflush(stdout);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+
+	if (getenv("SPORADIC_LIMIT")) {
+		limited = atoi(getenv("SPORADIC_LIMIT"));
+	}
+
+	for (i=0;i<SPORADIC_DEVICES;i++) {
+		tt_sporadic_init(
+				&server[i],
+				SPORADIC_CAPACITY,
+				ENV_MSEC(10),
+				SPORADIC_BACKLOG
+				);
+		ENV_EXT_INTERRUPT_HANDLER(SPORADIC_INTERRUPT + i, device_interrupt);
+		if (limited) {
+			ENV_EXT_INTERRUPT_SPORADIC(SPORADIC_INTERRUPT + i, &server[i]);
+		}
+	}
+	start = ENV_TIMER_GET();
+
+	TT_WITHIN(ENV_MSEC(10), ENV_MSEC(10), &critical, critical_job, TT_ARGS_NONE);
+
+	/* Inherits the startup deadline, earlier than anything else. */
+	TT_AFTER(ENV_SEC(SPORADIC_SECONDS), &report, report_print, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
@@ -0,0 +1,26 @@
+#ifndef APP_OBJECT_H_
+#define APP_OBJECT_H_
+
+#include <taskset.h>
+
+/**
+ * \brief TinyTimber object id enum.
+ *
+ * The tasks and shared objects of the generated task set, in that order,
+ * then the reporter.
+ */
+enum app_objects_t
+{
+#define TASKSET_TASK(id, period, deadline, wcet, sporadic, shared, cs) \
+	TASK##id,
+	TASKSET_TASKS
+#undef TASKSET_TASK
+#define TASKSET_OBJECT(id) \
+	SHARED##id,
+	TASKSET_SHARED
+#undef TASKSET_OBJECT
+	REPORTER,
+	APP_OBJECT_ID_MAX /* MUST NOT BE REMOVED! */
+};
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Synthetic task set (ENV=posix, ENV=posix_srp or ENV=sim [SRP=yes]).
+ *
+ * Runs the task set generated by tools/taskgen into taskset.h (make
+ * TASKSET=dir for another one than src/taskset.h) for TASKSET_DURATION
+ * milliseconds (environment variable, default 2000) and prints one line:
+ *
+ *	taskset env=.. kernel=.. tasks=.. utilization=.. duration=.. jobs=..
+ *	misses=.. miss_ratio=.. lateness_max=.. tardiness_mean=..
+ *	throughput=..
+ *
+ * Lateness is the completion time less the deadline and tardiness the
+ * positive part of it, both in microseconds, throughput is in completed
+ * jobs per second. A task posts its next job when a job completes, so an
+ * overloaded task loses releases instead of piling them up. The execution
+ * time is spun on the processor time of the task (simulated on ENV=sim),
+ * a shared object is called for the middle part of it.
+ */
+
+#include <tT.h>
+#include <env.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <taskset.h>
+
+#if defined TT_SRP
+#	include "app_objects.h"
+#	define TASKSET_KERNEL "srp"
+#	define taskset_object(id, req) tt_object(id, req)
+#else
+#	define TASKSET_KERNEL "regular"
+#	define taskset_object(id, req) tt_object()
+#endif
+
+/* ************************************************************************** */
+
+typedef struct task_t
+{
+	tt_object_t obj;
+	long period;
+	long deadline;
+	long wcet;
+	int sporadic;
+	int shared;
+	long cs;
+	unsigned long seed;
+	unsigned long jobs;
+	unsigned long misses;
+	long lateness_max;
+	unsigned long long tardiness;
+} task_t;
+
+/* ************************************************************************** */
+
+#define TASKSET_TASK(id, period, deadline, wcet, sporadic, shared, cs) \
+	{\
+		taskset_object(\
+				TASK##id,\
+				(shared) < 0 ? 0 : 1 << (TASKSET_NUM_TASKS + (shared))\
+				),\
+		period, deadline, wcet, sporadic, shared, cs, (id) + 1\
+	},
+static task_t tasks[TASKSET_NUM_TASKS] = {
+	TASKSET_TASKS
+};
+#undef TASKSET_TASK
+
+#define TASKSET_OBJECT(id) \
+	taskset_object(SHARED##id, 0),
+static tt_object_t shared[TASKSET_NUM_SHARED + 1] = {
+	TASKSET_SHARED
+};
+#undef TASKSET_OBJECT
+
+static tt_object_t reporter = taskset_object(REPORTER, 0);
+
+#if defined TT_SRP
+#	define TASKSET_TASK(id, period, deadline, wcet, sporadic, shared, cs) \
+		&tasks[id].obj,
+#	define TASKSET_OBJECT(id) \
+		&shared[id],
+tt_object_t *app_objects[APP_OBJECT_ID_MAX] = {
+	TASKSET_TASKS
+	TASKSET_SHARED
+	&reporter
+};
+#	undef TASKSET_TASK
+#	undef TASKSET_OBJECT
+#endif
+
+static long duration = 2000;
+
+#if defined TT_SRP && ! defined ENV_SIM
+/* Nested processor time of the innermost work in progress (single stack). */
+static volatile long * volatile nested;
+#endif
+
+/* ************************************************************************** */
+
+/*
+ * Spend us microseconds of processor time. The SRP kernel preempts on the
+ * same stack, so the work nested in this one is not counted.
+ */
+static void work(long us)
+{
+#if defined ENV_SIM
+	sim_consume(ENV_USEC(us));
+#else
+#	if defined TT_SRP
+	volatile long mine = 0, *outer = nested;
+	long start;
+
+	nested = &mine;
+	start = ENV_CPU_GET();
+	while (ENV_CPU_GET() - start - mine < us*1000L);
+	start = ENV_CPU_GET() - start;
+	nested = outer;
+	if (outer)
+		*outer += start;
+#	else
+	long start = ENV_CPU_GET();
+
+	while (ENV_CPU_GET() - start < us*1000L);
+#	endif
+#endif
+}
+
+/* ************************************************************************** */
+
+static env_result_t shared_work(tt_object_t *self, void *arg)
+{
+	work(*(long *)arg);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t task_job(task_t *self, void *arg)
+{
+	long lateness, before = (self->wcet - self->cs)/2;
+	env_time_t next;
+
+	work(before);
+	if (self->cs) {
+		TT_SYNC(&shared[self->shared], shared_work, &self->cs);
+	}
+	work(self->wcet - self->cs - before);
+
+	lateness = ENV_TIME_DIFF(ENV_TIMER_GET(), tt_deadline())/1000;
+	self->jobs++;
+	if (lateness > 0) {
+		self->misses++;
+		self->tardiness += lateness;
+	}
+	if (self->jobs == 1 || lateness > self->lateness_max) {
+		self->lateness_max = lateness;
+	}
+
+	/* A sporadic task waits up to half a period more, deterministically. */
+	next = ENV_USEC(self->period);
+	if (self->sporadic) {
+		self->seed = self->seed*1664525UL + 1013904223UL;
+		next = ENV_USEC(self->period + (self->seed >> 8) % (self->period/2 + 1));
+	}
+	TT_WITHIN(next, ENV_USEC(self->deadline), self, task_job, TT_ARGS_NONE);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static env_result_t report(tt_object_t *self, void *arg)
+{
+	int i;
+	long lateness_max = 0;
+	unsigned long jobs = 0, misses = 0;
+	unsigned long long tardiness = 0;
+
+	for (i=0;i<TASKSET_NUM_TASKS;i++) {
+		if (tasks[i].jobs && (!jobs || tasks[i].lateness_max > lateness_max)) {
+			lateness_max = tasks[i].lateness_max;
+		}
+		jobs += tasks[i].jobs;
+		misses += tasks[i].misses;
+		tardiness += tasks[i].tardiness;
+	}
+
+	printf(
+			"taskset env=%s kernel=%s tasks=%d utilization=%d.%03d"
+			" duration=%ld jobs=%lu misses=%lu miss_ratio=%.4f"
+			" lateness_max=%ld tardiness_mean=%llu throughput=%.1f\n",
+			TASKSET_ENV,
+			TASKSET_KERNEL,
+			TASKSET_NUM_TASKS,
+			TASKSET_UTILIZATION/1000,
+			TASKSET_UTILIZATION%1000,
+			duration,
+			jobs,
+			misses,
+			jobs ? (double)misses/jobs : 0.0,
+			lateness_max,
+			jobs ? tardiness/jobs : 0,
+			jobs*1000.0/duration
+			);
+	fflush(stdout);
+	exit(0);
+	return 0;
+}
+
+/* ************************************************************************** */
+
+static void init(void)
+{
+	int i;
+
+	if (getenv("TASKSET_DURATION")) {
+		duration = atol(getenv("TASKSET_DURATION"));
+	}
+
+	/* Synchronous release, the reporter stops the run at the end. */
+	for (i=0;i<TASKSET_NUM_TASKS;i++) {
+		TT_WITHIN(
+				ENV_SEC(0),
+				ENV_USEC(tasks[i].deadline),
+				&tasks[i],
+				task_job,
+				TT_ARGS_NONE
+				);
+	}
+	TT_AFTER(ENV_MSEC(duration), &reporter, report, TT_ARGS_NONE);
+}
+
+ENV_STARTUP(init);
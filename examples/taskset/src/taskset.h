@@ -0,0 +1,29 @@
+/*
+ * Generated by tt_taskgen, do not edit:
+ *
+ *	tt_taskgen -n 8 -u 0.7 -o 2 -S 0.25
+ */
+
+#ifndef TASKSET_H_
+#define TASKSET_H_
+
+#define TASKSET_NUM_TASKS 8
+#define TASKSET_NUM_SHARED 2
+#define TASKSET_UTILIZATION 700
+
+/* TASKSET_TASK(id, period, deadline, wcet, sporadic, shared, cs), us. */
+#define TASKSET_TASKS \
+	TASKSET_TASK(0, 70961, 70961, 15647, 0, 1, 1564) \
+	TASKSET_TASK(1, 36883, 36883, 3149, 0, 1, 314) \
+	TASKSET_TASK(2, 18787, 18787, 244, 0, 0, 24) \
+	TASKSET_TASK(3, 33501, 33501, 5866, 0, 0, 586) \
+	TASKSET_TASK(4, 26310, 26310, 1855, 0, 0, 185) \
+	TASKSET_TASK(5, 22208, 22208, 1535, 0, 0, 153) \
+	TASKSET_TASK(6, 33283, 33283, 400, 0, 1, 40) \
+	TASKSET_TASK(7, 13715, 13715, 744, 0, 0, 74)
+
+#define TASKSET_SHARED \
+	TASKSET_OBJECT(0) \
+	TASKSET_OBJECT(1)
+
+#endif
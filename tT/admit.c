@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber online EDF admission control implementation.
+ *
+ * Times are tested in environment units as long long. The processor demand
+ * of the set at time t is the execution time of all releases with an
+ * absolute deadline at or before t, synchronous release at zero. The set
+ * is schedulable if the utilization is at most one and the demand never
+ * exceeds t within the busy period. QPA walks the deadlines backwards from
+ * the end of the busy period, skipping every deadline that can not fail.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <admit.h>
+#endif
+
+#if defined TT_ADMIT
+
+/* ************************************************************************** */
+
+/**
+ * \brief The fixed point shift of the utilization.
+ */
+#define ADMIT_SHIFT 20
+
+/** \cond */
+static tt_activity_t *activities;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/** \cond */
+#define PERIOD(a) admit_units((a)->period)
+#define DEADLINE(a) admit_units((a)->deadline)
+#define WCET(a) admit_units((a)->wcet)
+/** \endcond */
+
+/**
+ * \brief Time in environment units.
+ */
+static long long admit_units(env_time_t time)
+{
+	env_time_t zero = ENV_SEC(0);
+
+	return ENV_TIME_DIFF(time, zero);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief The processor demand of the set at t.
+ */
+static long long admit_demand(tt_activity_t *set, long long t)
+{
+	long long demand = 0;
+
+	for (;set;set=set->next) {
+		if (DEADLINE(set) <= t) {
+			demand += ((t - DEADLINE(set))/PERIOD(set) + 1)*WCET(set);
+		}
+	}
+
+	return demand;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief The latest absolute deadline of the set before t, -1 if none.
+ */
+static long long admit_before(tt_activity_t *set, long long t)
+{
+	long long d, latest = -1;
+
+	for (;set;set=set->next) {
+		if (DEADLINE(set) < t) {
+			d = DEADLINE(set) +
+				((t - DEADLINE(set) - 1)/PERIOD(set))*PERIOD(set);
+			if (d > latest) {
+				latest = d;
+			}
+		}
+	}
+
+	return latest;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief The EDF schedulability test of the set.
+ *
+ * \return Non-zero if schedulable, zero if not or if the iteration limit
+ * was reached.
+ */
+static int admit_test(tt_activity_t *set)
+{
+	int i;
+	tt_activity_t *tmp;
+	long long t, demand, busy = 0, next, shortest = -1;
+	unsigned long long load = 0;
+
+	/* Sanity of the declarations, utilization rounded up. */
+	for (tmp=set;tmp;tmp=tmp->next) {
+		if (PERIOD(tmp) <= 0 || DEADLINE(tmp) <= 0 || WCET(tmp) < 0) {
+			return 0;
+		}
+		load += (((unsigned long long)WCET(tmp) << ADMIT_SHIFT) +
+				PERIOD(tmp) - 1)/PERIOD(tmp);
+		if (shortest < 0 || DEADLINE(tmp) < shortest) {
+			shortest = DEADLINE(tmp);
+		}
+		busy += WCET(tmp);
+	}
+	if (load > (1ULL << ADMIT_SHIFT)) {
+		return 0;
+	}
+
+	/* The synchronous busy period. */
+	for (i=0;;i++) {
+		if (i == TT_ADMIT_ITERATIONS) {
+			return 0;
+		}
+		next = 0;
+		for (tmp=set;tmp;tmp=tmp->next) {
+			next += ((busy + PERIOD(tmp) - 1)/PERIOD(tmp))*WCET(tmp);
+		}
+		if (next == busy) {
+			break;
+		}
+		busy = next;
+	}
+
+	/* Quick processor-demand analysis. */
+	t = admit_before(set, busy + 1);
+	for (i=0;t>=0;i++) {
+		if (i == TT_ADMIT_ITERATIONS) {
+			return 0;
+		}
+		demand = admit_demand(set, t);
+		if (demand > t) {
+			return 0;
+		}
+		if (demand <= shortest) {
+			return 1;
+		}
+		t = demand < t ? demand : admit_before(set, t);
+	}
+
+	return 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber admit function.
+ *
+ * Tests the admitted set together with the new activity and admits the
+ * activity if the set stays schedulable. The test runs in protected mode,
+ * bounded by TT_ADMIT_ITERATIONS.
+ *
+ * \param activity The activity.
+ * \param period The period.
+ * \param deadline The relative deadline.
+ * \param wcet The worst case execution time of one release.
+ * \param flags TT_ADMIT_DEGRADE to stretch rather than reject.
+ * \return TT_ADMIT_ACCEPTED, TT_ADMIT_DEGRADED with activity->period and
+ * activity->deadline stretched, or TT_ADMIT_REJECTED.
+ */
+int tt_admit(
+		tt_activity_t *activity,
+		env_time_t period,
+		env_time_t deadline,
+		env_time_t wcet,
+		int flags
+		)
+{
+	int protected = ENV_ISPROTECTED();
+	int result = TT_ADMIT_REJECTED;
+
+	activity->period = period;
+	activity->deadline = deadline;
+	activity->wcet = wcet;
+	activity->stretch = 1;
+
+	ENV_PROTECT(1);
+
+	activity->next = activities;
+	while (!admit_test(activity)) {
+		if (
+			!(flags & TT_ADMIT_DEGRADE) ||
+			activity->stretch == TT_ADMIT_STRETCH
+			) {
+			activity->stretch = 0;
+			break;
+		}
+		activity->period = ENV_TIME_ADD(activity->period, period);
+		activity->deadline = ENV_TIME_ADD(activity->deadline, deadline);
+		activity->stretch++;
+	}
+
+	if (activity->stretch) {
+		activities = activity;
+		result = activity->stretch == 1 ?
+			TT_ADMIT_ACCEPTED : TT_ADMIT_DEGRADED;
+	} else {
+		activity->next = NULL;
+	}
+
+	ENV_PROTECT(protected);
+
+	return result;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber admit remove function.
+ *
+ * Releases the bandwidth of an admitted activity.
+ *
+ * \param activity The activity.
+ */
+void tt_admit_remove(tt_activity_t *activity)
+{
+	int protected = ENV_ISPROTECTED();
+	tt_activity_t **prev;
+
+	ENV_PROTECT(1);
+
+	for (prev=&activities;*prev;prev=&(*prev)->next) {
+		if (*prev == activity) {
+			*prev = activity->next;
+			activity->next = NULL;
+			break;
+		}
+	}
+
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber admit load function.
+ *
+ * \return The utilization of the admitted activities in per mille.
+ */
+int tt_admit_load(void)
+{
+	int protected = ENV_ISPROTECTED();
+	tt_activity_t *tmp;
+	long long load = 0;
+
+	ENV_PROTECT(1);
+
+	for (tmp=activities;tmp;tmp=tmp->next) {
+		load += WCET(tmp)*1000/PERIOD(tmp);
+	}
+
+	ENV_PROTECT(protected);
+
+	return (int)load;
+}
+
+#endif /* TT_ADMIT */
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber online EDF admission control.
+ *
+ * Compiled in when TT_ADMIT is defined (make ADMIT=yes). Periodic
+ * activities declare their period, relative deadline and worst case
+ * execution time with tt_admit() before they start posting. The activity is
+ * only admitted if the declared set, with the new activity, stays
+ * schedulable under EDF, tested with the processor demand criterion over
+ * the synchronous busy period (quick processor-demand analysis, QPA). A
+ * rejected activity may instead be degraded, its period and deadline
+ * stretched until the set fits.
+ *
+ * The kernel does not enforce the declarations, an activity posts its own
+ * messages with the admitted period and deadline (TT_WITHIN).
+ */
+
+#ifndef ADMIT_H_
+#define ADMIT_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber admission flags.
+ */
+enum
+{
+	/**
+	 * \brief Stretch the period and deadline of an activity that does not
+	 * fit instead of rejecting it.
+	 */
+	TT_ADMIT_DEGRADE = 0x01
+};
+
+/**
+ * \brief TinyTimber admission results.
+ */
+enum
+{
+	/**
+	 * \brief The activity would make the set unschedulable.
+	 */
+	TT_ADMIT_REJECTED,
+
+	/**
+	 * \brief The activity was admitted as declared.
+	 */
+	TT_ADMIT_ACCEPTED,
+
+	/**
+	 * \brief The activity was admitted with a stretched period.
+	 */
+	TT_ADMIT_DEGRADED
+};
+
+/* ************************************************************************** */
+
+#if defined TT_ADMIT
+
+#if defined TT_TIMBER
+#	error TT_ADMIT is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_ADMIT_ITERATIONS
+	/**
+	 * \brief The iteration limit of the test, sets beyond it are rejected.
+	 */
+#	define TT_ADMIT_ITERATIONS 1024
+#endif
+
+#ifndef TT_ADMIT_STRETCH
+	/**
+	 * \brief The largest factor a degraded period is stretched by.
+	 */
+#	define TT_ADMIT_STRETCH 8
+#endif
+
+/**
+ * \brief TinyTimber periodic activity.
+ */
+typedef struct tt_activity_t
+{
+	/**
+	 * \brief The period, stretched if degraded.
+	 */
+	env_time_t period;
+
+	/**
+	 * \brief The relative deadline, stretched if degraded.
+	 */
+	env_time_t deadline;
+
+	/**
+	 * \brief The worst case execution time of one release.
+	 */
+	env_time_t wcet;
+
+	/**
+	 * \brief The factor period and deadline were stretched by.
+	 */
+	int stretch;
+
+	/**
+	 * \brief The next admitted activity.
+	 */
+	struct tt_activity_t *next;
+} tt_activity_t;
+
+int tt_admit(tt_activity_t *, env_time_t, env_time_t, env_time_t, int);
+void tt_admit_remove(tt_activity_t *);
+int tt_admit_load(void);
+
+#endif /* TT_ADMIT */
+
+#endif
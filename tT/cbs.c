@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber constant bandwidth servers implementation.
+ *
+ * The kernel reports releases, completions and every switch of the
+ * processor between messages, the server of the running message is
+ * charged for the time between switches. Objects are mapped to servers
+ * through a fixed table found by open addressing on the object.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <cbs.h>
+#endif
+
+#if defined TT_CBS
+
+#if (TT_CBS_ENTRIES & (TT_CBS_ENTRIES - 1))
+#	error TT_CBS_ENTRIES must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+static struct
+{
+	tt_object_t *to;
+	tt_server_t *server;
+} cbs_table[TT_CBS_ENTRIES];
+static int cbs_count;
+static tt_server_t *cbs_running;
+static env_time_t cbs_since;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server init function.
+ *
+ * \note
+ *	Will call ENV_PANIC() when the budget or the period is zero, the
+ *	server could never be replenished.
+ *
+ * \param server The server.
+ * \param budget The budget per period, not zero.
+ * \param period The period, not zero.
+ */
+void tt_server_init(tt_server_t *server, env_time_t budget, env_time_t period)
+{
+	int protected = ENV_ISPROTECTED();
+
+	if (
+		ENV_TIME_LE(budget, ENV_USEC(0)) ||
+		ENV_TIME_LE(period, ENV_USEC(0))
+		) {
+		ENV_PANIC("tt_server_init(): Zero budget or period.\n");
+	}
+
+	ENV_PROTECT(1);
+
+	server->budget = budget;
+	server->period = period;
+	server->remaining = budget;
+	server->deadline = ENV_TIMER_GET();
+	server->pending = 0;
+	server->postponed = 0;
+
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server attach function.
+ *
+ * Should be called before the object receives any messages, typically
+ * from the startup function.
+ *
+ * \note
+ *	Will call ENV_PANIC() when there is no room for the object.
+ *
+ * \param server The server.
+ * \param to The object to serve.
+ */
+void tt_server_attach(tt_server_t *server, tt_object_t *to)
+{
+	int i, n;
+	int protected = ENV_ISPROTECTED();
+
+	ENV_PROTECT(1);
+
+	i = (int)(((size_t)to >> 4) & (TT_CBS_ENTRIES - 1));
+	for (n=0;n<TT_CBS_ENTRIES;n++) {
+		if (!cbs_table[i].to || cbs_table[i].to == to) {
+			break;
+		}
+		i = (i + 1) & (TT_CBS_ENTRIES - 1);
+	}
+	if (n == TT_CBS_ENTRIES) {
+		ENV_PANIC("tt_server_attach(): Out of entries.\n");
+	}
+	if (!cbs_table[i].to) {
+		cbs_table[i].to = to;
+		cbs_count++;
+	}
+	cbs_table[i].server = server;
+
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server lookup function.
+ *
+ * Must be called in protected mode.
+ *
+ * \param to The object.
+ * \return The server of the object, NULL if it has none.
+ */
+ENV_CODE_FAST tt_server_t *tt_cbs_server(tt_object_t *to)
+{
+	int i, n;
+
+	if (!cbs_count) {
+		return NULL;
+	}
+
+	i = (int)(((size_t)to >> 4) & (TT_CBS_ENTRIES - 1));
+	for (n=0;n<TT_CBS_ENTRIES && cbs_table[i].to;n++) {
+		if (cbs_table[i].to == to) {
+			return cbs_table[i].server;
+		}
+		i = (i + 1) & (TT_CBS_ENTRIES - 1);
+	}
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server release function.
+ *
+ * Called when a message to an object of the server is released. An idle
+ * server keeps its deadline and remaining budget only if they do not
+ * exceed its bandwidth, otherwise it gets a new deadline one period from
+ * now and a full budget (the CBS wake up rule). Must be called in
+ * protected mode.
+ *
+ * \param server The server.
+ * \param now The current time.
+ */
+ENV_CODE_FAST void tt_cbs_release(tt_server_t *server, env_time_t now)
+{
+	env_time_t zero = ENV_SEC(0);
+	long long remaining, left, budget, period;
+
+	if (!server->pending && cbs_running != server) {
+		/* Scaled down, the products must not overflow. */
+		remaining = ENV_TIME_DIFF(server->remaining, zero) >> 10;
+		left = ENV_TIME_DIFF(server->deadline, now) >> 10;
+		budget = ENV_TIME_DIFF(server->budget, zero) >> 10;
+		period = ENV_TIME_DIFF(server->period, zero) >> 10;
+
+		if (left <= 0 || remaining*period > left*budget) {
+			server->deadline = ENV_TIME_ADD(now, server->period);
+			server->remaining = server->budget;
+		}
+	}
+	server->pending++;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server done function.
+ *
+ * Called when a message released through the server completes or is
+ * dropped. Must be called in protected mode.
+ *
+ * \param server The server.
+ */
+ENV_CODE_FAST void tt_cbs_done(tt_server_t *server)
+{
+	if (server->pending) {
+		server->pending--;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server charge function.
+ *
+ * Charges the running server for the time since it started running. On
+ * exhaustion the deadline of the server is postponed one period and the
+ * budget recharged, as many times as the time used takes, an overrun is
+ * charged to the next budgets. Must be called in protected mode.
+ *
+ * \param now The current time.
+ * \param keep Non-zero if the server keeps running.
+ * \return The server if its deadline was postponed, otherwise NULL.
+ */
+ENV_CODE_FAST tt_server_t *tt_cbs_charge(env_time_t now, int keep)
+{
+	env_time_t used;
+	tt_server_t *server = cbs_running;
+
+	if (!server) {
+		return NULL;
+	}
+
+	if (ENV_TIME_LT(now, cbs_since)) {
+		now = cbs_since;
+	}
+	used = ENV_TIME_SUB(now, cbs_since);
+
+	if (keep) {
+		cbs_since = now;
+	} else {
+		cbs_running = NULL;
+	}
+
+	if (ENV_TIME_LT(used, server->remaining)) {
+		server->remaining = ENV_TIME_SUB(server->remaining, used);
+		return NULL;
+	}
+
+	do {
+		used = ENV_TIME_SUB(used, server->remaining);
+		server->deadline = ENV_TIME_ADD(server->deadline, server->period);
+		server->remaining = server->budget;
+		server->postponed++;
+	} while (!ENV_TIME_LT(used, server->remaining));
+	server->remaining = ENV_TIME_SUB(server->remaining, used);
+
+	return server;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server start function.
+ *
+ * Called when the processor switches to a message, the previously
+ * running server must have been charged. Must be called in protected
+ * mode.
+ *
+ * \param server The server of the message, NULL for none.
+ * \param now The current time.
+ */
+ENV_CODE_FAST void tt_cbs_start(tt_server_t *server, env_time_t now)
+{
+	cbs_running = server;
+	cbs_since = now;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server exhaustion function.
+ *
+ * Must be called in protected mode.
+ *
+ * \param when Set to the time the budget of the running server runs out.
+ * \return Non-zero if a server is running.
+ */
+ENV_CODE_FAST int tt_cbs_exhaustion(env_time_t *when)
+{
+	if (!cbs_running) {
+		return 0;
+	}
+	*when = ENV_TIME_ADD(cbs_since, cbs_running->remaining);
+	return 1;
+}
+
+#endif /* TT_CBS */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber constant bandwidth servers.
+ *
+ * Compiled in when TT_CBS is defined (make CBS=yes). A server reserves a
+ * budget of processor time every period for a group of objects. Messages
+ * to the objects of a server are released with the deadline of the
+ * server instead of their own, and the processor time they use is
+ * charged to the budget. When the budget is exhausted the server deadline
+ * is postponed one period and the budget recharged, moving every message
+ * of the group behind more urgent work. A group that misbehaves can thus
+ * never take more than its bandwidth from the other objects.
+ *
+ * Only available for the regular kernel.
+ */
+
+#ifndef CBS_H_
+#define CBS_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_CBS
+
+#if defined TT_TIMBER || defined TT_SRP
+#	error TT_CBS is only supported with the regular kernel.
+#endif
+
+#ifndef ENV_TIME_SUB
+#	error TT_CBS requires ENV_TIME_SUB() from the environment.
+#endif
+
+#ifndef TT_CBS_ENTRIES
+	/**
+	 * \brief The number of objects that can be attached to servers, a
+	 * power of two.
+	 */
+#	define TT_CBS_ENTRIES 16
+#endif
+
+/**
+ * \brief TinyTimber constant bandwidth server.
+ */
+typedef struct tt_server_t
+{
+	/**
+	 * \brief The budget per period.
+	 */
+	env_time_t budget;
+
+	/**
+	 * \brief The period.
+	 */
+	env_time_t period;
+
+	/**
+	 * \brief The remaining budget.
+	 */
+	env_time_t remaining;
+
+	/**
+	 * \brief The server deadline.
+	 */
+	env_time_t deadline;
+
+	/**
+	 * \brief The number of released messages not yet completed.
+	 */
+	int pending;
+
+	/**
+	 * \brief The number of times the deadline was postponed.
+	 */
+	unsigned long postponed;
+} tt_server_t;
+
+void tt_server_init(tt_server_t *, env_time_t, env_time_t);
+void tt_server_attach(tt_server_t *, tt_object_t *);
+tt_server_t *tt_cbs_server(tt_object_t *);
+void tt_cbs_release(tt_server_t *, env_time_t);
+void tt_cbs_done(tt_server_t *);
+void tt_cbs_start(tt_server_t *, env_time_t);
+tt_server_t *tt_cbs_charge(env_time_t, int);
+int tt_cbs_exhaustion(env_time_t *);
+
+#endif /* TT_CBS */
+
+#endif
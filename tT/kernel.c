@@ -61,6 +61,13 @@
  * TinyTimber specific headers.
  */
 #	include <kernel.h>
+#	include <trace.h>
+#	include <probe.h>
+#	include <stats.h>
+#	include <miss.h>
+#	include <shed.h>
+#	include <cbs.h>
+#	include <sporadic.h>
 #endif
 
 /*
@@ -78,7 +85,9 @@
  * Used to get a baseline/deadline for interrupts.
  */
 
+#if ! defined TT_MESSAGE_SPLIT
 static tt_message_t msg0;
+#endif
 
 /* ************************************************************************** */
 
@@ -101,12 +110,49 @@ char tt_args_none = 42;
  */
 #if ! defined TT_TIMBER
 
+/*
+ * The magazines may hold up to a full magazine per thread, idle included.
+ * The pool is that much larger so that the free list still holds the
+ * TT_NUM_MESSAGES of the application, interrupt handlers only use the free
+ * list.
+ */
+#if defined TT_MAGAZINE
+#	define NUM_MESSAGES \
+	(TT_NUM_MESSAGES + (ENV_NUM_THREADS + 1)*TT_MAGAZINE_SIZE)
+#else
+#	define NUM_MESSAGES TT_NUM_MESSAGES
+#endif
+
+#if defined TT_MESSAGE_INDEX
+
+#if NUM_MESSAGES > 65535
+#	error TT_MESSAGE_INDEX supports at most 65535 messages.
+#endif
+
+/**
+ * \brief TinyTimber message index type, the position in the pool plus one.
+ */
+#if NUM_MESSAGES < 255
+typedef unsigned char tt_message_index_t;
+#else
+typedef unsigned short tt_message_index_t;
+#endif
+
+#endif /* TT_MESSAGE_INDEX */
+
 /**
  * \brief TinyTimber message structure type.
  */
 struct tt_message_t
 {
+	/**
+	 * \brief The next message in the list.
+	 */
+#if defined TT_MESSAGE_INDEX
+	tt_message_index_t next;
+#else
 	tt_message_t *next;
+#endif
 
 	/**
 	 * \brief Baseline of message.
@@ -118,6 +164,19 @@ struct tt_message_t
 	 */
 	env_time_t deadline;
 
+#if defined TT_MESSAGE_SPLIT
+};
+
+/**
+ * \brief TinyTimber message body structure type.
+ *
+ * The payload of a message, kept apart from the keys the queues are sorted
+ * by so that a queue walk only touches the keys and links.
+ */
+typedef struct tt_message_body_t
+{
+#endif
+
 	/**
 	 * \brief The object to perform the call upon.
 	 */
@@ -138,6 +197,21 @@ struct tt_message_t
 	 */
 	tt_flags_t flags;
 
+#if defined TT_SHED
+	/**
+	 * \brief The deadline the message was posted with, kept for the
+	 * statistics and miss detection once it has been demoted.
+	 */
+	env_time_t due;
+#endif
+
+#if defined TT_STATS && defined ENV_CPU_GET
+	/**
+	 * \brief The processor time at dispatch.
+	 */
+	long cpu;
+#endif
+
 	/**
 	 * \brief TinyTimber argument buffer.
 	 */
@@ -156,7 +230,11 @@ struct tt_message_t
 		/** \endcond */
 #endif /* __STDC_VERSION && __STDC_VERSION >= 19991L */
 	} arg;
+#if defined TT_MESSAGE_SPLIT
+} tt_message_body_t;
+#else
 };
+#endif
 
 /* ************************************************************************** */
 
@@ -264,11 +342,28 @@ static struct
 #ifdef ENV_PIC18
 #	pragma idata message_pool
 #endif
-static tt_message_t message_pool[TT_NUM_MESSAGES];
+#if defined TT_MESSAGE_SPLIT
+static tt_message_t message_pool[NUM_MESSAGES + 1];
+#else
+static tt_message_t message_pool[NUM_MESSAGES];
+#endif
 #ifdef ENV_PIC18
 #	pragma idata
 #endif
 
+#if defined TT_MESSAGE_SPLIT
+/**
+ * \brief TinyTimber message body pool, in the order of the message pool.
+ */
+static tt_message_body_t message_body[NUM_MESSAGES + 1];
+
+/*
+ * The message of interrupts needs a body as well, it is the extra one at the
+ * end of the pools that never goes into the free list.
+ */
+#	define msg0 message_pool[NUM_MESSAGES]
+#endif
+
 /* ************************************************************************** */
 
 /**
@@ -290,6 +385,14 @@ static struct
 	 * \brief List of free messages.
 	 */
 	tt_message_t *free;
+
+#if defined TT_SHED
+	/**
+	 * \brief The deadline of the last message queued at the end of the
+	 * active list, no active message has a later one.
+	 */
+	env_time_t latest;
+#endif
 } messages;
 
 /* ************************************************************************** */
@@ -301,6 +404,40 @@ static struct
 
 /* ************************************************************************** */
 
+/**
+ * \brief TinyTimber helper macro to access the body of a message.
+ */
+#define BODY(msg) TT_MESSAGE_BODY(msg)
+
+/* ************************************************************************** */
+
+#if defined TT_MESSAGE_INDEX
+/**
+ * \brief TinyTimber helper macro for the next message in a list.
+ */
+#	define MESSAGE_NEXT(msg) \
+	((msg)->next ? &message_pool[(msg)->next - 1] : NULL)
+
+/**
+ * \brief TinyTimber helper macro to link a message to the next one.
+ */
+#	define MESSAGE_LINK(msg, to) \
+	((msg)->next = (to) ? (tt_message_index_t)((to) - message_pool + 1) : 0)
+#else
+#	define MESSAGE_NEXT(msg) ((msg)->next)
+#	define MESSAGE_LINK(msg, to) ((msg)->next = (to))
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber helper macro for the trace id of a thread.
+ */
+#define THREAD_ID(thread) \
+	((thread) == threads.idle ? 0 : (int)((thread) - thread_pool) + 1)
+
+/* ************************************************************************** */
+
 /**
  * \brief TinyTimber dequeue/pop macro.
  */
@@ -323,6 +460,75 @@ do {\
 
 /* ************************************************************************** */
 
+/**
+ * \brief TinyTimber message dequeue/pop macro.
+ */
+#define MESSAGE_DEQUEUE(list, item) \
+do {\
+	item = list;\
+	list = MESSAGE_NEXT(list);\
+} while (0)
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber message enqueue/push macro.
+ */
+#define MESSAGE_ENQUEUE(list, item) \
+do {\
+	MESSAGE_LINK(item, list);\
+	list = item;\
+} while (0)
+
+#if defined TT_MAGAZINE
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber magazine refill function.
+ *
+ * Moves up to half a magazine of messages from the free list into the
+ * magazine of the thread. Must be called in protected mode.
+ *
+ * \param thread The thread.
+ */
+static ENV_CODE_FAST void magazine_refill(tt_thread_t *thread)
+{
+	tt_message_t *msg;
+
+	while (messages.free && thread->magazine_count < TT_MAGAZINE_SIZE/2) {
+		MESSAGE_DEQUEUE(messages.free, msg);
+		MESSAGE_ENQUEUE(thread->magazine, msg);
+		thread->magazine_count++;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber magazine flush function.
+ *
+ * Moves the messages above the given number back to the free list. Must be
+ * called in protected mode.
+ *
+ * \param thread The thread.
+ * \param keep The number of messages to keep in the magazine.
+ */
+static ENV_CODE_FAST void magazine_flush(tt_thread_t *thread, int keep)
+{
+	tt_message_t *msg;
+
+	while (thread->magazine_count > keep) {
+		MESSAGE_DEQUEUE(thread->magazine, msg);
+		MESSAGE_ENQUEUE(messages.free, msg);
+		thread->magazine_count--;
+	}
+}
+
+#endif /* TT_MAGAZINE */
+
+/* ************************************************************************** */
+
 /**
  * \brief TinyTimber enqueue by deadline function.
  *
@@ -341,16 +547,23 @@ static ENV_CODE_FAST ENV_INLINE void enqueue_by_deadline(
 	while (tmp && ENV_TIME_LE(tmp->deadline, msg->deadline)) {
 		/* Next item in the list. */
 		prev = tmp;
-		tmp = tmp->next;
+		tmp = MESSAGE_NEXT(tmp);
 	}
 
 	/* Insert the message into the list, check for head etc. */
-	msg->next = tmp;
+	MESSAGE_LINK(msg, tmp);
 	if (prev) {
-		prev->next = msg;
+		MESSAGE_LINK(prev, msg);
 	} else {
 		*list = msg;
 	}
+
+#if defined TT_SHED
+	/* Only the active list is sorted by deadline. */
+	if (!tmp) {
+		messages.latest = msg->deadline;
+	}
+#endif
 }
 
 /* ************************************************************************** */
@@ -373,13 +586,13 @@ static ENV_CODE_FAST ENV_INLINE void enqueue_by_baseline(
 	while (tmp && ENV_TIME_LE(tmp->baseline, msg->baseline)) {
 		/* Next item in the list. */
 		prev = tmp;
-		tmp = tmp->next;
+		tmp = MESSAGE_NEXT(tmp);
 	}
 
 	/* Insert the message into the list, check for head etc. */
-	msg ->next = tmp;
+	MESSAGE_LINK(msg, tmp);
 	if (prev) {
-		prev->next = msg;
+		MESSAGE_LINK(prev, msg);
 	} else {
 		*list = msg;
 	}
@@ -387,6 +600,293 @@ static ENV_CODE_FAST ENV_INLINE void enqueue_by_baseline(
 
 /* ************************************************************************** */
 
+#if defined TT_CBS
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server postpone function.
+ *
+ * Gives the running message and every active message of the server the
+ * postponed server deadline, keeping the active list sorted.
+ *
+ * \param server The server that was postponed.
+ */
+static ENV_CODE_FAST void cbs_postpone(tt_server_t *server)
+{
+	tt_message_t *tmp, *next, *moved = NULL, *prev = NULL;
+
+	tmp = CURRENT()->msg;
+	if (
+		tmp &&
+		(BODY(tmp)->flags & TT_FLAG_SERVED) &&
+		tt_cbs_server(BODY(tmp)->to) == server
+		) {
+		tmp->deadline = server->deadline;
+	}
+
+	for (tmp = messages.active;tmp;tmp = next) {
+		next = MESSAGE_NEXT(tmp);
+		if (
+			(BODY(tmp)->flags & TT_FLAG_SERVED) &&
+			tt_cbs_server(BODY(tmp)->to) == server
+			) {
+			if (prev) {
+				MESSAGE_LINK(prev, next);
+			} else {
+				messages.active = next;
+			}
+			MESSAGE_ENQUEUE(moved, tmp);
+		} else {
+			prev = tmp;
+		}
+	}
+
+	while (moved) {
+		MESSAGE_DEQUEUE(moved, tmp);
+		tmp->deadline = server->deadline;
+		enqueue_by_deadline(&messages.active, tmp);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server timer function.
+ *
+ * Makes sure the timer expires no later than when the budget of the
+ * running server runs out.
+ */
+static ENV_CODE_FAST void cbs_timer(void)
+{
+	env_time_t when;
+
+	if (!tt_cbs_exhaustion(&when)) {
+		return;
+	}
+	if (messages.inactive && ENV_TIME_LT(messages.inactive->baseline, when)) {
+		when = messages.inactive->baseline;
+	}
+	ENV_TIMER_SET(when);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server switch function.
+ *
+ * Called whenever the processor is about to switch to another message,
+ * charges the server of the previous message and starts the server of
+ * the next.
+ *
+ * \param msg The next message, NULL if none (idle or a new thread).
+ */
+static ENV_CODE_FAST void cbs_switch(tt_message_t *msg)
+{
+	tt_server_t *server = NULL;
+	env_time_t now = ENV_TIMER_GET();
+
+	server = tt_cbs_charge(now, 0);
+	if (server) {
+		cbs_postpone(server);
+	}
+
+	server = NULL;
+	if (msg && (BODY(msg)->flags & TT_FLAG_SERVED)) {
+		server = tt_cbs_server(BODY(msg)->to);
+	}
+	tt_cbs_start(server, now);
+	if (server) {
+		cbs_timer();
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server expired function.
+ *
+ * Charges the running server on every timer interrupt, postponing it if
+ * its budget ran out.
+ *
+ * \param now The time of the interrupt.
+ */
+static ENV_CODE_FAST void cbs_expired(env_time_t now)
+{
+	tt_server_t *server = tt_cbs_charge(now, 1);
+
+	if (server) {
+		cbs_postpone(server);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server release function.
+ *
+ * Gives a message to an object with a server the deadline of the server.
+ *
+ * \param msg The message being released.
+ * \param now The current time.
+ */
+static ENV_CODE_FAST void cbs_release(tt_message_t *msg, env_time_t now)
+{
+	tt_server_t *server = tt_cbs_server(BODY(msg)->to);
+
+	if (server) {
+		tt_cbs_release(server, now);
+		msg->deadline = server->deadline;
+		BODY(msg)->flags |= TT_FLAG_SERVED;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber server done function.
+ *
+ * \param msg The message that completed or was dropped.
+ */
+static ENV_CODE_FAST void cbs_done(tt_message_t *msg)
+{
+	if (BODY(msg)->flags & TT_FLAG_SERVED) {
+		tt_cbs_done(tt_cbs_server(BODY(msg)->to));
+		BODY(msg)->flags &= ~TT_FLAG_SERVED;
+	}
+}
+
+#else
+
+/** \cond */
+#	define cbs_timer()
+#	define cbs_switch(msg)
+#	define cbs_expired(now)
+#	define cbs_release(msg, now)
+#	define cbs_done(msg)
+/** \endcond */
+
+#endif /* TT_CBS */
+
+/* ************************************************************************** */
+
+#if defined TT_SHED
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shed function.
+ *
+ * Applies the shedding policy of the object at the head of the active
+ * list until the head should be dispatched or the list is empty. Dropped
+ * messages are freed as if canceled, demoted messages are queued behind
+ * all active messages and are never shed again. Their own deadline is
+ * kept in due for the accounting.
+ */
+static ENV_CODE_FAST void shed_active(void)
+{
+	int superseded;
+	env_time_t now;
+	tt_shed_t *entry;
+	tt_message_t *tmp, *last;
+
+	while (messages.active) {
+		tmp = messages.active;
+		if (BODY(tmp)->flags & TT_FLAG_DEMOTED) {
+			return;
+		}
+		entry = tt_shed_find(BODY(tmp)->to);
+		if (!entry) {
+			return;
+		}
+
+		/* Look for a newer message to the same method. */
+		superseded = 0;
+		if (entry->policy & TT_SHED_LATEST) {
+			for (last = MESSAGE_NEXT(tmp);last && !superseded;last = MESSAGE_NEXT(last)) {
+				superseded =
+					BODY(last)->to == BODY(tmp)->to && BODY(last)->method == BODY(tmp)->method;
+			}
+		}
+
+		now = ENV_TIMER_GET();
+		switch (tt_shed_action(entry, tmp->deadline, now, superseded)) {
+			case TT_SHED_DROP:
+				MESSAGE_DEQUEUE(messages.active, tmp);
+				if (BODY(tmp)->receipt) {
+					BODY(tmp)->receipt->msg = NULL;
+				}
+				TT_TRACE_EVENT(TT_TRACE_CANCEL, THREAD_ID(CURRENT()), tmp, BODY(tmp)->to, BODY(tmp)->method);
+				cbs_done(tmp);
+				MESSAGE_ENQUEUE(messages.free, tmp);
+				break;
+
+			case TT_SHED_DEMOTED:
+				MESSAGE_DEQUEUE(messages.active, tmp);
+				BODY(tmp)->due = tmp->deadline;
+				if (messages.active) {
+					tmp->deadline = messages.latest;
+				}
+				BODY(tmp)->flags |= TT_FLAG_DEMOTED;
+				enqueue_by_deadline(&messages.active, tmp);
+				break;
+
+			default:
+				return;
+		}
+	}
+}
+
+#else
+
+/** \cond */
+#	define shed_active()
+/** \endcond */
+
+#endif /* TT_SHED */
+
+/* ************************************************************************** */
+
+#if defined TT_STATS && defined ENV_CPU_GET
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber execution time start function.
+ *
+ * Each message runs on a thread of its own, the processor time of the
+ * thread does not advance while it is preempted.
+ *
+ * \param msg The message about to run.
+ */
+static ENV_CODE_FAST void stats_begin(tt_message_t *msg)
+{
+	BODY(msg)->cpu = ENV_CPU_GET();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber execution time stop function.
+ *
+ * \param msg The message that completed.
+ */
+static ENV_CODE_FAST void stats_end(tt_message_t *msg)
+{
+	tt_stats_execution(BODY(msg)->to, BODY(msg)->method, ENV_CPU_GET() - BODY(msg)->cpu);
+}
+
+#else
+
+/** \cond */
+#	define stats_begin(msg)
+#	define stats_end(msg)
+/** \endcond */
+
+#endif /* TT_STATS && ENV_CPU_GET */
+
+/* ************************************************************************** */
+
 /**
  * \brief TinyTimber run thread function.
  *
@@ -414,37 +914,72 @@ static ENV_CODE_FAST void tt_thread_run(void)
 		 * messages.active should always be the correct message to run,
 		 * also cancel any receipt.
 		 */
-		DEQUEUE(messages.active, this);
+		MESSAGE_DEQUEUE(messages.active, this);
 
 #if ! defined TT_TIMBER
 		/*
 		 * We use a different method of canceling the messages/receipts
 		 * when we run against the "real" Timber language.
 		 */
-		if (this->receipt) {
-			this->receipt->msg = NULL;
+		if (BODY(this)->receipt) {
+			BODY(this)->receipt->msg = NULL;
 		}
 #endif
 
 		CURRENT()->msg = this;
 
-		TT_SANITY(this->to);
-		TT_SANITY(this->method);
+		TT_SANITY(BODY(this)->to);
+		TT_SANITY(BODY(this)->method);
+
+		TT_TRACE_EVENT(
+				TT_TRACE_DISPATCH,
+				THREAD_ID(CURRENT()),
+				this,
+				BODY(this)->to,
+				BODY(this)->method
+				);
+		TT_PROBE(dispatch, this, BODY(this)->to, BODY(this)->method);
+		TT_STATS_DISPATCH(this);
+		cbs_switch(this);
+		stats_begin(this);
 
 		ENV_PROTECT(0);
-		/*tt_request(this->to, this->method, &this->arg);*/
+		/*tt_request(BODY(this)->to, BODY(this)->method, &BODY(this)->arg);*/
 		TT_MESSAGE_RUN(this);
 		ENV_PROTECT(1);
 
+		TT_TRACE_EVENT(
+				TT_TRACE_COMPLETE,
+				THREAD_ID(CURRENT()),
+				this,
+				BODY(this)->to,
+				BODY(this)->method
+				);
+		TT_PROBE(complete, this, BODY(this)->to, BODY(this)->method);
+		stats_end(this);
+		TT_STATS_COMPLETE(this);
+		TT_MISS_COMPLETE(this);
+		cbs_switch(NULL);
+		cbs_done(this);
+
 		TT_SANITY(threads.active == CURRENT());
 		TT_SANITY(this == CURRENT()->msg);
 
-#if ! defined TT_TIMBER
+#if defined TT_MAGAZINE
+		/*
+		 * The message goes into the magazine of this thread, only
+		 * a full magazine touches the free list.
+		 */
+		MESSAGE_ENQUEUE(CURRENT()->magazine, this);
+		if (++CURRENT()->magazine_count > TT_MAGAZINE_SIZE) {
+			magazine_flush(CURRENT(), TT_MAGAZINE_SIZE/2);
+		}
+#elif ! defined TT_TIMBER
 		/*
 		 * Again, when we run against the "real" Timber language
 		 * we will be using GC to collect the messages.
 		 */
-		ENQUEUE(messages.free, this);
+		MESSAGE_ENQUEUE(messages.free, this);
 #endif
 
 		/*
@@ -454,6 +989,9 @@ static ENV_CODE_FAST void tt_thread_run(void)
 		 * we will run it unconditionally.
 		 */
 
+		/* Shed what can not be run usefully before picking the next. */
+		shed_active();
+
 		/* 
 		 * If there are no more active messages we yeild, in the future
 		 * we might sleep/idle instead but that requires some changes
@@ -499,6 +1037,8 @@ yield:
 		 * the idle thread.
 		 */
 
+		TT_TRACE_EVENT(TT_TRACE_YIELD, THREAD_ID(CURRENT()), NULL, NULL, NULL);
+
 		/* 
 		 * This thread should no longer be active, place it in the
 		 * inactive list for re-use.
@@ -506,6 +1046,11 @@ yield:
 		DEQUEUE(threads.active, tmp);
 		ENQUEUE(threads.inactive, tmp);
 
+#if defined TT_MAGAZINE
+		/* A thread put back for re-use returns its messages. */
+		magazine_flush(tmp, 0);
+#endif
+
 		/*
 		 * If there are not pre-empted threads we must dispatch the
 		 * idle thread, if there are pre-empted threads then run the
@@ -523,6 +1068,7 @@ yield:
 				tmp = tmp->waits_for->owned_by;
 			}
 			TT_SANITY(tmp);
+			cbs_switch(tmp->msg);
 			ENV_CONTEXT_DISPATCH(tmp);
 			TT_SANITY(ENV_ISPROTECTED());
 		} else {
@@ -573,11 +1119,15 @@ void tt_init(void)
 	messages.active = NULL;
 	messages.inactive = NULL;
 	memset(message_pool, 0, sizeof(message_pool));
+#if defined TT_MESSAGE_SPLIT
+	memset(message_body, 0, sizeof(message_body));
+#endif
 	messages.free = message_pool;
-	for (i=0;i<TT_NUM_MESSAGES;i++) {
-		message_pool[i].next = &message_pool[i+1];
+	for (i=0;i<NUM_MESSAGES-1;i++) {
+		MESSAGE_LINK(&message_pool[i], &message_pool[i+1]);
 	}
-	message_pool[TT_NUM_MESSAGES-1].next = NULL;
+	/* NULL, or no index. */
+	message_pool[NUM_MESSAGES-1].next = 0;
 #endif
 
 	/* 
@@ -657,6 +1207,7 @@ ENV_CODE_FAST void tt_schedule(void)
 	 * shouldn't call this unless there are messages that need scheduling
 	 * but better safe than sorry.
 	 */
+	shed_active();
 	if (!messages.active) {
 		return;
 	}
@@ -700,6 +1251,25 @@ schedule_new:
 	DEQUEUE(threads.inactive, tmp);
 	ENQUEUE(threads.active, tmp);
 
+	TT_TRACE_EVENT(
+			TT_TRACE_SCHEDULE,
+			THREAD_ID(tmp),
+			messages.active,
+			BODY(messages.active)->to,
+			BODY(messages.active)->method
+			);
+	if (tmp->next) {
+		TT_PROBE(
+				preempt,
+				messages.active,
+				BODY(messages.active)->to,
+				BODY(messages.active)->method
+				);
+	}
+
+	/* The new thread accounts the message it picks itself. */
+	cbs_switch(NULL);
+
 #if defined ENV_CONTEXT_NOT_SAVED
 	ENV_CONTEXT_DISPATCH(tmp);
 	TT_SANITY(ENV_ISPROTECTED());
@@ -724,6 +1294,9 @@ void ENV_CODE_FAST tt_expired(env_time_t now)
 
 	TT_SANITY(ENV_ISPROTECTED());
 
+	/* Charge the running server, its budget may be what expired. */
+	cbs_expired(now);
+
 	/*
 	 * Push all the inactive messages that became active onto the
 	 * active list.
@@ -732,8 +1305,18 @@ void ENV_CODE_FAST tt_expired(env_time_t now)
 		messages.inactive &&
 		ENV_TIME_LE(messages.inactive->baseline, now)
 		) {
-		DEQUEUE(messages.inactive, tmp);
+		MESSAGE_DEQUEUE(messages.inactive, tmp);
+		cbs_release(tmp, now);
 		enqueue_by_deadline(&messages.active, tmp);
+		TT_TRACE_EVENT(
+				TT_TRACE_RELEASE,
+				THREAD_ID(CURRENT()),
+				tmp,
+				BODY(tmp)->to,
+				BODY(tmp)->method
+				);
+		TT_PROBE(release, tmp, BODY(tmp)->to, BODY(tmp)->method);
+		TT_MISS_RELEASE(tmp, now);
 	}
 
 	/*
@@ -743,6 +1326,7 @@ void ENV_CODE_FAST tt_expired(env_time_t now)
 	if (messages.inactive) {
 		ENV_TIMER_SET(messages.inactive->baseline);
 	}
+	cbs_timer();
 }
 
 /* ************************************************************************** */
@@ -805,6 +1389,14 @@ ENV_CODE_FAST tt_object_t *tt_lock(tt_object_t *object)
 		object->wanted_by = CURRENT();
 		CURRENT()->waits_for = object;
 
+		TT_TRACE_EVENT(
+				TT_TRACE_BLOCK,
+				THREAD_ID(CURRENT()),
+				CURRENT()->msg,
+				object,
+				NULL
+				);
+
 		/*
 		 * Allow the first unblocked thread to run until our object is
 		 * released. Note that this does not mean that the first
@@ -812,6 +1404,7 @@ ENV_CODE_FAST tt_object_t *tt_lock(tt_object_t *object)
 		 * only that if we run it our object will eventually be
 		 * released.
 		 */
+		cbs_switch(tmp->msg);
 		ENV_CONTEXT_DISPATCH(tmp);
 		TT_SANITY(ENV_ISPROTECTED());
 
@@ -879,6 +1472,7 @@ ENV_CODE_FAST void tt_unlock(tt_object_t *object)
 	if (tmp) {
 		object->wanted_by = NULL;
 		tmp->waits_for = NULL;
+		cbs_switch(tmp->msg);
 		ENV_CONTEXT_DISPATCH(tmp);
 		TT_SANITY(ENV_ISPROTECTED());
 	}
@@ -952,12 +1546,20 @@ ENV_CODE_FAST void tt_async(
 #endif
 {
 	int protected = ENV_ISPROTECTED();
-	env_time_t now = ENV_TIMER_GET();
-	env_time_t base = CURRENT()->msg->baseline;
-	env_time_t dead = CURRENT()->msg->deadline;
+	env_time_t now, base, dead;
 
 	TT_SANITY(msg);
 
+	/*
+	 * The running message is only read protected, the constant bandwidth
+	 * server postpones its deadline from interrupt context.
+	 */
+	ENV_PROTECT(1);
+
+	now = ENV_TIMER_GET();
+	base = CURRENT()->msg->baseline;
+	dead = CURRENT()->msg->deadline;
+
 	/*
 	 * First check baseline if it's inherited or not.
 	 */
@@ -983,18 +1585,71 @@ ENV_CODE_FAST void tt_async(
 		msg->deadline= ENV_TIME_ADD(msg->baseline, dl);
 	}
 
-	ENV_PROTECT(1);
+	/*
+	 * The receipt is only published now, tt_cancel() must not find it
+	 * before the message is in one of the queues.
+	 */
+	if (BODY(msg)->receipt) {
+		BODY(msg)->receipt->msg = msg;
+	}
+
+#if ! defined TT_TIMBER
+	TT_TRACE_EVENT(
+			TT_TRACE_ACTION,
+			THREAD_ID(CURRENT()),
+			msg,
+			BODY(msg)->to,
+			BODY(msg)->method
+			);
+	TT_PROBE(post, msg, BODY(msg)->to, BODY(msg)->method);
+#endif
+
+	TT_TRACE_EVENT(
+			TT_TRACE_ASYNC,
+			THREAD_ID(CURRENT()),
+			msg,
+			BODY(msg)->to,
+			BODY(msg)->method
+			);
+
+#if defined TT_SPORADIC
+	/*
+	 * An interrupt source with a sporadic server may only post its share,
+	 * the excess is moved to a later period or dropped.
+	 */
+	if (
+		protected &&
+		tt_sporadic_current &&
+		!tt_sporadic_admit(
+			tt_sporadic_current,
+			now,
+			&msg->baseline,
+			&msg->deadline
+			)
+		) {
+		if (BODY(msg)->receipt) {
+			BODY(msg)->receipt->msg = NULL;
+		}
+		MESSAGE_ENQUEUE(messages.free, msg);
+		ENV_PROTECT(protected);
+		return;
+	}
+#endif
 
 	/*
 	 * If baseline expired already then we should place the message in
 	 * the active list, otherwise the inactive list.
 	 */
 	if (ENV_TIME_LE(msg->baseline, now)) {
+		cbs_release(msg, now);
 		enqueue_by_deadline(&messages.active, msg);
+		TT_PROBE(release, msg, BODY(msg)->to, BODY(msg)->method);
+		TT_MISS_RELEASE(msg, now);
 	} else {
 		enqueue_by_baseline(&messages.inactive, msg);
 		if (messages.inactive == msg) {
 			ENV_TIMER_SET(msg->baseline);
+			cbs_timer();
 		}
 	}
 
@@ -1055,27 +1710,54 @@ ENV_CODE_FAST void tt_action(
 	TT_SANITY(size);
 	TT_SANITY(size <= TT_ARGS_SIZE);
 
-	ENV_PROTECT(1);
+#if defined TT_MAGAZINE
+	/*
+	 * A thread takes the message from its own magazine, unprotected,
+	 * nothing but the thread itself touches it. Interrupt handlers run
+	 * protected on whatever thread they interrupt and always use the free
+	 * list, as does a thread whose magazine ran empty, refilling it in
+	 * passing.
+	 */
+	if (!protected && CURRENT()->magazine) {
+		MESSAGE_DEQUEUE(CURRENT()->magazine, msg);
+		CURRENT()->magazine_count--;
+	} else
+#endif
+	{
+		ENV_PROTECT(1);
 
-	/* This is _VERY_ important, this can and will f*ck up. */
-	if (!messages.free) {
-		ENV_PANIC("tt_action(): Out of messages.\n");
-	}
+		/* This is _VERY_ important, this can and will f*ck up. */
+		if (!messages.free) {
+			ENV_PANIC("tt_action(): Out of messages.\n");
+		}
 
-	DEQUEUE(messages.free, msg);
-	msg->receipt = receipt;
-	if (receipt) {
-		receipt->msg = msg;
+		MESSAGE_DEQUEUE(messages.free, msg);
+#if defined TT_MAGAZINE
+		if (!protected) {
+			magazine_refill(CURRENT());
+		}
+#endif
 	}
 
+	/*
+	 * The message is ours until it is queued, its body is set up
+	 * unprotected when we were called unprotected. tt_async() computes
+	 * the baseline and deadline and publishes the receipt once
+	 * protected.
+	 */
+	ENV_PROTECT(protected);
+
+	BODY(msg)->flags = 0;
+	BODY(msg)->receipt = receipt;
+
 	/* Only copy the arguments if there are any none. */
 	if (arg != &tt_args_none) {
-		memcpy(&msg->arg, arg, size);
+		memcpy(&BODY(msg)->arg, arg, size);
 	}
 
 	/* To and method should always be present of course. */
-	msg->to = to;
-	msg->method = method;
+	BODY(msg)->to = to;
+	BODY(msg)->method = method;
 
 	/*
 	 * The base (used to calculate the baseline of the message) is
@@ -1097,8 +1779,38 @@ ENV_CODE_FAST void tt_action(
 	if (old_msg) {
 		CURRENT()->msg = old_msg;
 	}
+}
 
-	ENV_PROTECT(protected);
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber baseline function.
+ *
+ * \return The baseline of the running message, or the time of the
+ * interrupt when called from an interrupt handler.
+ */
+ENV_CODE_FAST env_time_t tt_baseline(void)
+{
+	if (ENV_ISPROTECTED()) {
+		return ENV_TIMESTAMP();
+	}
+	return CURRENT()->msg->baseline;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline function.
+ *
+ * \return The deadline of the running message, or the time of the
+ * interrupt when called from an interrupt handler.
+ */
+ENV_CODE_FAST env_time_t tt_deadline(void)
+{
+	if (ENV_ISPROTECTED()) {
+		return ENV_TIMESTAMP();
+	}
+	return CURRENT()->msg->deadline;
 }
 
 #endif /* TT_TIMBER */
@@ -1137,14 +1849,14 @@ ENV_CODE_FAST int tt_cancel(tt_receipt_t *receipt)
 		tmp = messages.inactive;
 		while (tmp && tmp != receipt->msg) {
 			prev = tmp;
-			tmp = tmp->next;
+			tmp = MESSAGE_NEXT(tmp);
 		}
 
 		if (!tmp) {
 			tmp = messages.active;
 			while (tmp && tmp != receipt->msg) {
 				prev = tmp;
-				tmp = tmp->next;
+				tmp = MESSAGE_NEXT(tmp);
 			}
 
 			if (!tmp) {
@@ -1158,27 +1870,37 @@ ENV_CODE_FAST int tt_cancel(tt_receipt_t *receipt)
 		 */
 
 		if (prev) {
-			prev->next = tmp->next;
+			MESSAGE_LINK(prev, MESSAGE_NEXT(tmp));
 		} else {
 			/*
 			 * Message was the head of some list, update
 			 * accordingly.
 			 */
 			if (tmp == messages.inactive) {
-				messages.inactive = messages.inactive->next;
+				messages.inactive = MESSAGE_NEXT(messages.inactive);
 				if (messages.inactive) {
 					ENV_TIMER_SET(messages.inactive->baseline);
+					cbs_timer();
 				}
 			} else {
-				messages.active = messages.active->next;
+				messages.active = MESSAGE_NEXT(messages.active);
 			}
 		}
+		cbs_done(tmp);
+
+		TT_TRACE_EVENT(
+				TT_TRACE_CANCEL,
+				THREAD_ID(CURRENT()),
+				tmp,
+				BODY(tmp)->to,
+				BODY(tmp)->method
+				);
 
 		/*
 		 * Message is now free and the receipt is no longer valid. We
 		 * should also return 0 to indicate success.
 		 */
-		ENQUEUE(messages.free, tmp);
+		MESSAGE_ENQUEUE(messages.free, tmp);
 		receipt->msg = NULL;
 		result = 0;
 	}
@@ -67,8 +67,40 @@ typedef struct tt_message_t tt_message_t;
 	 */
 #define TT_MESSAGE_RUN(msg) \
 	do {\
-		tt_request((msg)->to, (msg)->method, &(msg)->arg);\
+		tt_request(\
+				TT_MESSAGE_BODY(msg)->to,\
+				TT_MESSAGE_BODY(msg)->method,\
+				&TT_MESSAGE_BODY(msg)->arg\
+				);\
 	} while (0)
+
+#if defined TT_MESSAGE_SPLIT
+	/**
+	 * \brief Macro to access the payload of a message.
+	 *
+	 * With TT_MESSAGE_SPLIT (make MESSAGE_SPLIT=yes) a message holds the
+	 * link and the keys of the queues only, the payload is in a pool of
+	 * its own at the same position. Only valid in the kernel.
+	 */
+#	define TT_MESSAGE_BODY(msg) \
+	(&message_body[(msg) - message_pool])
+#else
+#	define TT_MESSAGE_BODY(msg) (msg)
+#endif
+
+/**
+ * \brief Macro for the deadline a message is accounted against.
+ *
+ * A message demoted by the shedding policy is queued by a later deadline,
+ * the statistics and miss detection still use the one it was posted with.
+ */
+#if defined TT_SHED
+#	define TT_MESSAGE_DEADLINE(msg) \
+	((TT_MESSAGE_BODY(msg)->flags & TT_FLAG_DEMOTED) ?\
+	 TT_MESSAGE_BODY(msg)->due : (msg)->deadline)
+#else
+#	define TT_MESSAGE_DEADLINE(msg) ((msg)->deadline)
+#endif
 #else
 /**
  * \brief tinyTimber message typedef.
@@ -118,6 +150,18 @@ struct tt_thread_t
 	 * \brief The next thread in the list.
 	 */
 	struct tt_thread_t *next;
+
+#if defined TT_MAGAZINE
+	/**
+	 * \brief The free messages kept by this thread.
+	 */
+	tt_message_t *magazine;
+
+	/**
+	 * \brief The number of messages in the magazine.
+	 */
+	int magazine_count;
+#endif
 };
 
 /* ************************************************************************** */
@@ -135,6 +179,12 @@ void tt_expired(env_time_t);
 
 /* ************************************************************************** */
 
+#if defined TT_TIMBER && (defined TT_MESSAGE_SPLIT || defined TT_MESSAGE_INDEX)
+#	error TT_MESSAGE_SPLIT and TT_MESSAGE_INDEX are not supported with TT_TIMBER.
+#endif
+
+/* ************************************************************************** */
+
 #ifndef TT_NUM_MESSAGES
 	/**
 	 * \brief The number of messages that the kernel facillitates.
@@ -153,6 +203,28 @@ void tt_expired(env_time_t);
 
 /* ************************************************************************** */
 
+#if defined TT_MAGAZINE
+
+#if defined TT_TIMBER
+#	error TT_MAGAZINE is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_MAGAZINE_SIZE
+	/**
+	 * \brief The number of free messages a thread keeps, half of them move
+	 * to or from the free list at a time.
+	 *
+	 * \note
+	 * 	Up to (ENV_NUM_THREADS + 1)*TT_MAGAZINE_SIZE messages may sit in
+	 * 	the magazines, the kernel adds that many to TT_NUM_MESSAGES.
+	 */
+#	define TT_MAGAZINE_SIZE	8
+#endif
+
+#endif /* TT_MAGAZINE */
+
+/* ************************************************************************** */
+
 #ifdef TT_KERNEL_SANITY
 	/** \cond */
 #	define _STR(str) #str
@@ -55,6 +55,12 @@
 	 */
 #	include <kernel_srp.h>
 #	include <objects_srp.h>
+#	include <trace.h>
+#	include <probe.h>
+#	include <stats.h>
+#	include <miss.h>
+#	include <shed.h>
+#	include <sporadic.h>
 #endif
 
 /*
@@ -111,6 +117,26 @@ struct tt_message_t
 	 */
 	tt_flags_t flags;
 
+#if defined TT_SHED
+	/**
+	 * \brief The deadline the message was posted with, kept for the
+	 * statistics and miss detection once it has been demoted.
+	 */
+	env_time_t due;
+#endif
+
+#if defined TT_STATS && defined ENV_CPU_GET
+	/**
+	 * \brief The processor time at dispatch.
+	 */
+	long cpu;
+
+	/**
+	 * \brief The preempted time of the message this one preempted.
+	 */
+	long nested;
+#endif
+
 	/**
 	 * \brief TinyTimber argument buffer.
 	 */
@@ -162,6 +188,14 @@ static struct
 
 	/** \brief List of free messages. */
 	tt_message_t *free;
+
+#if defined TT_SHED
+	/**
+	 * \brief The deadline of the last message queued at the end of the
+	 * active list, no active message has a later one.
+	 */
+	env_time_t latest;
+#endif
 } messages;
 
 /* ************************************************************************** */
@@ -263,6 +297,13 @@ static ENV_CODE_FAST ENV_INLINE void enqueue_by_deadline(tt_message_t **list, tt
 	} else {
 		*list = msg;
 	}
+
+#if defined TT_SHED
+	/* Only the active list is sorted by deadline. */
+	if (!tmp) {
+		messages.latest = msg->deadline;
+	}
+#endif
 }
 
 /* ************************************************************************** */
@@ -296,6 +337,130 @@ static ENV_CODE_FAST ENV_INLINE void enqueue_by_baseline(tt_message_t **list, tt
 	}
 }
 
+#if defined TT_SHED
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shed function.
+ *
+ * Applies the shedding policy of the object at the head of the active
+ * list until the head should be dispatched or the list is empty. Dropped
+ * messages are freed as if canceled, demoted messages are queued behind
+ * all active messages and are never shed again. Their own deadline is
+ * kept in due for the accounting.
+ */
+static ENV_CODE_FAST void shed_active(void)
+{
+	int superseded;
+	env_time_t now;
+	tt_shed_t *entry;
+	tt_message_t *tmp, *last;
+
+	while (messages.active) {
+		tmp = messages.active;
+		if (tmp->flags & TT_FLAG_DEMOTED) {
+			return;
+		}
+		entry = tt_shed_find(tmp->to);
+		if (!entry) {
+			return;
+		}
+
+		/* Look for a newer message to the same method. */
+		superseded = 0;
+		if (entry->policy & TT_SHED_LATEST) {
+			for (last = tmp->next;last && !superseded;last = last->next) {
+				superseded =
+					last->to == tmp->to && last->method == tmp->method;
+			}
+		}
+
+		now = ENV_TIMER_GET();
+		switch (tt_shed_action(entry, tmp->deadline, now, superseded)) {
+			case TT_SHED_DROP:
+				DEQUEUE(messages.active, tmp);
+				if (tmp->receipt) {
+					tmp->receipt->msg = NULL;
+				}
+				TT_TRACE_EVENT(TT_TRACE_CANCEL, 0, tmp, tmp->to, tmp->method);
+				ENQUEUE(messages.free, tmp);
+				break;
+
+			case TT_SHED_DEMOTED:
+				DEQUEUE(messages.active, tmp);
+				tmp->due = tmp->deadline;
+				if (messages.active) {
+					tmp->deadline = messages.latest;
+				}
+				tmp->flags |= TT_FLAG_DEMOTED;
+				enqueue_by_deadline(&messages.active, tmp);
+				break;
+
+			default:
+				return;
+		}
+	}
+}
+
+#else
+
+/** \cond */
+#	define shed_active()
+/** \endcond */
+
+#endif /* TT_SHED */
+
+/* ************************************************************************** */
+
+#if defined TT_STATS && defined ENV_CPU_GET
+
+/** \cond */
+static long stats_nested;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber execution time start function.
+ *
+ * All messages share one stack, a message that preempts another runs and
+ * completes on top of it. The processor time of the preempting messages
+ * is collected in stats_nested and excluded from the preempted one.
+ *
+ * \param msg The message about to run.
+ */
+static ENV_CODE_FAST void stats_begin(tt_message_t *msg)
+{
+	msg->nested = stats_nested;
+	stats_nested = 0;
+	msg->cpu = ENV_CPU_GET();
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber execution time stop function.
+ *
+ * \param msg The message that completed.
+ */
+static ENV_CODE_FAST void stats_end(tt_message_t *msg)
+{
+	long elapsed = ENV_CPU_GET() - msg->cpu;
+
+	tt_stats_execution(msg->to, msg->method, elapsed - stats_nested);
+	stats_nested = msg->nested + elapsed;
+}
+
+#else
+
+/** \cond */
+#	define stats_begin(msg)
+#	define stats_end(msg)
+/** \endcond */
+
+#endif /* TT_STATS && ENV_CPU_GET */
+
 /* ************************************************************************** */
 
 /**
@@ -391,6 +556,9 @@ ENV_CODE_FAST void tt_schedule(void)
 
 		TT_SANITY(ENV_ISPROTECTED());
 
+		/* Shed what can not be run usefully before picking the next. */
+		shed_active();
+
 		/* If there are not messages waiting to run then no-op. */
 		if (!messages.active) {
 			return;
@@ -430,7 +598,14 @@ ENV_CODE_FAST void tt_schedule(void)
 	dispatch:
 		/* Dispatch the message at the top of the active stack. */
 		DEQUEUE(messages.active, tmp);
+		if (messages.running) {
+			TT_TRACE_EVENT(TT_TRACE_SCHEDULE, 0, tmp, tmp->to, tmp->method);
+			TT_PROBE(preempt, tmp, tmp->to, tmp->method);
+		}
 		ENQUEUE(messages.running, tmp);
+		TT_TRACE_EVENT(TT_TRACE_DISPATCH, 0, tmp, tmp->to, tmp->method);
+		TT_PROBE(dispatch, tmp, tmp->to, tmp->method);
+		TT_STATS_DISPATCH(tmp);
 
 		/* Clear the receipt. */
 		if (tmp->receipt) {
@@ -439,6 +614,7 @@ ENV_CODE_FAST void tt_schedule(void)
 
 		/* Perform the request, this will be the "root" of the request chain. */
 		ENV_INTERRUPT_PRIORITY_RESET();
+		stats_begin(tmp);
 		tt_request(tmp->to, tmp->method, tmp->arg.buf);
 	}
 }
@@ -467,6 +643,9 @@ void ENV_CODE_FAST tt_expired(env_time_t now)
 	while (messages.inactive && ENV_TIME_LE(messages.inactive->baseline, now)) {
 		DEQUEUE(messages.inactive, tmp);
 		enqueue_by_deadline(&messages.active, tmp);
+		TT_TRACE_EVENT(TT_TRACE_RELEASE, 0, tmp, tmp->to, tmp->method);
+		TT_PROBE(release, tmp, tmp->to, tmp->method);
+		TT_MISS_RELEASE(tmp, now);
 	}
 
 	/*
@@ -502,11 +681,11 @@ ENV_CODE_FAST env_result_t tt_request(tt_object_t *to, tt_method_t method, void
 {
 	tt_message_t *tmp;
 	env_result_t result;
+	int protected = ENV_ISPROTECTED();
 
 	TT_SANITY(to);
 	TT_SANITY(method);
 	TT_SANITY(to->resource.id & to->resource.req);
-	TT_SANITY(ENV_ISPROTECTED());
 
 	ENV_PROTECT(1);
 
@@ -523,6 +702,16 @@ ENV_CODE_FAST env_result_t tt_request(tt_object_t *to, tt_method_t method, void
 	result = method(to, arg);
 	ENV_PROTECT(1);
 
+	/*
+	 * Account the completion of a root message before anything that
+	 * preempts it from tt_schedule() below gets to run.
+	 */
+	if (messages.running->to == to) {
+		stats_end(messages.running);
+		TT_STATS_COMPLETE(messages.running);
+		TT_MISS_COMPLETE(messages.running);
+	}
+
 	/* Release the resource again an schedule any even that has an
 	 * earlier deadline than the currently running messages. We should
 	 * NOT be tempted and call tt_schedule after we remove ourself if
@@ -539,9 +728,17 @@ ENV_CODE_FAST env_result_t tt_request(tt_object_t *to, tt_method_t method, void
 	 */
 	if (messages.running->to == to) {
 		DEQUEUE(messages.running, tmp);
+		TT_TRACE_EVENT(TT_TRACE_COMPLETE, 0, tmp, tmp->to, tmp->method);
+		TT_PROBE(complete, tmp, tmp->to, tmp->method);
 		ENQUEUE(messages.free, tmp);
 	}
 
+	/*
+	 * Root requests come from tt_schedule() (protected), synchronous ones
+	 * from a method, which must continue unprotected.
+	 */
+	ENV_PROTECT(protected);
+
 	return result;
 }
 
@@ -591,6 +788,7 @@ ENV_CODE_FAST void tt_action(
 	}
 
 	DEQUEUE(messages.free, msg);
+	msg->flags = 0;
 	msg->receipt = receipt;
 	if (receipt) {
 		receipt->msg = msg;
@@ -651,12 +849,41 @@ ENV_CODE_FAST void tt_action(
 	 */
 	ENV_PROTECT(1);
 
+	TT_TRACE_EVENT(TT_TRACE_ACTION, 0, msg, to, method);
+	TT_PROBE(post, msg, to, method);
+
+#if defined TT_SPORADIC
+	/*
+	 * An interrupt source with a sporadic server may only post its share,
+	 * the excess is moved to a later period or dropped.
+	 */
+	if (
+		protected &&
+		tt_sporadic_current &&
+		!tt_sporadic_admit(
+			tt_sporadic_current,
+			ENV_TIMER_GET(),
+			&msg->baseline,
+			&msg->deadline
+			)
+		) {
+		if (msg->receipt) {
+			msg->receipt->msg = NULL;
+		}
+		ENQUEUE(messages.free, msg);
+		ENV_PROTECT(protected);
+		return;
+	}
+#endif
+
 	/*
 	 * If baseline expired already then we should place the message in
 	 * the active list, otherwise the inactive list.
 	 */
 	if (ENV_TIME_LE(msg->baseline, ENV_TIMER_GET())) {
 		enqueue_by_deadline(&messages.active, msg);
+		TT_PROBE(release, msg, to, method);
+		TT_MISS_RELEASE(msg, ENV_TIMER_GET());
 	} else {
 		enqueue_by_baseline(&messages.inactive, msg);
 		if (messages.inactive == msg) {
@@ -669,6 +896,38 @@ ENV_CODE_FAST void tt_action(
 
 /* ************************************************************************** */
 
+/**
+ * \brief TinyTimber baseline function.
+ *
+ * \return The baseline of the running message, or the time of the
+ * interrupt when called from an interrupt handler.
+ */
+ENV_CODE_FAST env_time_t tt_baseline(void)
+{
+	if (ENV_ISPROTECTED() || !messages.running) {
+		return ENV_TIMESTAMP();
+	}
+	return messages.running->baseline;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline function.
+ *
+ * \return The deadline of the running message, or the time of the
+ * interrupt when called from an interrupt handler.
+ */
+ENV_CODE_FAST env_time_t tt_deadline(void)
+{
+	if (ENV_ISPROTECTED() || !messages.running) {
+		return ENV_TIMESTAMP();
+	}
+	return messages.running->deadline;
+}
+
+/* ************************************************************************** */
+
 /**
  * \brief TinyTimber tt_cancel function.
  *
@@ -735,6 +994,8 @@ ENV_CODE_FAST int tt_cancel(tt_receipt_t *receipt)
 			}
 		}
 
+		TT_TRACE_EVENT(TT_TRACE_CANCEL, 0, tmp, tmp->to, tmp->method);
+
 		/*
 		 * Message is now free and the receipt is no longer valid. We should
 		 * also return 0 to indicate success.
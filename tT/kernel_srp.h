@@ -60,6 +60,29 @@
  */
 typedef struct tt_message_t tt_message_t;
 
+#if defined TT_MESSAGE_SPLIT || defined TT_MESSAGE_INDEX
+#	error TT_MESSAGE_SPLIT and TT_MESSAGE_INDEX are not supported by SRP.
+#endif
+
+/**
+ * \brief Macro to access the payload of a message, the message itself.
+ */
+#define TT_MESSAGE_BODY(msg) (msg)
+
+/**
+ * \brief Macro for the deadline a message is accounted against.
+ *
+ * A message demoted by the shedding policy is queued by a later deadline,
+ * the statistics and miss detection still use the one it was posted with.
+ */
+#if defined TT_SHED
+#	define TT_MESSAGE_DEADLINE(msg) \
+	((TT_MESSAGE_BODY(msg)->flags & TT_FLAG_DEMOTED) ?\
+	 TT_MESSAGE_BODY(msg)->due : (msg)->deadline)
+#else
+#	define TT_MESSAGE_DEADLINE(msg) ((msg)->deadline)
+#endif
+
 /* ************************************************************************** */
 
 void tt_expired(env_time_t);
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber deadline miss detection implementation.
+ *
+ * Entries are kept in the same kind of pair table (pair.h) as the
+ * statistics, until tt_miss_reset().
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <miss.h>
+#	include <pair.h>
+#endif
+
+#if defined TT_MISS
+
+#if (TT_MISS_ENTRIES & (TT_MISS_ENTRIES - 1))
+#	error TT_MISS_ENTRIES must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+static tt_miss_t miss_table[TT_MISS_ENTRIES + 1];
+static void *miss_order[TT_MISS_ENTRIES + 1];
+static tt_pair_table_t miss_pairs =
+	TT_PAIR_TABLE(miss_table, miss_order, TT_MISS_ENTRIES);
+static unsigned long miss_total;
+static tt_miss_handler_t miss_handler;
+
+#define miss_lookup(to, method) \
+	((tt_miss_t *)tt_pair_lookup(&miss_pairs, (to), (method)))
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss release function.
+ *
+ * Use the TT_MISS_RELEASE() macro instead.
+ *
+ * \param to The object.
+ * \param method The method.
+ */
+void tt_miss_release(tt_object_t *to, tt_method_t method)
+{
+	miss_lookup(to, method)->stale++;
+	miss_total++;
+	if (miss_handler) {
+		miss_handler(to, method, TT_MISS_STALE);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss completion function.
+ *
+ * Use the TT_MISS_COMPLETE() macro instead.
+ *
+ * \param to The object.
+ * \param method The method.
+ * \param deadline The deadline of the message.
+ */
+ENV_CODE_FAST void tt_miss_complete(
+		tt_object_t *to,
+		tt_method_t method,
+		env_time_t deadline
+		)
+{
+	env_time_t now = ENV_TIMER_GET();
+
+	if (ENV_TIME_LE(now, deadline)) {
+		return;
+	}
+
+	miss_lookup(to, method)->late++;
+	miss_total++;
+	if (miss_handler) {
+		miss_handler(to, method, TT_MISS_LATE);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss handler function.
+ *
+ * \param handler The handler to call on every miss, NULL for none.
+ */
+void tt_miss_handler(tt_miss_handler_t handler)
+{
+	miss_handler = handler;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss total function.
+ *
+ * \return The number of misses of either kind since the last reset.
+ */
+unsigned long tt_miss_total(void)
+{
+	return miss_total;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss count function.
+ *
+ * \return The number of entries in use, in order of first miss.
+ */
+int tt_miss_count(void)
+{
+	return miss_pairs.count;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss get function.
+ *
+ * \param i The index of the entry, below tt_miss_count().
+ * \return The entry.
+ */
+tt_miss_t *tt_miss_get(int i)
+{
+	return miss_order[i];
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss reset function.
+ *
+ * Must be called in protected mode.
+ */
+void tt_miss_reset(void)
+{
+	int i;
+
+	tt_pair_reset(&miss_pairs);
+	for (i=0;i<=TT_MISS_ENTRIES;i++) {
+		miss_table[i].late = 0;
+		miss_table[i].stale = 0;
+	}
+	miss_total = 0;
+}
+
+#endif /* TT_MISS */
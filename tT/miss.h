@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber deadline miss detection.
+ *
+ * Compiled in when TT_MISS is defined (make MISS=yes), otherwise the hooks
+ * expand to nothing. Two kinds of misses are detected:
+ *
+ *	late:	the message completed after its deadline.
+ *	stale:	the message was released with its deadline already passed,
+ *		it can not possibly complete in time.
+ *
+ * Misses are counted per object/method pair and, if registered, reported
+ * to a user miss handler. Messages without a relative deadline (deadline
+ * equal to the baseline, as posted by the SRP kernel) are never misses.
+ */
+
+#ifndef MISS_H_
+#define MISS_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber deadline miss kinds.
+ */
+enum
+{
+	/**
+	 * \brief The message completed after its deadline.
+	 */
+	TT_MISS_LATE,
+
+	/**
+	 * \brief The message was released after its deadline.
+	 */
+	TT_MISS_STALE
+};
+
+/* ************************************************************************** */
+
+#if defined TT_MISS
+
+#if defined TT_TIMBER
+#	error TT_MISS is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_MISS_ENTRIES
+	/**
+	 * \brief The number of object/method pairs tracked, a power of two.
+	 *
+	 * Pairs that do not fit are accounted to a shared overflow entry with
+	 * a NULL object and method.
+	 */
+#	define TT_MISS_ENTRIES 16
+#endif
+
+/**
+ * \brief TinyTimber deadline miss entry, one per object/method pair.
+ */
+typedef struct tt_miss_t
+{
+	/**
+	 * \brief The object, NULL for the overflow entry.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method, NULL for the overflow entry.
+	 */
+	tt_method_t method;
+
+	/**
+	 * \brief The number of messages that completed late.
+	 */
+	unsigned long late;
+
+	/**
+	 * \brief The number of messages released after their deadline.
+	 */
+	unsigned long stale;
+} tt_miss_t;
+
+/**
+ * \brief TinyTimber deadline miss handler.
+ *
+ * Called in protected mode with the object, the method and the kind of
+ * the miss. The handler must be short and may only post messages.
+ */
+typedef void (*tt_miss_handler_t)(tt_object_t *, tt_method_t, int);
+
+void tt_miss_release(tt_object_t *, tt_method_t);
+void tt_miss_complete(tt_object_t *, tt_method_t, env_time_t);
+void tt_miss_handler(tt_miss_handler_t);
+unsigned long tt_miss_total(void);
+int tt_miss_count(void);
+tt_miss_t *tt_miss_get(int);
+void tt_miss_reset(void);
+
+/**
+ * \brief TinyTimber deadline miss release hook.
+ *
+ * Must be used in protected mode.
+ */
+#define TT_MISS_RELEASE(msg, now) \
+	do {\
+		if (\
+			ENV_TIME_LT((msg)->baseline, (msg)->deadline) &&\
+			ENV_TIME_LT((msg)->deadline, now)\
+			) {\
+			tt_miss_release(\
+					TT_MESSAGE_BODY(msg)->to,\
+					TT_MESSAGE_BODY(msg)->method\
+					);\
+		}\
+	} while (0)
+
+/**
+ * \brief TinyTimber deadline miss completion hook.
+ *
+ * Must be used in protected mode.
+ */
+#define TT_MISS_COMPLETE(msg) \
+	do {\
+		if (ENV_TIME_LT((msg)->baseline, TT_MESSAGE_DEADLINE(msg))) {\
+			tt_miss_complete(\
+					TT_MESSAGE_BODY(msg)->to,\
+					TT_MESSAGE_BODY(msg)->method,\
+					TT_MESSAGE_DEADLINE(msg)\
+					);\
+		}\
+	} while (0)
+
+#else
+
+/** \cond */
+#	define TT_MISS_RELEASE(msg, now)
+#	define TT_MISS_COMPLETE(msg)
+/** \endcond */
+
+#endif /* TT_MISS */
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber object/method pair table implementation.
+ *
+ * Pairs are found by open addressing, entries are never removed until
+ * tt_pair_reset(). Only used in protected mode, there is a single writer
+ * at any time and the table needs no lock of its own.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <pair.h>
+#endif
+
+#if defined TT_STATS || defined TT_MISS
+
+/* ************************************************************************** */
+
+/** \cond */
+#define PAIR_ENTRY(table, i) \
+	((tt_pair_t *)((char *)(table)->entries + (size_t)(i)*(table)->stride))
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber pair lookup function.
+ *
+ * A pair seen for the first time takes a free entry.
+ *
+ * \param table The table.
+ * \param to The object.
+ * \param method The method.
+ * \return The entry of the pair, the overflow entry when the table is full.
+ */
+ENV_CODE_FAST void *tt_pair_lookup(
+		tt_pair_table_t *table,
+		tt_object_t *to,
+		tt_method_t method
+		)
+{
+	int i, n;
+	int mask = table->size - 1;
+	tt_pair_t *entry;
+
+	i = (int)((((size_t)to >> 4) ^ ((size_t)method >> 2)) & mask);
+	for (n=0;n<table->size;n++) {
+		entry = PAIR_ENTRY(table, (i + n) & mask);
+		if (entry->to == to && entry->method == method) {
+			return entry;
+		}
+		if (!entry->to) {
+			entry->to = to;
+			entry->method = method;
+			table->order[table->count++] = entry;
+			return entry;
+		}
+	}
+
+	/* Table is full, account to the overflow entry. */
+	entry = PAIR_ENTRY(table, table->size);
+	if (!table->overflow) {
+		table->overflow = 1;
+		table->order[table->count++] = entry;
+	}
+	return entry;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber pair reset function.
+ *
+ * Frees every entry, the counters after the key are left to the user.
+ *
+ * \param table The table.
+ */
+void tt_pair_reset(tt_pair_table_t *table)
+{
+	int i;
+
+	for (i=0;i<=table->size;i++) {
+		PAIR_ENTRY(table, i)->to = NULL;
+		PAIR_ENTRY(table, i)->method = NULL;
+	}
+	table->count = 0;
+	table->overflow = 0;
+}
+
+#endif /* TT_STATS || TT_MISS */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber object/method pair table.
+ *
+ * A fixed table of entries keyed by object and method, shared by the timing
+ * statistics and the deadline miss detection. Every entry starts with the
+ * fields of a tt_pair_t, the users put their counters after them. There is one more entry
+ * than the table size, the overflow entry, holding the pairs that did not
+ * fit.
+ */
+
+#ifndef PAIR_H_
+#define PAIR_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_STATS || defined TT_MISS
+
+/**
+ * \brief TinyTimber pair, the key of a table entry.
+ */
+typedef struct tt_pair_t
+{
+	/**
+	 * \brief The object, NULL for a free and for the overflow entry.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method, NULL for a free and for the overflow entry.
+	 */
+	tt_method_t method;
+} tt_pair_t;
+
+/**
+ * \brief TinyTimber pair table.
+ */
+typedef struct tt_pair_table_t
+{
+	/**
+	 * \brief The entries, size + 1 of them.
+	 */
+	void *entries;
+
+	/**
+	 * \brief The size of an entry.
+	 */
+	size_t stride;
+
+	/**
+	 * \brief The number of entries, the overflow entry excluded, a power
+	 * of two.
+	 */
+	int size;
+
+	/**
+	 * \brief The entries in use in order of first use, size + 1 of them.
+	 */
+	void **order;
+
+	/**
+	 * \brief The number of entries in use.
+	 */
+	int count;
+
+	/**
+	 * \brief Non-zero once the overflow entry is in use.
+	 */
+	int overflow;
+} tt_pair_table_t;
+
+/**
+ * \brief TinyTimber pair table initializer.
+ *
+ * \param entries The array of size + 1 entries.
+ * \param order The array of size + 1 pointers.
+ * \param size The number of entries, a power of two.
+ */
+#define TT_PAIR_TABLE(entries, order, size) \
+	{(entries), sizeof((entries)[0]), (size), (order), 0, 0}
+
+void *tt_pair_lookup(tt_pair_table_t *, tt_object_t *, tt_method_t);
+void tt_pair_reset(tt_pair_table_t *);
+
+#endif /* TT_STATS || TT_MISS */
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber kernel USDT probes.
+ *
+ * Environments that define ENV_USDT get user space statically defined
+ * trace points (provider "tinytimber") through <sys/sdt.h>, a single nop
+ * each until perf or bpftrace attaches to them. Everywhere else, or when
+ * the header is missing, the probes expand to nothing.
+ *
+ * All probes take the message, the object and the method as arguments:
+ *
+ *	post		The message was posted (tt_action()).
+ *	release		The message became active, its baseline was reached.
+ *	dispatch	The message started to run.
+ *	preempt		The message preempted a running message.
+ *	complete	The message finished running.
+ *
+ * An environment that needs to follow the kernel itself (such as a
+ * simulator) defines ENV_PROBE(name, msg, to, method) instead, it replaces
+ * the USDT probes.
+ */
+
+#ifndef PROBE_H_
+#define PROBE_H_
+
+#if defined ENV_PROBE && ! defined TT_TIMBER
+	/**
+	 * \brief TinyTimber environment probe.
+	 */
+#	define TT_PROBE(name, msg, to, method) \
+		ENV_PROBE(name, msg, to, method)
+#elif defined ENV_USDT && ! defined TT_TIMBER && defined __has_include
+#	if __has_include(<sys/sdt.h>)
+#		include <sys/sdt.h>
+
+		/**
+		 * \brief TinyTimber USDT probe.
+		 */
+#		define TT_PROBE(name, msg, to, method) \
+			STAP_PROBE3(tinytimber, name, msg, to, method)
+#	endif
+#endif
+
+#ifndef TT_PROBE
+/** \cond */
+#	define TT_PROBE(name, msg, to, method)
+/** \endcond */
+#endif
+
+#endif
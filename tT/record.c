@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber interrupt record implementation.
+ *
+ * Records are written by the interrupt handlers only, there is a single
+ * writer at any time. Unlike the trace the buffer is not a ring, a replay
+ * needs the beginning of the run. Events that do not fit are counted.
+ *
+ * tt_record_dump() serializes the records into a host independent format,
+ * all fields little endian:
+ *
+ *	header:	"TTRC", u32 version, u32 record count, u32 lost records.
+ *	record:	u64 time, u64 armed (ns since the start of the kernel),
+ *		u8 event, u8 interrupt id, 6 bytes of padding.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <record.h>
+#endif
+
+#if defined TT_RECORD
+
+#ifndef ENV_TRACE_NSEC
+#	error TT_RECORD requires ENV_TRACE_NSEC() from the environment.
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber record enabled flag.
+ */
+volatile int tt_record_enabled;
+
+/** \cond */
+static tt_record_t record_buffer[TT_RECORD_SIZE];
+static unsigned long record_count;
+static unsigned long record_lost;
+static int record_started;
+static env_time_t record_start;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber record enable function.
+ *
+ * The first time recording is enabled the timestamp becomes the start of
+ * the recording, the environment should do so at startup so that it is the
+ * time the baselines of the application are relative to.
+ *
+ * \param enable Non-zero to start recording, zero to stop.
+ */
+void tt_record_enable(int enable)
+{
+	if (enable && !record_started) {
+		record_start = ENV_TIMESTAMP();
+		record_started = 1;
+	}
+	tt_record_enabled = enable;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber record event function.
+ *
+ * Use the TT_RECORD_EVENT() macro instead.
+ *
+ * \param event The event.
+ * \param id The interrupt id.
+ * \param time The time the event was taken.
+ * \param armed The time the timer was set to.
+ */
+ENV_CODE_FAST void tt_record_event(
+		int event,
+		int id,
+		env_time_t time,
+		env_time_t armed
+		)
+{
+	tt_record_t *record;
+
+	if (record_count == TT_RECORD_SIZE) {
+		record_lost++;
+		return;
+	}
+
+	record = &record_buffer[record_count++];
+	record->time = time;
+	record->armed = armed;
+	record->event = event;
+	record->id = id;
+}
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief TinyTimber record write a little endian value.
+ */
+static void record_put(
+		tt_record_write_t write,
+		void *data,
+		unsigned long long value,
+		int size
+		)
+{
+	int i;
+	unsigned char buf[8];
+
+	for (i=0;i<size;i++) {
+		buf[i] = (unsigned char)(value >> (8*i));
+	}
+	write(buf, size, data);
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber record dump function.
+ *
+ * Serializes the recorded events in the order they were taken. Recording
+ * is stopped while dumping.
+ *
+ * \param write Called with each chunk of the serialized record.
+ * \param data User data for write.
+ */
+void tt_record_dump(tt_record_write_t write, void *data)
+{
+	int enabled = tt_record_enabled;
+	unsigned long i;
+	unsigned long long start = ENV_TRACE_NSEC(record_start);
+	tt_record_t *record;
+
+	tt_record_enabled = 0;
+
+	write("TTRC", 4, data);
+	record_put(write, data, TT_RECORD_VERSION, 4);
+	record_put(write, data, record_count, 4);
+	record_put(write, data, record_lost, 4);
+
+	for (i=0;i<record_count;i++) {
+		record = &record_buffer[i];
+		record_put(write, data, ENV_TRACE_NSEC(record->time) - start, 8);
+		record_put(write, data, ENV_TRACE_NSEC(record->armed) - start, 8);
+		record_put(write, data, record->event, 1);
+		record_put(write, data, record->id, 1);
+		record_put(write, data, 0, 6);
+	}
+
+	tt_record_enabled = enabled;
+}
+
+#endif /* TT_RECORD */
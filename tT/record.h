@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber interrupt record.
+ *
+ * Compiled in when TT_RECORD is defined (make RECORD=yes), otherwise the
+ * record points expand to nothing. The environment logs every external
+ * interrupt and timer expiry it takes, with the time relative to the start
+ * of the kernel, and for the timer also the time it was set to fire. The
+ * simulated time environment replays such a dump at the same virtual times
+ * (TT_SIM_REPLAY), so a capture of a real run can be run again against
+ * another kernel build and the traces and statistics of the two compared.
+ */
+
+#ifndef RECORD_H_
+#define RECORD_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber record events.
+ */
+enum
+{
+	/**
+	 * \brief The timer expired (tt_expired()).
+	 */
+	TT_RECORD_TIMER,
+
+	/**
+	 * \brief An external interrupt was taken.
+	 */
+	TT_RECORD_INTERRUPT,
+
+	/**
+	 * \brief The number of record events.
+	 */
+	TT_RECORD_EVENTS
+};
+
+/**
+ * \brief TinyTimber record file format version.
+ */
+#define TT_RECORD_VERSION 1
+
+/* ************************************************************************** */
+
+#if defined TT_RECORD
+
+#if defined TT_TIMBER
+#	error TT_RECORD is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_RECORD_SIZE
+	/**
+	 * \brief The number of records kept, later ones are counted as lost.
+	 */
+#	define TT_RECORD_SIZE 65536
+#endif
+
+/**
+ * \brief TinyTimber record.
+ */
+typedef struct tt_record_t
+{
+	/**
+	 * \brief The time the event was taken.
+	 */
+	env_time_t time;
+
+	/**
+	 * \brief The time the timer was set to, the time itself for interrupts.
+	 */
+	env_time_t armed;
+
+	/**
+	 * \brief The event.
+	 */
+	unsigned char event;
+
+	/**
+	 * \brief The interrupt id.
+	 */
+	unsigned char id;
+} tt_record_t;
+
+/**
+ * \brief TinyTimber record writer callback.
+ */
+typedef void (*tt_record_write_t)(const void *, size_t, void *);
+
+extern volatile int tt_record_enabled;
+
+void tt_record_enable(int);
+void tt_record_event(int, int, env_time_t, env_time_t);
+void tt_record_dump(tt_record_write_t, void *);
+
+/**
+ * \brief TinyTimber record point.
+ *
+ * Must be used in protected mode (or from the interrupt).
+ */
+#define TT_RECORD_EVENT(event, id, time, armed) \
+	do {\
+		if (tt_record_enabled) {\
+			tt_record_event(event, id, time, armed);\
+		}\
+	} while (0)
+
+#else
+
+/** \cond */
+#	define TT_RECORD_EVENT(event, id, time, armed)
+/** \endcond */
+
+#endif /* TT_RECORD */
+
+#endif
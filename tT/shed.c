@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber overload shedding implementation.
+ *
+ * Policies live in a fixed table found by open addressing on the object,
+ * entries are never removed. The kernel only calls in here while the
+ * table is non-empty, so shedding costs nothing until a policy is set.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <shed.h>
+#endif
+
+#if defined TT_SHED
+
+#if (TT_SHED_ENTRIES & (TT_SHED_ENTRIES - 1))
+#	error TT_SHED_ENTRIES must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+static tt_shed_t shed_table[TT_SHED_ENTRIES];
+static int shed_count;
+static unsigned long shed_dropped;
+static unsigned long shed_demoted;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding slot function.
+ *
+ * \param to The object.
+ * \return The entry of the object or the free entry where it belongs,
+ * NULL if neither exists.
+ */
+static ENV_CODE_FAST tt_shed_t *shed_slot(tt_object_t *to)
+{
+	int i, n;
+	tt_shed_t *entry;
+
+	i = (int)(((size_t)to >> 4) & (TT_SHED_ENTRIES - 1));
+	for (n=0;n<TT_SHED_ENTRIES;n++) {
+		entry = &shed_table[(i + n) & (TT_SHED_ENTRIES - 1)];
+		if (entry->to == to || !entry->to) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding policy function.
+ *
+ * Should be called before the object receives any messages, typically
+ * from the startup function.
+ *
+ * \note
+ *	Will call ENV_PANIC() when there is no room for the object.
+ *
+ * \param to The object.
+ * \param policy The policy flags, TT_SHED_STALE etc. Zero for none.
+ * \param wcet The worst case execution time of any method of the object,
+ * used by TT_SHED_WCET.
+ */
+void tt_shed_policy(tt_object_t *to, int policy, env_time_t wcet)
+{
+	int protected = ENV_ISPROTECTED();
+	tt_shed_t *entry;
+
+	ENV_PROTECT(1);
+
+	entry = shed_slot(to);
+	if (!entry) {
+		ENV_PANIC("tt_shed_policy(): Out of entries.\n");
+	}
+	if (!entry->to) {
+		entry->to = to;
+		shed_count++;
+	}
+	entry->policy = policy;
+	entry->wcet = wcet;
+
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding find function.
+ *
+ * Must be called in protected mode.
+ *
+ * \param to The object.
+ * \return The entry of the object, NULL if it has no policy.
+ */
+ENV_CODE_FAST tt_shed_t *tt_shed_find(tt_object_t *to)
+{
+	tt_shed_t *entry;
+
+	if (!shed_count) {
+		return NULL;
+	}
+
+	entry = shed_slot(to);
+	if (!entry || !entry->to || !entry->policy) {
+		return NULL;
+	}
+	return entry;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding action function.
+ *
+ * Decides what to do with the message at the head of the active queue and
+ * accounts the decision. Must be called in protected mode.
+ *
+ * \param entry The entry of the object of the message.
+ * \param deadline The deadline of the message.
+ * \param now The current time.
+ * \param superseded Non-zero if a newer message for the same object and
+ * method is active.
+ * \return TT_SHED_RUN, TT_SHED_DROP or TT_SHED_DEMOTED.
+ */
+ENV_CODE_FAST int tt_shed_action(
+		tt_shed_t *entry,
+		env_time_t deadline,
+		env_time_t now,
+		int superseded
+		)
+{
+	int late = 0;
+	env_time_t finish;
+
+	if ((entry->policy & TT_SHED_LATEST) && superseded) {
+		entry->dropped++;
+		shed_dropped++;
+		return TT_SHED_DROP;
+	}
+
+	if ((entry->policy & TT_SHED_STALE) && ENV_TIME_LT(deadline, now)) {
+		late = 1;
+	} else if (entry->policy & TT_SHED_WCET) {
+		finish = ENV_TIME_ADD(now, entry->wcet);
+		late = ENV_TIME_LT(deadline, finish);
+	}
+
+	if (!late) {
+		return TT_SHED_RUN;
+	}
+
+	if (entry->policy & TT_SHED_DEMOTE) {
+		entry->demoted++;
+		shed_demoted++;
+		return TT_SHED_DEMOTED;
+	}
+
+	entry->dropped++;
+	shed_dropped++;
+	return TT_SHED_DROP;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding dropped function.
+ *
+ * \return The number of messages dropped.
+ */
+unsigned long tt_shed_dropped(void)
+{
+	return shed_dropped;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding demoted function.
+ *
+ * \return The number of messages demoted.
+ */
+unsigned long tt_shed_demoted(void)
+{
+	return shed_demoted;
+}
+
+#endif /* TT_SHED */
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber overload shedding.
+ *
+ * Compiled in when TT_SHED is defined (make SHED=yes). Under overload EDF
+ * lets every message miss its deadline, one after the other (the domino
+ * effect). With shedding the kernel consults the policy of the object at
+ * the head of the active queue before dispatching it and may drop the
+ * message or demote it behind every other active message.
+ *
+ * Policies are set per object with tt_shed_policy(), objects without a
+ * policy are never shed.
+ */
+
+#ifndef SHED_H_
+#define SHED_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber shedding policy flags.
+ */
+enum
+{
+	/**
+	 * \brief Shed messages that are already past their deadline.
+	 */
+	TT_SHED_STALE = 0x01,
+
+	/**
+	 * \brief Shed messages that can not finish in time given the WCET.
+	 */
+	TT_SHED_WCET = 0x02,
+
+	/**
+	 * \brief Drop messages superseded by a newer active message for the
+	 * same object and method (keep latest).
+	 */
+	TT_SHED_LATEST = 0x04,
+
+	/**
+	 * \brief Demote instead of drop for TT_SHED_STALE and TT_SHED_WCET.
+	 */
+	TT_SHED_DEMOTE = 0x08
+};
+
+/**
+ * \brief TinyTimber shedding actions.
+ */
+enum
+{
+	/**
+	 * \brief Dispatch the message.
+	 */
+	TT_SHED_RUN,
+
+	/**
+	 * \brief Drop the message, as if canceled.
+	 */
+	TT_SHED_DROP,
+
+	/**
+	 * \brief Move the message behind all other active messages.
+	 */
+	TT_SHED_DEMOTED
+};
+
+/* ************************************************************************** */
+
+#if defined TT_SHED
+
+#if defined TT_TIMBER
+#	error TT_SHED is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_SHED_ENTRIES
+	/**
+	 * \brief The number of objects that can have a policy, a power of two.
+	 */
+#	define TT_SHED_ENTRIES 16
+#endif
+
+/**
+ * \brief TinyTimber shedding entry, one per object.
+ */
+typedef struct tt_shed_t
+{
+	/**
+	 * \brief The object.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The policy flags.
+	 */
+	int policy;
+
+	/**
+	 * \brief The declared worst case execution time.
+	 */
+	env_time_t wcet;
+
+	/**
+	 * \brief The number of messages dropped.
+	 */
+	unsigned long dropped;
+
+	/**
+	 * \brief The number of messages demoted.
+	 */
+	unsigned long demoted;
+} tt_shed_t;
+
+void tt_shed_policy(tt_object_t *, int, env_time_t);
+tt_shed_t *tt_shed_find(tt_object_t *);
+int tt_shed_action(tt_shed_t *, env_time_t, env_time_t, int);
+unsigned long tt_shed_dropped(void);
+unsigned long tt_shed_demoted(void);
+
+#endif /* TT_SHED */
+
+#endif
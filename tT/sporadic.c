@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber sporadic servers implementation.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <sporadic.h>
+#endif
+
+#if defined TT_SPORADIC
+
+/* ************************************************************************** */
+
+/**
+ * \brief The server of the interrupt handler running, if any.
+ */
+tt_sporadic_t *tt_sporadic_current;
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber sporadic server init function.
+ *
+ * \param server The server.
+ * \param capacity The number of messages per period.
+ * \param period The replenishment period.
+ * \param backlog The number of periods the excess may be queued, zero to
+ * drop all excess.
+ */
+void tt_sporadic_init(
+		tt_sporadic_t *server,
+		int capacity,
+		env_time_t period,
+		int backlog
+		)
+{
+	int protected = ENV_ISPROTECTED();
+
+	ENV_PROTECT(1);
+
+	server->capacity = capacity;
+	server->period = period;
+	server->backlog = backlog;
+	server->window = ENV_TIMER_GET();
+	server->used = capacity;
+	server->accepted = 0;
+	server->deferred = 0;
+	server->dropped = 0;
+
+	ENV_PROTECT(protected);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber sporadic server admit function.
+ *
+ * Called by the kernel for every message posted under a server, must be
+ * called in protected mode.
+ *
+ * \param server The server.
+ * \param now The current time.
+ * \param baseline The baseline of the message, moved to a later period if
+ * the capacity of the current one is used up.
+ * \param deadline The deadline of the message, moved along.
+ * \return Non-zero if the message should be posted, zero to drop it.
+ */
+ENV_CODE_FAST int tt_sporadic_admit(
+		tt_sporadic_t *server,
+		env_time_t now,
+		env_time_t *baseline,
+		env_time_t *deadline
+		)
+{
+	int periods = 0;
+	env_time_t end, relative, zero = ENV_SEC(0);
+
+	/* The latest period is over, the server is replenished. */
+	end = ENV_TIME_ADD(server->window, server->period);
+	if (!ENV_TIME_LT(now, end)) {
+		server->window = now;
+		server->used = 0;
+	}
+
+	if (server->used < server->capacity) {
+		server->used++;
+		if (ENV_TIME_LE(server->window, now)) {
+			server->accepted++;
+			return 1;
+		}
+	} else {
+		/* Count the periods ahead, drop beyond the backlog. */
+		if (ENV_TIME_LT(now, server->window)) {
+			periods = (int)(ENV_TIME_DIFF(server->window, now) /
+					ENV_TIME_DIFF(server->period, zero)) + 1;
+		}
+		if (periods >= server->backlog) {
+			server->dropped++;
+			return 0;
+		}
+		server->window = ENV_TIME_ADD(server->window, server->period);
+		server->used = 1;
+	}
+
+	/* Queue for the period of the window, keeping the relative deadline. */
+	relative = ENV_TIME_LT(*baseline, *deadline) ?
+		ENV_TIME_SUB(*deadline, *baseline) : zero;
+	*baseline = server->window;
+	*deadline = ENV_TIME_ADD(*baseline, relative);
+	server->deferred++;
+	return 1;
+}
+
+#endif /* TT_SPORADIC */
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber sporadic servers for interrupt sources.
+ *
+ * Compiled in when TT_SPORADIC is defined (make SPORADIC=yes). Messages
+ * posted from an interrupt handler get the interrupt time stamp as both
+ * baseline and deadline, an interrupt storm floods the active list with
+ * the most urgent work in the system. A sporadic server bounds what one
+ * interrupt source may post: at most a capacity of messages per period,
+ * the period starting with the first message after the server was idle.
+ * The excess is queued, released with the baseline of a later period and
+ * its relative deadline kept. Messages that would have to wait more than
+ * a backlog of periods are dropped.
+ *
+ * With a known cost per message the capacity bounds the bandwidth of the
+ * source. The environment marks which server an interrupt handler runs
+ * under with tt_sporadic_enter() and tt_sporadic_leave().
+ */
+
+#ifndef SPORADIC_H_
+#define SPORADIC_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_SPORADIC
+
+#if defined TT_TIMBER
+#	error TT_SPORADIC is not supported with TT_TIMBER.
+#endif
+
+#ifndef ENV_TIME_SUB
+#	error TT_SPORADIC requires ENV_TIME_SUB() from the environment.
+#endif
+
+#ifndef ENV_EXT_INTERRUPT_SPORADIC
+#	error TT_SPORADIC requires ENV_EXT_INTERRUPT_SPORADIC() from the environment.
+#endif
+
+/**
+ * \brief TinyTimber sporadic server.
+ */
+typedef struct tt_sporadic_t
+{
+	/**
+	 * \brief The number of messages per period.
+	 */
+	int capacity;
+
+	/**
+	 * \brief The replenishment period.
+	 */
+	env_time_t period;
+
+	/**
+	 * \brief The number of periods the excess may be queued.
+	 */
+	int backlog;
+
+	/**
+	 * \brief The start of the latest period with messages.
+	 */
+	env_time_t window;
+
+	/**
+	 * \brief The number of messages in the latest period.
+	 */
+	int used;
+
+	/**
+	 * \brief The number of messages released without delay.
+	 */
+	unsigned long accepted;
+
+	/**
+	 * \brief The number of messages queued for a later period.
+	 */
+	unsigned long deferred;
+
+	/**
+	 * \brief The number of messages dropped.
+	 */
+	unsigned long dropped;
+} tt_sporadic_t;
+
+extern tt_sporadic_t *tt_sporadic_current;
+
+void tt_sporadic_init(tt_sporadic_t *, int, env_time_t, int);
+int tt_sporadic_admit(tt_sporadic_t *, env_time_t, env_time_t *, env_time_t *);
+
+/**
+ * \brief TinyTimber sporadic server enter macro.
+ *
+ * Used by the environment before running the handler of an interrupt
+ * source with a server, in protected mode.
+ */
+#define tt_sporadic_enter(server) \
+	do {\
+		tt_sporadic_current = (server);\
+	} while (0)
+
+/**
+ * \brief TinyTimber sporadic server leave macro.
+ */
+#define tt_sporadic_leave() \
+	do {\
+		tt_sporadic_current = NULL;\
+	} while (0)
+
+#endif /* TT_SPORADIC */
+
+#endif
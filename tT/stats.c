@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber timing statistics implementation.
+ *
+ * The hooks run in protected mode only, there is a single writer at any
+ * time and the tables need no lock of their own. Entries are kept in a
+ * pair table (pair.h) until tt_stats_reset().
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <stats.h>
+#	include <pair.h>
+#endif
+
+#if defined TT_STATS || defined TT_HISTOGRAM
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram bucket function.
+ *
+ * \param value The value.
+ * \return The index of the bucket holding value.
+ */
+static ENV_CODE_FAST ENV_INLINE int histogram_bucket(unsigned long value)
+{
+	int exp = 0;
+
+	if (value < (1UL << TT_STATS_SUB_BITS)) {
+		return (int)value;
+	}
+
+	while (value >> (exp + 1)) {
+		exp++;
+	}
+
+	return ((exp - TT_STATS_SUB_BITS + 1) << TT_STATS_SUB_BITS) +
+		(int)((value >> (exp - TT_STATS_SUB_BITS)) &
+			  ((1UL << TT_STATS_SUB_BITS) - 1));
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram bucket upper bound function.
+ *
+ * \param bucket The index of the bucket.
+ * \return The largest value held by the bucket.
+ */
+static unsigned long histogram_upper(int bucket)
+{
+	int exp;
+	unsigned long mantissa;
+
+	if (bucket < (1 << TT_STATS_SUB_BITS)) {
+		return (unsigned long)bucket;
+	}
+
+	exp = (bucket >> TT_STATS_SUB_BITS) + TT_STATS_SUB_BITS - 1;
+	mantissa = (1UL << TT_STATS_SUB_BITS) |
+		(unsigned long)(bucket & ((1 << TT_STATS_SUB_BITS) - 1));
+
+	return ((mantissa + 1) << (exp - TT_STATS_SUB_BITS)) - 1;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram add function.
+ *
+ * \param histogram The histogram.
+ * \param value The value to record.
+ */
+ENV_CODE_FAST void tt_histogram_add(tt_histogram_t *histogram, unsigned long value)
+{
+	if (!histogram->total || value < histogram->min) {
+		histogram->min = value;
+	}
+	if (value > histogram->max) {
+		histogram->max = value;
+	}
+	histogram->total++;
+	histogram->sum += value;
+	histogram->count[histogram_bucket(value)]++;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram reset function.
+ *
+ * \param histogram The histogram.
+ */
+void tt_histogram_reset(tt_histogram_t *histogram)
+{
+	int i;
+
+	histogram->total = 0;
+	histogram->min = 0;
+	histogram->max = 0;
+	histogram->sum = 0;
+	for (i=0;i<TT_STATS_BUCKETS;i++) {
+		histogram->count[i] = 0;
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram percentile function.
+ *
+ * The result is the upper bound of the bucket holding the percentile,
+ * never larger than the largest recorded value.
+ *
+ * \param histogram The histogram.
+ * \param permille The percentile in 1/1000, 500 for the median.
+ * \return The percentile, zero for an empty histogram.
+ */
+unsigned long tt_histogram_percentile(const tt_histogram_t *histogram, int permille)
+{
+	int i;
+	unsigned long rank, sum = 0;
+
+	if (!histogram->total) {
+		return 0;
+	}
+
+	rank = (histogram->total * (unsigned long)permille + 999) / 1000;
+	if (!rank) {
+		return histogram->min;
+	}
+
+	for (i=0;i<TT_STATS_BUCKETS;i++) {
+		sum += histogram->count[i];
+		if (sum >= rank) {
+			break;
+		}
+	}
+
+	if (i == TT_STATS_BUCKETS || histogram_upper(i) > histogram->max) {
+		return histogram->max;
+	}
+	return histogram_upper(i);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber histogram mean function.
+ *
+ * \param histogram The histogram.
+ * \return The mean of the recorded values, zero for an empty histogram.
+ */
+unsigned long tt_histogram_mean(const tt_histogram_t *histogram)
+{
+	if (!histogram->total) {
+		return 0;
+	}
+	return (unsigned long)(histogram->sum / histogram->total);
+}
+
+#endif /* TT_STATS || TT_HISTOGRAM */
+
+#if defined TT_STATS
+
+#ifndef ENV_TIME_DIFF
+#	error TT_STATS requires ENV_TIME_DIFF() from the environment.
+#endif
+
+#if (TT_STATS_ENTRIES & (TT_STATS_ENTRIES - 1))
+#	error TT_STATS_ENTRIES must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/** \cond */
+static tt_stats_t stats_table[TT_STATS_ENTRIES + 1];
+static void *stats_order[TT_STATS_ENTRIES + 1];
+static tt_pair_table_t stats_pairs =
+	TT_PAIR_TABLE(stats_table, stats_order, TT_STATS_ENTRIES);
+
+#define stats_lookup(to, method) \
+	((tt_stats_t *)tt_pair_lookup(&stats_pairs, (to), (method)))
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics dispatch function.
+ *
+ * Use the TT_STATS_DISPATCH() macro instead.
+ *
+ * \param to The object.
+ * \param method The method.
+ * \param baseline The baseline of the message.
+ */
+ENV_CODE_FAST void tt_stats_dispatch(
+		tt_object_t *to,
+		tt_method_t method,
+		env_time_t baseline
+		)
+{
+	long diff;
+	env_time_t now = ENV_TIMER_GET();
+
+	diff = ENV_TIME_DIFF(now, baseline);
+	tt_histogram_add(
+			&stats_lookup(to, method)->jitter,
+			diff > 0 ? (unsigned long)diff : 0
+			);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics completion function.
+ *
+ * Use the TT_STATS_COMPLETE() macro instead.
+ *
+ * \param to The object.
+ * \param method The method.
+ * \param deadline The deadline of the message.
+ */
+ENV_CODE_FAST void tt_stats_complete(
+		tt_object_t *to,
+		tt_method_t method,
+		env_time_t deadline
+		)
+{
+	long diff;
+	tt_stats_t *entry;
+	env_time_t now = ENV_TIMER_GET();
+
+	entry = stats_lookup(to, method);
+	diff = ENV_TIME_DIFF(deadline, now);
+	if (diff >= 0) {
+		tt_histogram_add(&entry->slack, (unsigned long)diff);
+	} else {
+		tt_histogram_add(&entry->lateness, (unsigned long)-diff);
+	}
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics execution function.
+ *
+ * Called by the kernel at completion with the processor time of the
+ * invocation, in protected mode.
+ *
+ * \param to The object.
+ * \param method The method.
+ * \param time The execution time, preemption excluded.
+ */
+ENV_CODE_FAST void tt_stats_execution(
+		tt_object_t *to,
+		tt_method_t method,
+		long time
+		)
+{
+	tt_histogram_add(
+			&stats_lookup(to, method)->execution,
+			time > 0 ? (unsigned long)time : 0
+			);
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics count function.
+ *
+ * \return The number of entries in use, in order of first use.
+ */
+int tt_stats_count(void)
+{
+	return stats_pairs.count;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics get function.
+ *
+ * The entry is updated in place by the kernel, read it in protected mode
+ * or when the kernel is idle.
+ *
+ * \param i The index of the entry, below tt_stats_count().
+ * \return The entry.
+ */
+tt_stats_t *tt_stats_get(int i)
+{
+	return stats_order[i];
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber statistics reset function.
+ *
+ * Must be called in protected mode.
+ */
+void tt_stats_reset(void)
+{
+	int i;
+
+	tt_pair_reset(&stats_pairs);
+	for (i=0;i<=TT_STATS_ENTRIES;i++) {
+		tt_histogram_reset(&stats_table[i].jitter);
+		tt_histogram_reset(&stats_table[i].slack);
+		tt_histogram_reset(&stats_table[i].lateness);
+		tt_histogram_reset(&stats_table[i].execution);
+	}
+}
+
+#endif /* TT_STATS */
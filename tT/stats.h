@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber timing statistics.
+ *
+ * Compiled in when TT_STATS is defined (make STATS=yes), otherwise the
+ * hooks expand to nothing. For every object/method pair the kernel keeps
+ * three fixed size histograms:
+ *
+ *	jitter:		release jitter, dispatch time - baseline.
+ *	slack:		deadline - completion time, for messages done in time.
+ *	lateness:	completion time - deadline, for messages done late.
+ *
+ * If the environment provides ENV_CPU_GET() a fourth histogram holds the
+ * execution time of every invocation, the processor time from dispatch to
+ * completion with the time spent in preempting messages excluded. Its
+ * maximum is the measured WCET of the pair.
+ *
+ * All values are in environment time units (ENV_TIME_DIFF()). The
+ * histograms are log-linear (HDR style), each power of two is split into
+ * 1 << TT_STATS_SUB_BITS buckets giving a relative error below
+ * 1 / (1 << TT_STATS_SUB_BITS) at any magnitude without any allocation.
+ *
+ * The histograms alone are compiled in when TT_HISTOGRAM is defined, for
+ * environment code that measures its own latencies.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+#if defined TT_STATS || defined TT_HISTOGRAM
+
+#ifndef TT_STATS_SUB_BITS
+	/**
+	 * \brief log2 of the number of buckets per power of two.
+	 */
+#	define TT_STATS_SUB_BITS 2
+#endif
+
+/**
+ * \brief The number of buckets in a histogram.
+ */
+#define TT_STATS_BUCKETS \
+	((8*sizeof(unsigned long) - TT_STATS_SUB_BITS + 1) << TT_STATS_SUB_BITS)
+
+/**
+ * \brief TinyTimber histogram.
+ */
+typedef struct tt_histogram_t
+{
+	/**
+	 * \brief The number of recorded values.
+	 */
+	unsigned long total;
+
+	/**
+	 * \brief The smallest recorded value.
+	 */
+	unsigned long min;
+
+	/**
+	 * \brief The largest recorded value.
+	 */
+	unsigned long max;
+
+	/**
+	 * \brief The sum of the recorded values.
+	 */
+	unsigned long long sum;
+
+	/**
+	 * \brief The bucket counters.
+	 */
+	unsigned long count[TT_STATS_BUCKETS];
+} tt_histogram_t;
+
+void tt_histogram_reset(tt_histogram_t *);
+void tt_histogram_add(tt_histogram_t *, unsigned long);
+unsigned long tt_histogram_percentile(const tt_histogram_t *, int);
+unsigned long tt_histogram_mean(const tt_histogram_t *);
+
+#endif /* TT_STATS || TT_HISTOGRAM */
+
+/* ************************************************************************** */
+
+#if defined TT_STATS
+
+#if defined TT_TIMBER
+#	error TT_STATS is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_STATS_ENTRIES
+	/**
+	 * \brief The number of object/method pairs tracked, a power of two.
+	 *
+	 * Pairs that do not fit are accounted to a shared overflow entry with
+	 * a NULL object and method.
+	 */
+#	define TT_STATS_ENTRIES 16
+#endif
+
+/**
+ * \brief TinyTimber statistics entry, one per object/method pair.
+ */
+typedef struct tt_stats_t
+{
+	/**
+	 * \brief The object, NULL for the overflow entry.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method, NULL for the overflow entry.
+	 */
+	tt_method_t method;
+
+	/**
+	 * \brief Release jitter, dispatch time - baseline.
+	 */
+	tt_histogram_t jitter;
+
+	/**
+	 * \brief Slack, deadline - completion time.
+	 */
+	tt_histogram_t slack;
+
+	/**
+	 * \brief Lateness, completion time - deadline.
+	 */
+	tt_histogram_t lateness;
+
+	/**
+	 * \brief Execution time, preemption excluded.
+	 */
+	tt_histogram_t execution;
+} tt_stats_t;
+
+void tt_stats_dispatch(tt_object_t *, tt_method_t, env_time_t);
+void tt_stats_complete(tt_object_t *, tt_method_t, env_time_t);
+void tt_stats_execution(tt_object_t *, tt_method_t, long);
+int tt_stats_count(void);
+tt_stats_t *tt_stats_get(int);
+void tt_stats_reset(void);
+
+/**
+ * \brief TinyTimber statistics dispatch hook.
+ *
+ * Must be used in protected mode.
+ */
+#define TT_STATS_DISPATCH(msg) \
+	tt_stats_dispatch(\
+			TT_MESSAGE_BODY(msg)->to,\
+			TT_MESSAGE_BODY(msg)->method,\
+			(msg)->baseline\
+			)
+
+/**
+ * \brief TinyTimber statistics completion hook.
+ *
+ * Must be used in protected mode.
+ */
+#define TT_STATS_COMPLETE(msg) \
+	tt_stats_complete(\
+			TT_MESSAGE_BODY(msg)->to,\
+			TT_MESSAGE_BODY(msg)->method,\
+			TT_MESSAGE_DEADLINE(msg)\
+			)
+
+#else
+
+/** \cond */
+#	define TT_STATS_DISPATCH(msg)
+#	define TT_STATS_COMPLETE(msg)
+/** \endcond */
+
+#endif /* TT_STATS */
+
+#endif
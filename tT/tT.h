@@ -134,12 +134,26 @@ typedef unsigned char tt_flags_t;
 
 /* ************************************************************************** */
 
+/**
+ * \brief TinyTimber message flags, all of them in one place so that they
+ * never share a bit.
+ */
 enum
 {
 	/**
 	 * \brief Flag to indicate that the message has no deadline.
 	 */
-	TT_MSG_NO_DL = 1
+	TT_MSG_NO_DL = 0x01,
+
+	/**
+	 * \brief Message demoted by the shedding policy, never shed again.
+	 */
+	TT_FLAG_DEMOTED = 0x02,
+
+	/**
+	 * \brief Message released through a constant bandwidth server.
+	 */
+	TT_FLAG_SERVED = 0x04
 };
 
 /* ************************************************************************** */
@@ -311,5 +325,7 @@ void tt_action(
 		);
 int tt_cancel(tt_receipt_t *);
 void tt_schedule(void);
+env_time_t tt_baseline(void);
+env_time_t tt_deadline(void);
 
 #endif
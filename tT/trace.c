@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber kernel event trace implementation.
+ *
+ * Records are written in protected mode only, there is a single writer at
+ * any time and the ring needs no lock of its own. When full the oldest
+ * records are overwritten.
+ *
+ * tt_trace_dump() serializes the ring into a host independent format,
+ * all fields little endian:
+ *
+ *	header:	"TTTR", u32 version, u32 record count, u32 reserved,
+ *		u64 address of tt_trace_dump() (to relocate symbols).
+ *	record:	u64 time (ns), u64 message, u64 object, u64 method,
+ *		u8 event, u8 thread, 6 bytes of padding.
+ */
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <env.h>
+#	include <types.h>
+#	include <trace.h>
+#endif
+
+#if defined TT_TRACE
+
+#ifndef ENV_TRACE_NSEC
+#	error TT_TRACE requires ENV_TRACE_NSEC() from the environment.
+#endif
+
+#if (TT_TRACE_SIZE & (TT_TRACE_SIZE - 1))
+#	error TT_TRACE_SIZE must be a power of two.
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber trace file format version.
+ */
+#define TRACE_VERSION 1
+
+/**
+ * \brief TinyTimber trace enabled flag.
+ */
+volatile int tt_trace_enabled;
+
+/** \cond */
+static tt_trace_record_t trace_ring[TT_TRACE_SIZE];
+static unsigned long trace_head;
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber trace enable function.
+ *
+ * \param enable Non-zero to start recording, zero to stop.
+ */
+void tt_trace_enable(int enable)
+{
+	tt_trace_enabled = enable;
+}
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber trace record function.
+ *
+ * Use the TT_TRACE_EVENT() macro instead.
+ *
+ * \param event The event.
+ * \param thread The kernel thread.
+ * \param msg The message.
+ * \param to The object.
+ * \param method The method.
+ */
+ENV_CODE_FAST void tt_trace_record(
+		int event,
+		int thread,
+		void *msg,
+		tt_object_t *to,
+		tt_method_t method
+		)
+{
+	tt_trace_record_t *record;
+
+	record = &trace_ring[trace_head++ & (TT_TRACE_SIZE - 1)];
+	record->time = ENV_TIMER_GET();
+	record->msg = msg;
+	record->to = to;
+	record->method = method;
+	record->event = event;
+	record->thread = thread;
+}
+
+/* ************************************************************************** */
+
+/** \cond */
+
+/**
+ * \brief TinyTimber trace write a little endian value.
+ */
+static void trace_put(
+		tt_trace_write_t write,
+		void *data,
+		unsigned long long value,
+		int size
+		)
+{
+	int i;
+	unsigned char buf[8];
+
+	for (i=0;i<size;i++) {
+		buf[i] = (unsigned char)(value >> (8*i));
+	}
+	write(buf, size, data);
+}
+
+/** \endcond */
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber trace dump function.
+ *
+ * Serializes the recorded events, oldest first. Recording is stopped
+ * while dumping.
+ *
+ * \param write Called with each chunk of the serialized trace.
+ * \param data User data for write.
+ */
+void tt_trace_dump(tt_trace_write_t write, void *data)
+{
+	int enabled = tt_trace_enabled;
+	unsigned long i, first, count;
+	tt_trace_record_t *record;
+
+	tt_trace_enabled = 0;
+
+	count = trace_head < TT_TRACE_SIZE ? trace_head : TT_TRACE_SIZE;
+	first = trace_head - count;
+
+	write("TTTR", 4, data);
+	trace_put(write, data, TRACE_VERSION, 4);
+	trace_put(write, data, count, 4);
+	trace_put(write, data, 0, 4);
+	trace_put(write, data, (unsigned long long)(size_t)tt_trace_dump, 8);
+
+	for (i=0;i<count;i++) {
+		record = &trace_ring[(first + i) & (TT_TRACE_SIZE - 1)];
+		trace_put(write, data, ENV_TRACE_NSEC(record->time), 8);
+		trace_put(write, data, (unsigned long long)(size_t)record->msg, 8);
+		trace_put(write, data, (unsigned long long)(size_t)record->to, 8);
+		trace_put(write, data, (unsigned long long)(size_t)record->method, 8);
+		trace_put(write, data, record->event, 1);
+		trace_put(write, data, record->thread, 1);
+		trace_put(write, data, 0, 6);
+	}
+
+	tt_trace_enabled = enabled;
+}
+
+#endif /* TT_TRACE */
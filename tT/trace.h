@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief The TinyTimber kernel event trace.
+ *
+ * Compiled in when TT_TRACE is defined (make TRACE=yes), otherwise the trace
+ * points expand to nothing. When compiled in the trace points cost one test
+ * of tt_trace_enabled until tt_trace_enable() is called.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/*
+ * Following files should not be included in case the file is mangled.
+ */
+#if ! defined TT_MANGLED
+#	include <tT.h>
+#	include <types.h>
+#endif
+
+/* ************************************************************************** */
+
+/**
+ * \brief TinyTimber trace events.
+ */
+enum
+{
+	/**
+	 * \brief A message was posted (tt_action()).
+	 */
+	TT_TRACE_ACTION,
+
+	/**
+	 * \brief A message was queued (tt_async()).
+	 */
+	TT_TRACE_ASYNC,
+
+	/**
+	 * \brief A message was released by the timer (tt_expired()).
+	 */
+	TT_TRACE_RELEASE,
+
+	/**
+	 * \brief A thread was activated to run a message (tt_schedule()).
+	 */
+	TT_TRACE_SCHEDULE,
+
+	/**
+	 * \brief A message started to run.
+	 */
+	TT_TRACE_DISPATCH,
+
+	/**
+	 * \brief A message finished running.
+	 */
+	TT_TRACE_COMPLETE,
+
+	/**
+	 * \brief A thread gave up the processor, nothing more to run.
+	 */
+	TT_TRACE_YIELD,
+
+	/**
+	 * \brief A thread blocked on an object owned by another thread.
+	 */
+	TT_TRACE_BLOCK,
+
+	/**
+	 * \brief A message was canceled (tt_cancel()).
+	 */
+	TT_TRACE_CANCEL,
+
+	/**
+	 * \brief The number of trace events.
+	 */
+	TT_TRACE_EVENTS
+};
+
+/* ************************************************************************** */
+
+#if defined TT_TRACE
+
+#if defined TT_TIMBER
+#	error TT_TRACE is not supported with TT_TIMBER.
+#endif
+
+#ifndef TT_TRACE_SIZE
+	/**
+	 * \brief The number of records in the trace ring, a power of two.
+	 */
+#	define TT_TRACE_SIZE 4096
+#endif
+
+/**
+ * \brief TinyTimber trace record.
+ */
+typedef struct tt_trace_record_t
+{
+	/**
+	 * \brief The time of the event.
+	 */
+	env_time_t time;
+
+	/**
+	 * \brief The message, identifies it until it is freed.
+	 */
+	void *msg;
+
+	/**
+	 * \brief The object.
+	 */
+	tt_object_t *to;
+
+	/**
+	 * \brief The method.
+	 */
+	tt_method_t method;
+
+	/**
+	 * \brief The event.
+	 */
+	unsigned char event;
+
+	/**
+	 * \brief The kernel thread, zero for the idle thread (or the stack).
+	 */
+	unsigned char thread;
+} tt_trace_record_t;
+
+/**
+ * \brief TinyTimber trace writer callback.
+ */
+typedef void (*tt_trace_write_t)(const void *, size_t, void *);
+
+extern volatile int tt_trace_enabled;
+
+void tt_trace_enable(int);
+void tt_trace_record(int, int, void *, tt_object_t *, tt_method_t);
+void tt_trace_dump(tt_trace_write_t, void *);
+
+/**
+ * \brief TinyTimber trace point.
+ *
+ * Must be used in protected mode.
+ */
+#define TT_TRACE_EVENT(event, thread, msg, to, method) \
+	do {\
+		if (tt_trace_enabled) {\
+			tt_trace_record(event, thread, msg, to, method);\
+		}\
+	} while (0)
+
+#else
+
+/** \cond */
+#	define TT_TRACE_EVENT(event, thread, msg, to, method)
+/** \endcond */
+
+#endif /* TT_TRACE */
+
+#endif
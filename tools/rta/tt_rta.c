@@ -0,0 +1,853 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * TinyTimber response-time analysis.
+ *
+ * Reads the periodic activity declarations of an application together with
+ * measured execution times, from a statistics dump (make STATS=yes, the
+ * "execution" lines) and/or a kernel trace (make TRACE=yes), and computes:
+ *
+ *	- the EDF processor demand test, dbf(t) + B(t) <= t at every absolute
+ *	  deadline within the synchronous busy period,
+ *	- a response-time bound per activity (Spuri's EDF analysis),
+ *
+ * both with blocking from critical sections: the time an activity spends
+ * in tt_request() on an object shared with others, bounded as under SRP
+ * (an activity is only blocked by one with a longer relative deadline that
+ * holds a resource used by an activity with a deadline no longer than its
+ * own).
+ *
+ *	tt_rta [-s symbols] [-S stats.txt] [-t trace.bin] [-m margin]
+ *		activities.txt
+ *
+ * The activity file holds one activity per line, '#' starts a comment:
+ *
+ *	name method period deadline [wcet=T] [object=O] [cs=T] [resource=R]
+ *
+ * Times take a ns, us, ms or s suffix, nanoseconds without. Methods and
+ * objects are symbol names when the output of nm(1) for the application is
+ * given with -s, addresses (0x...) otherwise. A declared wcet wins over the
+ * measured one, the statistics over the trace. From a trace the time
+ * between two events is charged to the message the thread logging the
+ * later one runs (the innermost on the single SRP stack), in wall clock
+ * time with blocked time included. Thread switches the kernel does not
+ * trace (the constant bandwidth servers) are not seen, prefer the
+ * statistics. The observed response time is measured from the post or
+ * timer release of every message.
+ *
+ * Activities whose bound exceeds the deadline are flagged "miss", those
+ * within the margin (percent of the deadline, default 10) "risk", and
+ * those observed to respond later than the bound "model" (the measured or
+ * declared WCET is too small).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ************************************************************************** */
+
+/* Must match tT/trace.h. */
+enum
+{
+	TT_TRACE_ACTION,
+	TT_TRACE_ASYNC,
+	TT_TRACE_RELEASE,
+	TT_TRACE_SCHEDULE,
+	TT_TRACE_DISPATCH,
+	TT_TRACE_COMPLETE,
+	TT_TRACE_YIELD,
+	TT_TRACE_BLOCK,
+	TT_TRACE_CANCEL,
+	TT_TRACE_EVENTS
+};
+
+#define RECORD_SIZE 40
+#define MSG_SLOTS 8192
+#define STACK_SIZE 1024
+#define MAX_ACTIVITIES 256
+#define MAX_POINTS 1000000
+#define MAX_ITERATIONS 100000
+
+/* ************************************************************************** */
+
+typedef struct symbol_t
+{
+	unsigned long long addr;
+	char *name;
+} symbol_t;
+
+typedef struct activity_t
+{
+	char name[64];
+	char method[128];
+	char object[128];
+	char resource[64];
+	long long period;
+	long long deadline;
+	long long wcet;
+	long long cs;
+	const char *source;
+	long long measured;
+	long long observed;
+	unsigned long count;
+	long long blocking;
+	long long response;
+} activity_t;
+
+static symbol_t *symbols;
+static size_t num_symbols;
+static activity_t activities[MAX_ACTIVITIES];
+static int num_activities;
+
+static struct
+{
+	unsigned long long msg;
+	unsigned long long start;
+	unsigned long long exec;
+} msgs[MSG_SLOTS];
+
+/* ************************************************************************** */
+
+static unsigned long long get(const unsigned char *buf, int size)
+{
+	int i;
+	unsigned long long value = 0;
+
+	for (i=size-1;i>=0;i--) {
+		value = (value << 8) | buf[i];
+	}
+	return value;
+}
+
+/* ************************************************************************** */
+
+static int compare_symbol(const void *v0, const void *v1)
+{
+	const symbol_t *s0 = v0, *s1 = v1;
+	return s0->addr < s1->addr ? -1 : s0->addr > s1->addr;
+}
+
+static void load_symbols(const char *path)
+{
+	FILE *file;
+	char line[1024], name[1024], type;
+	unsigned long long addr;
+	size_t size = 0;
+
+	file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "%llx %c %1023s", &addr, &type, name) != 3) {
+			continue;
+		}
+		if (num_symbols == size) {
+			size = size ? 2*size : 1024;
+			symbols = realloc(symbols, size*sizeof(*symbols));
+			if (!symbols) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		symbols[num_symbols].addr = addr;
+		symbols[num_symbols].name = strdup(name);
+		num_symbols++;
+	}
+	fclose(file);
+
+	qsort(symbols, num_symbols, sizeof(*symbols), compare_symbol);
+}
+
+/*
+ * Position independent executables are loaded anywhere, the slide is the
+ * difference between the runtime address of a known function and nm.
+ */
+static long long symbol_slide(const char *name, unsigned long long anchor)
+{
+	size_t i;
+
+	for (i=0;i<num_symbols;i++) {
+		if (!strcmp(symbols[i].name, name)) {
+			return anchor - symbols[i].addr;
+		}
+	}
+	return 0;
+}
+
+static const char *symbol(unsigned long long addr, long long slide)
+{
+	static char buf[4][64];
+	static int next;
+	size_t lo = 0, hi = num_symbols;
+	char *tmp = buf[next++ & 3];
+
+	addr -= slide;
+	while (lo < hi) {
+		size_t mid = (lo + hi)/2;
+		if (symbols[mid].addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo && symbols[lo-1].addr == addr) {
+		return symbols[lo-1].name;
+	}
+	snprintf(tmp, 64, "0x%llx", addr + slide);
+	return tmp;
+}
+
+/* ************************************************************************** */
+
+static long long parse_time(const char *str, const char *line)
+{
+	char *end;
+	double value = strtod(str, &end);
+
+	if (end == str) {
+		fprintf(stderr, "bad time '%s' in: %s", str, line);
+		exit(1);
+	}
+	if (!strcmp(end, "s")) {
+		value *= 1e9;
+	} else if (!strcmp(end, "ms")) {
+		value *= 1e6;
+	} else if (!strcmp(end, "us")) {
+		value *= 1e3;
+	} else if (*end && strcmp(end, "ns")) {
+		fprintf(stderr, "bad time unit '%s' in: %s", end, line);
+		exit(1);
+	}
+	return (long long)(value + 0.5);
+}
+
+static void load_activities(const char *path)
+{
+	FILE *file;
+	activity_t *a;
+	char line[1024], *tok, *tmp;
+	int field;
+
+	file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		if ((tmp = strchr(line, '#'))) {
+			*tmp = '\0';
+		}
+		if (num_activities == MAX_ACTIVITIES) {
+			fprintf(stderr, "%s: too many activities.\n", path);
+			exit(1);
+		}
+		a = &activities[num_activities];
+		memset(a, 0, sizeof(*a));
+		a->wcet = -1;
+
+		field = 0;
+		tmp = strdup(line);
+		for (tok=strtok(tmp, " \t\r\n");tok;tok=strtok(NULL, " \t\r\n")) {
+			switch (field++) {
+				case 0:
+					snprintf(a->name, sizeof(a->name), "%s", tok);
+					break;
+				case 1:
+					snprintf(a->method, sizeof(a->method), "%s", tok);
+					break;
+				case 2:
+					a->period = parse_time(tok, line);
+					break;
+				case 3:
+					a->deadline = parse_time(tok, line);
+					break;
+				default:
+					if (!strncmp(tok, "wcet=", 5)) {
+						a->wcet = parse_time(tok + 5, line);
+					} else if (!strncmp(tok, "cs=", 3)) {
+						a->cs = parse_time(tok + 3, line);
+					} else if (!strncmp(tok, "object=", 7)) {
+						snprintf(a->object, sizeof(a->object), "%s", tok + 7);
+					} else if (!strncmp(tok, "resource=", 9)) {
+						snprintf(a->resource, sizeof(a->resource), "%s", tok + 9);
+					} else {
+						fprintf(stderr, "bad key '%s' in: %s", tok, line);
+						exit(1);
+					}
+					break;
+			}
+		}
+		free(tmp);
+
+		if (!field) {
+			continue;
+		}
+		if (field < 4 || a->period <= 0 || a->deadline <= 0) {
+			fprintf(stderr, "bad activity: %s", line);
+			exit(1);
+		}
+		if (a->wcet >= 0) {
+			a->source = "declared";
+		}
+		num_activities++;
+	}
+	fclose(file);
+}
+
+/* ************************************************************************** */
+
+/*
+ * Account a measured execution time of an object/method pair to the
+ * activities declared for it.
+ */
+static void account(
+		const char *to,
+		const char *method,
+		long long exec,
+		long long response,
+		const char *source
+		)
+{
+	int i;
+	activity_t *a;
+
+	for (i=0;i<num_activities;i++) {
+		a = &activities[i];
+		if (strcmp(a->method, method)) {
+			continue;
+		}
+		if (a->object[0] && strcmp(a->object, to)) {
+			continue;
+		}
+		if (exec > a->measured && (!a->source || a->source == source)) {
+			a->measured = exec;
+			a->source = source;
+		}
+		if (response > a->observed) {
+			a->observed = response;
+		}
+		if (response >= 0) {
+			a->count++;
+		}
+	}
+}
+
+/* ************************************************************************** */
+
+static void load_stats(const char *path)
+{
+	FILE *file;
+	char line[1024];
+	unsigned long long anchor, to, method;
+	unsigned long max;
+	long long slide = 0;
+	char *tmp;
+
+	file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "anchor=%llx", &anchor) == 1) {
+			slide = symbol_slide("tt_stats_get", anchor);
+			continue;
+		}
+		if (
+			!strstr(line, " execution ") ||
+			sscanf(line, "object=%llx method=%llx", &to, &method) != 2 ||
+			!(tmp = strstr(line, " max=")) ||
+			sscanf(tmp, " max=%lu", &max) != 1
+			) {
+			continue;
+		}
+		account(
+				symbol(to, slide),
+				symbol(method, slide),
+				(long long)max,
+				-1,
+				"stats"
+				);
+	}
+	fclose(file);
+}
+
+/* ************************************************************************** */
+
+static unsigned long msg_slot(unsigned long long msg)
+{
+	unsigned long i = (msg >> 3) % MSG_SLOTS;
+
+	while (msgs[i].msg && msgs[i].msg != msg) {
+		i = (i + 1) % MSG_SLOTS;
+	}
+	return i;
+}
+
+static void load_trace(const char *path)
+{
+	FILE *file;
+	unsigned char header[24], buf[RECORD_SIZE];
+	unsigned long i, j, count, slot;
+	unsigned long long time, prev = 0, msg, to, method, anchor;
+	unsigned long long stack[STACK_SIZE];
+	int event, thread, threads[STACK_SIZE], depth = 0;
+	long long slide;
+
+	file = fopen(path, "rb");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+	if (
+		fread(header, sizeof(header), 1, file) != 1 ||
+		memcmp(header, "TTTR", 4) ||
+		get(&header[4], 4) != 1
+		) {
+		fprintf(stderr, "%s: not a TinyTimber trace.\n", path);
+		exit(1);
+	}
+	count = get(&header[8], 4);
+	anchor = get(&header[16], 8);
+	slide = symbol_slide("tt_trace_dump", anchor);
+
+	for (i=0;i<count;i++) {
+		if (fread(buf, sizeof(buf), 1, file) != 1) {
+			fprintf(stderr, "%s: truncated trace.\n", path);
+			break;
+		}
+		time = get(&buf[0], 8);
+		msg = get(&buf[8], 8);
+		to = get(&buf[16], 8);
+		method = get(&buf[24], 8);
+		event = buf[32];
+		thread = buf[33];
+
+		/*
+		 * The thread logging an event was running since the previous
+		 * one, charge the message on top of its part of the stack.
+		 */
+		for (j=depth;j>0 && prev;j--) {
+			if (threads[j-1] == thread) {
+				msgs[msg_slot(stack[j-1])].exec += time - prev;
+				break;
+			}
+		}
+		prev = time;
+
+		switch (event) {
+			case TT_TRACE_ACTION:
+				slot = msg_slot(msg);
+				msgs[slot].msg = msg;
+				msgs[slot].start = time;
+				msgs[slot].exec = 0;
+				break;
+
+			case TT_TRACE_RELEASE:
+				slot = msg_slot(msg);
+				if (msgs[slot].msg) {
+					msgs[slot].start = time;
+				}
+				break;
+
+			case TT_TRACE_DISPATCH:
+				if (depth == STACK_SIZE) {
+					fprintf(stderr, "%s: running stack overflow.\n", path);
+					exit(1);
+				}
+				threads[depth] = thread;
+				stack[depth++] = msg;
+				break;
+
+			case TT_TRACE_COMPLETE:
+				for (j=depth;j>0;j--) {
+					if (stack[j-1] == msg) {
+						break;
+					}
+				}
+				if (!j) {
+					/* Dispatched before the start of the ring. */
+					break;
+				}
+				for (;j<depth;j++) {
+					threads[j-1] = threads[j];
+					stack[j-1] = stack[j];
+				}
+				depth--;
+
+				slot = msg_slot(msg);
+				if (msgs[slot].msg) {
+					account(
+							symbol(to, slide),
+							symbol(method, slide),
+							msgs[slot].exec,
+							time - msgs[slot].start,
+							"trace"
+							);
+					msgs[slot].msg = 0;
+				}
+				break;
+
+			case TT_TRACE_CANCEL:
+				msgs[msg_slot(msg)].msg = 0;
+				break;
+
+			default:
+				break;
+		}
+	}
+	fclose(file);
+}
+
+/* ************************************************************************** */
+
+/*
+ * Blocking of a deadline-t job, the longest critical section of an activity
+ * with a longer relative deadline on a resource with a ceiling of t or less.
+ * The ceiling of a resource is the shortest deadline of its users, a
+ * critical section without a named resource is assumed to be shared with
+ * every activity.
+ */
+static long long blocking(long long t)
+{
+	int i, j;
+	long long ceiling, result = 0;
+
+	for (i=0;i<num_activities;i++) {
+		if (!activities[i].cs || activities[i].deadline <= t) {
+			continue;
+		}
+		ceiling = -1;
+		for (j=0;j<num_activities;j++) {
+			if (
+				j != i &&
+				(
+					!activities[i].resource[0] ||
+					!activities[j].resource[0] ||
+					!strcmp(activities[i].resource, activities[j].resource)
+				) &&
+				(ceiling < 0 || activities[j].deadline < ceiling)
+				) {
+				ceiling = activities[j].deadline;
+			}
+		}
+		if (ceiling >= 0 && ceiling <= t && activities[i].cs > result) {
+			result = activities[i].cs;
+		}
+	}
+	return result;
+}
+
+/* ************************************************************************** */
+
+static long long demand(long long t)
+{
+	int i;
+	long long result = 0;
+	activity_t *a;
+
+	for (i=0;i<num_activities;i++) {
+		a = &activities[i];
+		if (a->deadline <= t) {
+			result += ((t - a->deadline)/a->period + 1)*a->wcet;
+		}
+	}
+	return result;
+}
+
+/* ************************************************************************** */
+
+static long long busy_period(void)
+{
+	int i, n;
+	long long busy = 0, next;
+
+	for (i=0;i<num_activities;i++) {
+		busy += activities[i].wcet;
+	}
+	for (n=0;n<MAX_ITERATIONS;n++) {
+		next = 0;
+		for (i=0;i<num_activities;i++) {
+			next += ((busy + activities[i].period - 1)/activities[i].period)*
+				activities[i].wcet;
+		}
+		if (next == busy) {
+			return busy;
+		}
+		busy = next;
+	}
+	return -1;
+}
+
+/* ************************************************************************** */
+
+/*
+ * The processor demand test, every absolute deadline within the busy period.
+ *
+ * Returns the first failing deadline, -1 if none, -2 if the test gave up.
+ */
+static long long demand_test(long long busy)
+{
+	int i;
+	long n = 0;
+	long long t, next;
+	activity_t *a;
+
+	for (t=0;;t=next) {
+		/* The next absolute deadline after t. */
+		next = -1;
+		for (i=0;i<num_activities;i++) {
+			a = &activities[i];
+			if (a->deadline > t) {
+				if (next < 0 || a->deadline < next) {
+					next = a->deadline;
+				}
+			} else {
+				long long d = a->deadline +
+					((t - a->deadline)/a->period + 1)*a->period;
+				if (next < 0 || d < next) {
+					next = d;
+				}
+			}
+		}
+		if (next < 0 || next > busy) {
+			return -1;
+		}
+		if (++n > MAX_POINTS) {
+			return -2;
+		}
+		if (demand(next) + blocking(next) > next) {
+			return next;
+		}
+	}
+}
+
+/* ************************************************************************** */
+
+/*
+ * Spuri's EDF response time of activity i: the longest deadline-i busy
+ * period ending with a job of i released at a, over every release offset a
+ * that can be the latest in the busy period.
+ */
+static long long response(int i, long long busy)
+{
+	int j, n;
+	long n_points = 0;
+	long long a, next, worst = 0, w, t, jobs, d;
+	activity_t *ai = &activities[i], *aj;
+
+	for (a=0;a<=busy;a=next) {
+		/* Busy period of a job of i released at a. */
+		d = a + ai->deadline;
+		t = ai->wcet;
+		for (n=0;;n++) {
+			if (n == MAX_ITERATIONS) {
+				return -1;
+			}
+			w = (1 + a/ai->period)*ai->wcet + blocking(d);
+			for (j=0;j<num_activities;j++) {
+				aj = &activities[j];
+				if (j == i || aj->deadline > d) {
+					continue;
+				}
+				jobs = (t + aj->period - 1)/aj->period;
+				if (jobs > 1 + (d - aj->deadline)/aj->period) {
+					jobs = 1 + (d - aj->deadline)/aj->period;
+				}
+				w += jobs*aj->wcet;
+			}
+			if (w <= t) {
+				break;
+			}
+			t = w;
+		}
+		if (t - a > worst) {
+			worst = t - a;
+		}
+
+		/*
+		 * The next offset, a release of i or a point where the absolute
+		 * deadline of i meets that of another activity.
+		 */
+		next = (a/ai->period + 1)*ai->period;
+		for (j=0;j<num_activities;j++) {
+			aj = &activities[j];
+			if (j == i) {
+				continue;
+			}
+			d = aj->deadline - ai->deadline;
+			if (d <= a) {
+				d += ((a - d)/aj->period + 1)*aj->period;
+			}
+			if (d < next) {
+				next = d;
+			}
+		}
+		if (++n_points > MAX_POINTS) {
+			return -1;
+		}
+	}
+
+	return worst > ai->wcet ? worst : ai->wcet;
+}
+
+/* ************************************************************************** */
+
+static void usage(const char *name)
+{
+	fprintf(
+			stderr,
+			"usage: %s [-s symbols] [-S stats.txt] [-t trace.bin] [-m margin]"
+			" activities.txt\n",
+			name
+			);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	int c, i, margin = 10, risk = 0;
+	const char *syms = NULL, *stats = NULL, *trace = NULL, *status;
+	long long busy, fail, load = 0;
+	activity_t *a;
+
+	while ((c = getopt(argc, argv, "s:S:t:m:")) != -1) {
+		switch (c) {
+			case 's':
+				syms = optarg;
+				break;
+			case 'S':
+				stats = optarg;
+				break;
+			case 't':
+				trace = optarg;
+				break;
+			case 'm':
+				margin = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+	}
+
+	if (syms) {
+		load_symbols(syms);
+	}
+	load_activities(argv[optind]);
+	if (stats) {
+		load_stats(stats);
+	}
+	if (trace) {
+		load_trace(trace);
+	}
+
+	for (i=0;i<num_activities;i++) {
+		a = &activities[i];
+		if (a->wcet < 0) {
+			if (!a->source) {
+				fprintf(
+						stderr,
+						"%s: no wcet declared or measured for %s.\n",
+						argv[0],
+						a->name
+						);
+				return 1;
+			}
+			a->wcet = a->measured;
+		}
+		load += a->wcet*1000000/a->period;
+	}
+
+	busy = busy_period();
+	if (load > 1000000) {
+		/* Above full utilization the demand grows without bound. */
+		fail = -3;
+	} else {
+		fail = busy < 0 ? -2 : demand_test(busy);
+	}
+	printf(
+			"utilization=%.3f busy=%lld demand=%s",
+			load/1e6,
+			busy,
+			fail == -1 ? "ok" : fail == -2 ? "unknown" : "fail"
+			);
+	if (fail >= 0) {
+		printf(" at=%lld", fail);
+	}
+	printf("\n");
+
+	for (i=0;i<num_activities;i++) {
+		a = &activities[i];
+		a->blocking = blocking(a->deadline);
+		a->response = busy < 0 ? -1 : response(i, busy);
+
+		if (a->response < 0 || a->response > a->deadline) {
+			status = "miss";
+		} else if (a->observed > a->response) {
+			status = "model";
+		} else if (a->response*100 > a->deadline*(100 - margin)) {
+			status = "risk";
+		} else {
+			status = "ok";
+		}
+		if (strcmp(status, "ok")) {
+			risk++;
+		}
+
+		printf(
+				"activity=%s period=%lld deadline=%lld wcet=%lld source=%s"
+				" blocking=%lld response=%lld observed=%lld count=%lu"
+				" status=%s\n",
+				a->name,
+				a->period,
+				a->deadline,
+				a->wcet,
+				a->source,
+				a->blocking,
+				a->response,
+				a->observed,
+				a->count,
+				status
+				);
+	}
+
+	return risk || fail != -1 ? 2 : 0;
+}
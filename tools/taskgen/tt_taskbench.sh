@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# Runs generated task sets on several environments and prints one line per
+# run (see examples/taskset): miss ratio, lateness and throughput versus
+# utilization.
+#
+#	tt_taskbench.sh [-e envs] [-u utilizations] [-s seeds] [-d ms]
+#		[-- tt_taskgen options]
+#
+# Environments are posix, posix_srp, sim and sim_srp (default all but
+# sim_srp), utilizations default to "0.5 0.6 0.7 0.8 0.9 1.0 1.1", seeds to
+# "1" and the duration of every run to 2000 ms.
+
+usage()
+{
+	echo "tt_taskbench.sh [-e envs] [-u utilizations] [-s seeds] [-d ms]" \
+		"[-- tt_taskgen options]" > /dev/stderr
+	exit 1
+}
+
+ENVS="posix posix_srp sim"
+UTILS="0.5 0.6 0.7 0.8 0.9 1.0 1.1"
+SEEDS="1"
+DURATION=2000
+
+while test $# -gt 0
+do
+	case $1 in
+		-e) ENVS=$2; shift 2 ;;
+		-u) UTILS=$2; shift 2 ;;
+		-s) SEEDS=$2; shift 2 ;;
+		-d) DURATION=$2; shift 2 ;;
+		--) shift; break ;;
+		*) usage ;;
+	esac
+done
+
+ROOT=`cd \`dirname $0\`/../.. && pwd`
+WORK=`mktemp -d`
+trap "rm -rf $WORK" EXIT
+
+make -s -C $ROOT/tools/taskgen || exit 1
+
+for u in $UTILS
+do
+	for s in $SEEDS
+	do
+		DIR=$WORK/$u-$s
+		mkdir -p $DIR
+		$ROOT/tools/taskgen/tt_taskgen -u $u -s $s "$@" > $DIR/taskset.h \
+			|| exit 1
+
+		for e in $ENVS
+		do
+			case $e in
+				sim_srp) MAKE_ENV="ENV=sim SRP=yes" ;;
+				*) MAKE_ENV="ENV=$e" ;;
+			esac
+
+			make -s -C $ROOT/examples/taskset $MAKE_ENV \
+				TASKSET=$DIR BUILD_ROOT=$DIR/$e > $DIR/$e.log 2>&1 \
+				|| { cat $DIR/$e.log > /dev/stderr; exit 1; }
+
+			echo "seed=$s `TASKSET_DURATION=$DURATION $DIR/$e/app.elf`"
+		done
+	done
+done
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * TinyTimber task set generator.
+ *
+ * Writes a random task set as a C header for the taskset example
+ * (examples/taskset), on stdout:
+ *
+ *	tt_taskgen [-n tasks] [-u utilization] [-s seed] [-p min:max]
+ *		[-d min:max] [-S sporadic] [-o objects] [-c cs]
+ *
+ *	-n	number of tasks (default 8, at most MAX_TASKS)
+ *	-u	total utilization, split with UUniFast (default 0.7)
+ *	-s	seed of the generator (default 1)
+ *	-p	period range in milliseconds, log-uniform (default 10:100)
+ *	-d	deadline to period ratio range, uniform (default 1:1)
+ *	-S	fraction of sporadic tasks (default 0), released at least a
+ *		period apart
+ *	-o	number of shared objects (default 0, at most MAX_OBJECTS),
+ *		every task uses one of them
+ *	-c	fraction of the execution time spent in the shared object
+ *		(default 0.1)
+ *
+ * The header holds X-macros, all times in microseconds:
+ *
+ *	TASKSET_TASK(id, period, deadline, wcet, sporadic, shared, cs)
+ *	TASKSET_OBJECT(id)
+ *
+ * where shared is -1 for a task that uses no shared object. The same seed
+ * gives the same task set everywhere.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+/* ************************************************************************** */
+
+/* An SRP object id is a bit in an int, keep room for the reporter. */
+#define MAX_TASKS 24
+#define MAX_OBJECTS 4
+
+/* ************************************************************************** */
+
+typedef struct task_t
+{
+	double utilization;
+	long period;
+	long deadline;
+	long wcet;
+	int sporadic;
+	int shared;
+	long cs;
+} task_t;
+
+static task_t tasks[MAX_TASKS];
+static unsigned long long seed = 1;
+
+/* ************************************************************************** */
+
+/* Uniform in [0, 1), xorshift64* so that sets do not depend on the libc. */
+static double uniform(void)
+{
+	seed ^= seed >> 12;
+	seed ^= seed << 25;
+	seed ^= seed >> 27;
+	return ((seed*2685821657736338717ULL) >> 11)*(1.0/9007199254740992.0);
+}
+
+/* ************************************************************************** */
+
+/*
+ * UUniFast (Bini and Buttazzo): utilizations uniformly distributed over
+ * the simplex that sums to the total.
+ */
+static void uunifast(int n, double total)
+{
+	int i;
+	double sum = total, next;
+
+	for (i=0;i<n-1;i++) {
+		next = sum*pow(uniform(), 1.0/(n - i - 1));
+		tasks[i].utilization = sum - next;
+		sum = next;
+	}
+	tasks[n-1].utilization = sum;
+}
+
+/* ************************************************************************** */
+
+static int range(const char *arg, double *min, double *max)
+{
+	char *end;
+
+	*min = strtod(arg, &end);
+	if (*end == ':') {
+		*max = strtod(end + 1, &end);
+	} else {
+		*max = *min;
+	}
+	return *end == '\0' && *min > 0 && *min <= *max;
+}
+
+/* ************************************************************************** */
+
+static void usage(const char *name)
+{
+	fprintf(
+			stderr,
+			"usage: %s [-n tasks] [-u utilization] [-s seed] [-p min:max]"
+			" [-d min:max] [-S sporadic] [-o objects] [-c cs]\n",
+			name
+			);
+	exit(1);
+}
+
+/* ************************************************************************** */
+
+int main(int argc, char **argv)
+{
+	int c, i, n = 8, objects = 0;
+	double u = 0.7, pmin = 10, pmax = 100, dmin = 1, dmax = 1;
+	double sporadic = 0, cs = 0.1;
+	unsigned long s = 1;
+
+	while ((c = getopt(argc, argv, "n:u:s:p:d:S:o:c:")) != -1) {
+		switch (c) {
+			case 'n':
+				n = atoi(optarg);
+				break;
+			case 'u':
+				u = strtod(optarg, NULL);
+				break;
+			case 's':
+				s = strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				if (!range(optarg, &pmin, &pmax)) {
+					usage(argv[0]);
+				}
+				break;
+			case 'd':
+				if (!range(optarg, &dmin, &dmax)) {
+					usage(argv[0]);
+				}
+				break;
+			case 'S':
+				sporadic = strtod(optarg, NULL);
+				break;
+			case 'o':
+				objects = atoi(optarg);
+				break;
+			case 'c':
+				cs = strtod(optarg, NULL);
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (
+		optind != argc ||
+		n < 1 || n > MAX_TASKS ||
+		objects < 0 || objects > MAX_OBJECTS ||
+		u <= 0 || cs < 0 || cs > 1
+		) {
+		usage(argv[0]);
+	}
+
+	/* Never a zero state, and distinct sets for small seeds. */
+	seed = 0x9e3779b97f4a7c15ULL*(s + 1);
+
+	uunifast(n, u);
+	for (i=0;i<n;i++) {
+		tasks[i].period = (long)(
+				exp(log(pmin) + uniform()*(log(pmax) - log(pmin)))*1000
+				);
+		tasks[i].deadline = (long)(
+				tasks[i].period*(dmin + uniform()*(dmax - dmin))
+				);
+		tasks[i].wcet = (long)(tasks[i].period*tasks[i].utilization);
+		if (tasks[i].wcet < 1) {
+			tasks[i].wcet = 1;
+		}
+		tasks[i].sporadic = uniform() < sporadic;
+		tasks[i].shared = objects ? (int)(uniform()*objects) : -1;
+		tasks[i].cs = objects ? (long)(tasks[i].wcet*cs) : 0;
+	}
+
+	printf("/*\n * Generated by tt_taskgen, do not edit:\n *\n *\t");
+	for (i=0;i<argc;i++) {
+		printf("%s%s", i ? " " : "", argv[i]);
+	}
+	printf("\n */\n\n#ifndef TASKSET_H_\n#define TASKSET_H_\n\n");
+	printf("#define TASKSET_NUM_TASKS %d\n", n);
+	printf("#define TASKSET_NUM_SHARED %d\n", objects);
+	printf("#define TASKSET_UTILIZATION %ld\n\n", (long)(u*1000 + 0.5));
+	printf(
+			"/* TASKSET_TASK(id, period, deadline, wcet, sporadic, shared,"
+			" cs), us. */\n"
+			);
+	printf("#define TASKSET_TASKS \\\n");
+	for (i=0;i<n;i++) {
+		printf(
+				"\tTASKSET_TASK(%d, %ld, %ld, %ld, %d, %d, %ld)%s\n",
+				i,
+				tasks[i].period,
+				tasks[i].deadline,
+				tasks[i].wcet,
+				tasks[i].sporadic,
+				tasks[i].shared,
+				tasks[i].cs,
+				i < n - 1 ? " \\" : ""
+				);
+	}
+	printf("\n#define TASKSET_SHARED");
+	for (i=0;i<objects;i++) {
+		printf(" \\\n\tTASKSET_OBJECT(%d)", i);
+	}
+	printf("\n\n#endif\n");
+	return 0;
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2007, Per Lindgren, Johan Eriksson, Johan Nordlander,
+ * Simon Aittamaa.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Luleå University of Technology nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * TinyTimber trace converter.
+ *
+ * Converts a trace dumped by tt_trace_dump() into Chrome trace event JSON,
+ * which chrome://tracing and https://ui.perfetto.dev open directly.
+ *
+ *	tt_trace [-s symbols] trace.bin > trace.json
+ *
+ * The optional symbols file is the output of nm(1) for the application,
+ * methods and objects are then shown by name instead of by address.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ************************************************************************** */
+
+/* Must match tT/trace.h. */
+enum
+{
+	TT_TRACE_ACTION,
+	TT_TRACE_ASYNC,
+	TT_TRACE_RELEASE,
+	TT_TRACE_SCHEDULE,
+	TT_TRACE_DISPATCH,
+	TT_TRACE_COMPLETE,
+	TT_TRACE_YIELD,
+	TT_TRACE_BLOCK,
+	TT_TRACE_CANCEL,
+	TT_TRACE_EVENTS
+};
+
+#define RECORD_SIZE 40
+#define FLOW_SLOTS 8192
+
+/* ************************************************************************** */
+
+typedef struct record_t
+{
+	unsigned long long time;
+	unsigned long long msg;
+	unsigned long long to;
+	unsigned long long method;
+	int event;
+	int thread;
+} record_t;
+
+typedef struct symbol_t
+{
+	unsigned long long addr;
+	char *name;
+} symbol_t;
+
+static symbol_t *symbols;
+static size_t num_symbols;
+static long long slide;
+
+static struct
+{
+	unsigned long long msg;
+	unsigned long id;
+} flows[FLOW_SLOTS];
+static unsigned long flow_next = 1;
+
+/* ************************************************************************** */
+
+static unsigned long long get(const unsigned char *buf, int size)
+{
+	int i;
+	unsigned long long value = 0;
+
+	for (i=size-1;i>=0;i--) {
+		value = (value << 8) | buf[i];
+	}
+	return value;
+}
+
+/* ************************************************************************** */
+
+static int compare_symbol(const void *v0, const void *v1)
+{
+	const symbol_t *s0 = v0, *s1 = v1;
+	return s0->addr < s1->addr ? -1 : s0->addr > s1->addr;
+}
+
+static void load_symbols(const char *path, unsigned long long anchor)
+{
+	FILE *file;
+	char line[1024], name[1024], type;
+	unsigned long long addr;
+	size_t size = 0;
+
+	file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		if (sscanf(line, "%llx %c %1023s", &addr, &type, name) != 3) {
+			continue;
+		}
+		if (num_symbols == size) {
+			size = size ? 2*size : 1024;
+			symbols = realloc(symbols, size*sizeof(*symbols));
+			if (!symbols) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		symbols[num_symbols].addr = addr;
+		symbols[num_symbols].name = strdup(name);
+		num_symbols++;
+
+		/* Position independent executables are loaded anywhere. */
+		if (!strcmp(name, "tt_trace_dump")) {
+			slide = anchor - addr;
+		}
+	}
+	fclose(file);
+
+	qsort(symbols, num_symbols, sizeof(*symbols), compare_symbol);
+}
+
+static const char *symbol(unsigned long long addr)
+{
+	static char buf[4][64];
+	static int next;
+	size_t lo = 0, hi = num_symbols;
+	char *tmp = buf[next++ & 3];
+
+	if (!addr) {
+		return "none";
+	}
+
+	addr -= slide;
+	while (lo < hi) {
+		size_t mid = (lo + hi)/2;
+		if (symbols[mid].addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo && symbols[lo-1].addr == addr) {
+		return symbols[lo-1].name;
+	}
+	if (lo) {
+		snprintf(tmp, 64, "%s+0x%llx", symbols[lo-1].name, addr - symbols[lo-1].addr);
+		return tmp;
+	}
+	snprintf(tmp, 64, "0x%llx", addr + slide);
+	return tmp;
+}
+
+/* ************************************************************************** */
+
+static unsigned long flow_slot(unsigned long long msg)
+{
+	unsigned long i = (msg >> 3) % FLOW_SLOTS;
+
+	while (flows[i].msg && flows[i].msg != msg) {
+		i = (i + 1) % FLOW_SLOTS;
+	}
+	return i;
+}
+
+/* ************************************************************************** */
+
+static const char *event_name[TT_TRACE_EVENTS] = {
+	"action",
+	"async",
+	"release",
+	"schedule",
+	"dispatch",
+	"complete",
+	"yield",
+	"block",
+	"cancel"
+};
+
+static void emit(const record_t *r, unsigned long long base, int *first)
+{
+	unsigned long i;
+	double ts = (r->time - base)/1000.0;
+
+	if (r->event >= TT_TRACE_EVENTS) {
+		return;
+	}
+
+	printf("%s\n", *first ? "" : ",");
+	*first = 0;
+
+	switch (r->event) {
+		case TT_TRACE_DISPATCH:
+			printf(
+					"{\"name\":\"%s\",\"cat\":\"message\",\"ph\":\"B\","
+					"\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+					"\"args\":{\"object\":\"%s\",\"msg\":\"0x%llx\"}}",
+					symbol(r->method), ts, r->thread, symbol(r->to), r->msg
+					);
+			i = flow_slot(r->msg);
+			if (flows[i].msg) {
+				printf(
+						",\n{\"name\":\"post\",\"cat\":\"flow\",\"ph\":\"f\","
+						"\"bp\":\"e\",\"id\":%lu,\"ts\":%.3f,\"pid\":1,"
+						"\"tid\":%d}",
+						flows[i].id, ts, r->thread
+						);
+				flows[i].msg = 0;
+			}
+			break;
+
+		case TT_TRACE_COMPLETE:
+			printf(
+					"{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+					ts, r->thread
+					);
+			break;
+
+		case TT_TRACE_ACTION:
+			/* A new life for this message, start a flow to its dispatch. */
+			i = flow_slot(r->msg);
+			flows[i].msg = r->msg;
+			flows[i].id = flow_next++;
+			printf(
+					"{\"name\":\"%s\",\"cat\":\"action\",\"ph\":\"i\",\"s\":\"t\","
+					"\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+					"\"args\":{\"object\":\"%s\",\"msg\":\"0x%llx\"}},\n"
+					"{\"name\":\"post\",\"cat\":\"flow\",\"ph\":\"s\",\"id\":%lu,"
+					"\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+					symbol(r->method), ts, r->thread, symbol(r->to), r->msg,
+					flows[i].id, ts, r->thread
+					);
+			break;
+
+		case TT_TRACE_CANCEL:
+			i = flow_slot(r->msg);
+			flows[i].msg = 0;
+			/* Fall through. */
+
+		default:
+			printf(
+					"{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+					"\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+					"\"args\":{\"method\":\"%s\",\"object\":\"%s\","
+					"\"msg\":\"0x%llx\"}}",
+					event_name[r->event], event_name[r->event], ts, r->thread,
+					symbol(r->method), symbol(r->to), r->msg
+					);
+			break;
+	}
+}
+
+/* ************************************************************************** */
+
+int main(int argc, char **argv)
+{
+	int c, first = 1, threads = 0;
+	FILE *file;
+	unsigned long i, count;
+	unsigned long long anchor, base = 0;
+	unsigned char header[24], buf[RECORD_SIZE];
+	const char *syms = NULL;
+	record_t r;
+
+	while ((c = getopt(argc, argv, "s:")) != -1) {
+		switch (c) {
+			case 's':
+				syms = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-s symbols] trace.bin\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-s symbols] trace.bin\n", argv[0]);
+		return 1;
+	}
+
+	file = fopen(argv[optind], "rb");
+	if (!file) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (
+		fread(header, sizeof(header), 1, file) != 1 ||
+		memcmp(header, "TTTR", 4) ||
+		get(&header[4], 4) != 1
+		) {
+		fprintf(stderr, "%s: not a TinyTimber trace.\n", argv[optind]);
+		return 1;
+	}
+	count = get(&header[8], 4);
+	anchor = get(&header[16], 8);
+
+	if (syms) {
+		load_symbols(syms, anchor);
+	}
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (i=0;i<count;i++) {
+		if (fread(buf, sizeof(buf), 1, file) != 1) {
+			fprintf(stderr, "%s: truncated trace.\n", argv[optind]);
+			break;
+		}
+		r.time = get(&buf[0], 8);
+		r.msg = get(&buf[8], 8);
+		r.to = get(&buf[16], 8);
+		r.method = get(&buf[24], 8);
+		r.event = buf[32];
+		r.thread = buf[33];
+
+		if (!i) {
+			base = r.time;
+		}
+		if (r.thread >= threads) {
+			threads = r.thread + 1;
+		}
+		emit(&r, base, &first);
+	}
+	fclose(file);
+
+	for (c=0;c<threads;c++) {
+		printf(
+				"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s %d\"}}",
+				first ? "" : ",", c, c ? "thread" : "idle/stack", c
+				);
+		first = 0;
+	}
+	printf("\n]}\n");
+
+	return 0;
+}